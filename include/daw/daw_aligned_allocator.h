@@ -0,0 +1,160 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+#if defined( __linux__ )
+#include <sys/mman.h>
+#endif
+
+#include "daw_exception.h"
+
+namespace daw {
+	inline constexpr size_t const huge_page_size = 2U * 1024U * 1024U;
+
+	namespace aligned_allocator_impl {
+		constexpr bool is_power_of_2( size_t n ) noexcept {
+			return n != 0 and ( n & ( n - 1 ) ) == 0;
+		}
+
+		inline size_t byte_count( size_t count, size_t size ) {
+			daw::exception::precondition_check<std::bad_array_new_length>(
+			  size == 0 or count <= std::numeric_limits<size_t>::max( ) / size );
+			return count * size;
+		}
+
+		constexpr size_t round_up( size_t n, size_t multiple ) noexcept {
+			return ( n + ( multiple - 1 ) ) & ~( multiple - 1 );
+		}
+	} // namespace aligned_allocator_impl
+
+	// Allocator whose memory starts on an Alignment boundary, e.g. 64 for cache
+	// lines.  Alignment is raised to alignof( T ) when T needs more
+	template<typename T, size_t Alignment>
+	class aligned_allocator {
+		static_assert( aligned_allocator_impl::is_power_of_2( Alignment ),
+		               "Alignment must be a power of 2" );
+
+	public:
+		using value_type = T;
+
+		static constexpr size_t const alignment =
+		  Alignment > alignof( T ) ? Alignment : alignof( T );
+
+		template<typename U>
+		struct rebind {
+			using other = aligned_allocator<U, Alignment>;
+		};
+
+		constexpr aligned_allocator( ) noexcept = default;
+
+		template<typename U>
+		constexpr aligned_allocator(
+		  aligned_allocator<U, Alignment> const & ) noexcept {}
+
+		T *allocate( size_t n ) {
+			return static_cast<T *>(
+			  ::operator new( aligned_allocator_impl::byte_count( n, sizeof( T ) ),
+			                  std::align_val_t{alignment} ) );
+		}
+
+		void deallocate( T *ptr, size_t ) noexcept {
+			::operator delete( static_cast<void *>( ptr ),
+			                   std::align_val_t{alignment} );
+		}
+
+		template<typename U>
+		constexpr bool
+		operator==( aligned_allocator<U, Alignment> const & ) const noexcept {
+			return true;
+		}
+
+		template<typename U>
+		constexpr bool
+		operator!=( aligned_allocator<U, Alignment> const & ) const noexcept {
+			return false;
+		}
+	};
+
+	// Allocator for large arrays.  Requests of at least huge_page_size bytes are
+	// rounded up to whole 2MiB pages, aligned to them and, on Linux, advised with
+	// MADV_HUGEPAGE so that transparent huge pages can back them.  Smaller
+	// requests are cache line aligned and not advised
+	template<typename T>
+	class huge_page_allocator {
+		static constexpr size_t const small_alignment =
+		  alignof( T ) > 64U ? alignof( T ) : 64U;
+
+		static constexpr bool is_huge( size_t bytes ) noexcept {
+			return bytes >= huge_page_size;
+		}
+
+	public:
+		using value_type = T;
+
+		constexpr huge_page_allocator( ) noexcept = default;
+
+		template<typename U>
+		constexpr huge_page_allocator( huge_page_allocator<U> const & ) noexcept {}
+
+		T *allocate( size_t n ) {
+			auto bytes = aligned_allocator_impl::byte_count( n, sizeof( T ) );
+			if( not is_huge( bytes ) ) {
+				return static_cast<T *>(
+				  ::operator new( bytes, std::align_val_t{small_alignment} ) );
+			}
+			daw::exception::precondition_check<std::bad_array_new_length>(
+			  bytes <= std::numeric_limits<size_t>::max( ) - huge_page_size );
+			bytes = aligned_allocator_impl::round_up( bytes, huge_page_size );
+			auto ptr = ::operator new( bytes, std::align_val_t{huge_page_size} );
+#if defined( __linux__ ) && defined( MADV_HUGEPAGE )
+			// Only advice, the memory is usable either way
+			static_cast<void>( ::madvise( ptr, bytes, MADV_HUGEPAGE ) );
+#endif
+			return static_cast<T *>( ptr );
+		}
+
+		void deallocate( T *ptr, size_t n ) noexcept {
+			auto const alignment =
+			  is_huge( n * sizeof( T ) ) ? huge_page_size : small_alignment;
+			::operator delete( static_cast<void *>( ptr ),
+			                   std::align_val_t{alignment} );
+		}
+
+		template<typename U>
+		constexpr bool
+		operator==( huge_page_allocator<U> const & ) const noexcept {
+			return true;
+		}
+
+		template<typename U>
+		constexpr bool
+		operator!=( huge_page_allocator<U> const & ) const noexcept {
+			return false;
+		}
+	};
+} // namespace daw
@@ -0,0 +1,491 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "daw_exception.h"
+
+namespace daw {
+	namespace impl {
+		constexpr bool is_power_of_2( size_t n ) noexcept {
+			return n != 0 and ( n & ( n - 1 ) ) == 0;
+		}
+
+		inline char *align_up( char *ptr, size_t alignment ) noexcept {
+			auto const value = reinterpret_cast<uintptr_t>( ptr );
+			auto const aligned = ( value + ( alignment - 1 ) ) &
+			                     ~static_cast<uintptr_t>( alignment - 1 );
+			return ptr + ( aligned - value );
+		}
+
+		inline size_t checked_array_size( size_t count, size_t size ) {
+			daw::exception::precondition_check<std::bad_array_new_length>(
+			  size == 0 or count <= std::numeric_limits<size_t>::max( ) / size );
+			return count * size;
+		}
+	} // namespace impl
+
+	// Monotonic bump allocator.  Memory is carved out of a chain of blocks and is
+	// only handed back all at once, by reset or by rewinding to a marker.
+	// Deallocating a single allocation does nothing and destructors are never
+	// run for objects placed in the arena.  Blocks released by reset or rewind
+	// are kept for reuse until the arena is destroyed or release is called, so
+	// reset is O(1)
+	class arena {
+		struct alignas( std::max_align_t ) block_t {
+			block_t *prev;
+			size_t size;
+
+			char *first( ) noexcept {
+				return reinterpret_cast<char *>( this ) + sizeof( block_t );
+			}
+
+			char *last( ) noexcept {
+				return first( ) + size;
+			}
+		};
+
+		block_t *m_current = nullptr;
+		// The first block of the in use chain, so that it can be spliced onto the
+		// spare list in constant time
+		block_t *m_first = nullptr;
+		block_t *m_spare = nullptr;
+		char *m_pos = nullptr;
+		size_t m_block_size;
+		size_t m_bytes_reserved = 0;
+
+		static void free_chain( block_t *block ) noexcept {
+			while( block != nullptr ) {
+				auto prev = block->prev;
+				::operator delete( static_cast<void *>( block ) );
+				block = prev;
+			}
+		}
+
+		// Add a block with at least min_size usable bytes to the in use chain
+		void add_block( size_t min_size ) {
+			block_t *block = nullptr;
+			if( m_spare != nullptr and m_spare->size >= min_size ) {
+				block = m_spare;
+				m_spare = m_spare->prev;
+			} else {
+				auto const size = min_size > m_block_size ? min_size : m_block_size;
+				daw::exception::precondition_check<std::bad_array_new_length>(
+				  size <= std::numeric_limits<size_t>::max( ) - sizeof( block_t ) );
+				block = static_cast<block_t *>(
+				  ::operator new( sizeof( block_t ) + size ) );
+				block->size = size;
+				m_bytes_reserved += size;
+			}
+			block->prev = m_current;
+			if( m_current == nullptr ) {
+				m_first = block;
+			}
+			m_current = block;
+			m_pos = block->first( );
+		}
+
+	public:
+		static constexpr size_t const default_block_size = 64U * 1024U;
+
+		// Position to rewind back to
+		struct marker_t {
+			block_t *block = nullptr;
+			char *pos = nullptr;
+		};
+
+		explicit arena( size_t block_size = default_block_size )
+		  : m_block_size( block_size ) {
+
+			daw::exception::precondition_check<std::invalid_argument>(
+			  block_size > 0, "block_size must be greater than 0" );
+		}
+
+		arena( arena const & ) = delete;
+		arena &operator=( arena const & ) = delete;
+
+		arena( arena &&other ) noexcept
+		  : m_current( std::exchange( other.m_current, nullptr ) )
+		  , m_first( std::exchange( other.m_first, nullptr ) )
+		  , m_spare( std::exchange( other.m_spare, nullptr ) )
+		  , m_pos( std::exchange( other.m_pos, nullptr ) )
+		  , m_block_size( other.m_block_size )
+		  , m_bytes_reserved( std::exchange( other.m_bytes_reserved, 0 ) ) {}
+
+		arena &operator=( arena &&rhs ) noexcept {
+			if( this != &rhs ) {
+				release( );
+				m_current = std::exchange( rhs.m_current, nullptr );
+				m_first = std::exchange( rhs.m_first, nullptr );
+				m_spare = std::exchange( rhs.m_spare, nullptr );
+				m_pos = std::exchange( rhs.m_pos, nullptr );
+				m_block_size = rhs.m_block_size;
+				m_bytes_reserved = std::exchange( rhs.m_bytes_reserved, 0 );
+			}
+			return *this;
+		}
+
+		~arena( ) noexcept {
+			release( );
+		}
+
+		void *allocate( size_t size,
+		                size_t alignment = alignof( std::max_align_t ) ) {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  impl::is_power_of_2( alignment ), "alignment must be a power of 2" );
+			if( m_current != nullptr ) {
+				auto const result = impl::align_up( m_pos, alignment );
+				if( result <= m_current->last( ) and
+				    size <= static_cast<size_t>( m_current->last( ) - result ) ) {
+					m_pos = result + size;
+					return result;
+				}
+			}
+			// Blocks start max_align_t aligned, so only larger alignments need
+			// room to be skipped over
+			auto const slack =
+			  alignment > alignof( std::max_align_t ) ? alignment : 0U;
+			daw::exception::precondition_check<std::bad_array_new_length>(
+			  size <= std::numeric_limits<size_t>::max( ) - slack );
+			add_block( size + slack );
+			auto const result = impl::align_up( m_pos, alignment );
+			m_pos = result + size;
+			return result;
+		}
+
+		template<typename T>
+		T *allocate_array( size_t count ) {
+			return static_cast<T *>(
+			  allocate( impl::checked_array_size( count, sizeof( T ) ),
+			            alignof( T ) ) );
+		}
+
+		// Construct a T in the arena.  Its destructor will not be run
+		template<typename T, typename... Args>
+		T *make( Args &&... args ) {
+			return new( allocate( sizeof( T ), alignof( T ) ) )
+			  T( std::forward<Args>( args )... );
+		}
+
+		marker_t mark( ) const noexcept {
+			return {m_current, m_pos};
+		}
+
+		// Free everything allocated after marker was taken
+		void rewind( marker_t marker ) noexcept {
+			while( m_current != marker.block ) {
+				auto block = m_current;
+				m_current = block->prev;
+				block->prev = m_spare;
+				m_spare = block;
+			}
+			if( m_current == nullptr ) {
+				m_first = nullptr;
+				m_pos = nullptr;
+			} else {
+				m_pos = marker.pos;
+			}
+		}
+
+		// Free everything, keeping the blocks for reuse
+		void reset( ) noexcept {
+			if( m_current == nullptr ) {
+				return;
+			}
+			m_first->prev = m_spare;
+			m_spare = m_current;
+			m_current = nullptr;
+			m_first = nullptr;
+			m_pos = nullptr;
+		}
+
+		// Free everything and return all blocks to the system
+		void release( ) noexcept {
+			free_chain( m_current );
+			free_chain( m_spare );
+			m_current = nullptr;
+			m_first = nullptr;
+			m_spare = nullptr;
+			m_pos = nullptr;
+			m_bytes_reserved = 0;
+		}
+
+		size_t block_size( ) const noexcept {
+			return m_block_size;
+		}
+
+		// Usable bytes in all blocks owned, in use or spare
+		size_t bytes_reserved( ) const noexcept {
+			return m_bytes_reserved;
+		}
+	};
+
+	// Allocator adapter over an arena.  deallocate is a no-op, memory comes back
+	// when the arena is reset or destroyed
+	template<typename T>
+	class arena_allocator {
+		arena *m_arena;
+
+		template<typename>
+		friend class arena_allocator;
+
+	public:
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		explicit arena_allocator( arena &a ) noexcept
+		  : m_arena( &a ) {}
+
+		template<typename U>
+		arena_allocator( arena_allocator<U> const &other ) noexcept
+		  : m_arena( other.m_arena ) {}
+
+		T *allocate( size_t n ) {
+			return m_arena->allocate_array<T>( n );
+		}
+
+		void deallocate( T *, size_t ) noexcept {}
+
+		arena &get_arena( ) const noexcept {
+			return *m_arena;
+		}
+
+		template<typename U>
+		bool operator==( arena_allocator<U> const &rhs ) const noexcept {
+			return m_arena == rhs.m_arena;
+		}
+
+		template<typename U>
+		bool operator!=( arena_allocator<U> const &rhs ) const noexcept {
+			return m_arena != rhs.m_arena;
+		}
+	};
+
+	// Pool of fixed size blocks.  Freed blocks go on an intrusive free list and
+	// are handed out again before any new memory is requested.  Memory is
+	// requested blocks_per_chunk blocks at a time and only returned to the system
+	// when the pool is destroyed
+	class fixed_pool {
+		struct free_block_t {
+			free_block_t *next;
+		};
+
+		struct alignas( std::max_align_t ) chunk_t {
+			chunk_t *prev;
+		};
+
+		chunk_t *m_chunks = nullptr;
+		free_block_t *m_free = nullptr;
+		size_t m_block_size;
+		size_t m_alignment;
+		size_t m_blocks_per_chunk;
+		size_t m_chunk_count = 0;
+
+		void add_chunk( ) {
+			auto const size = sizeof( chunk_t ) + m_alignment +
+			                  impl::checked_array_size( m_blocks_per_chunk,
+			                                            m_block_size );
+			auto chunk = static_cast<chunk_t *>( ::operator new( size ) );
+			chunk->prev = m_chunks;
+			m_chunks = chunk;
+			++m_chunk_count;
+			auto first =
+			  impl::align_up( reinterpret_cast<char *>( chunk + 1 ), m_alignment );
+			// Thread the blocks onto the free list so the first is handed out first
+			for( size_t n = m_blocks_per_chunk; n > 0; --n ) {
+				auto block = reinterpret_cast<free_block_t *>(
+				  first + ( n - 1 ) * m_block_size );
+				block->next = m_free;
+				m_free = block;
+			}
+		}
+
+	public:
+		static constexpr size_t const default_blocks_per_chunk = 256;
+
+		explicit fixed_pool(
+		  size_t block_size, size_t alignment = alignof( std::max_align_t ),
+		  size_t blocks_per_chunk = default_blocks_per_chunk )
+		  : m_block_size( block_size )
+		  , m_alignment( alignment )
+		  , m_blocks_per_chunk( blocks_per_chunk ) {
+
+			daw::exception::precondition_check<std::invalid_argument>(
+			  impl::is_power_of_2( alignment ), "alignment must be a power of 2" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  blocks_per_chunk > 0, "blocks_per_chunk must be greater than 0" );
+			// Every block must be able to hold the free list link and keep the
+			// following block aligned
+			if( m_block_size < sizeof( free_block_t ) ) {
+				m_block_size = sizeof( free_block_t );
+			}
+			if( m_alignment < alignof( free_block_t ) ) {
+				m_alignment = alignof( free_block_t );
+			}
+			m_block_size = ( m_block_size + m_alignment - 1 ) & ~( m_alignment - 1 );
+		}
+
+		fixed_pool( fixed_pool const & ) = delete;
+		fixed_pool &operator=( fixed_pool const & ) = delete;
+
+		~fixed_pool( ) noexcept {
+			while( m_chunks != nullptr ) {
+				auto prev = m_chunks->prev;
+				::operator delete( static_cast<void *>( m_chunks ) );
+				m_chunks = prev;
+			}
+		}
+
+		void *allocate( ) {
+			if( m_free == nullptr ) {
+				add_chunk( );
+			}
+			auto result = m_free;
+			m_free = m_free->next;
+			return result;
+		}
+
+		void deallocate( void *ptr ) noexcept {
+			if( ptr == nullptr ) {
+				return;
+			}
+			auto block = static_cast<free_block_t *>( ptr );
+			block->next = m_free;
+			m_free = block;
+		}
+
+		size_t block_size( ) const noexcept {
+			return m_block_size;
+		}
+
+		size_t alignment( ) const noexcept {
+			return m_alignment;
+		}
+
+		size_t chunk_count( ) const noexcept {
+			return m_chunk_count;
+		}
+	};
+
+	// A fixed_pool sized for T that constructs and destroys the objects
+	template<typename T>
+	class object_pool {
+		fixed_pool m_pool;
+
+	public:
+		explicit object_pool(
+		  size_t blocks_per_chunk = fixed_pool::default_blocks_per_chunk )
+		  : m_pool( sizeof( T ), alignof( T ), blocks_per_chunk ) {}
+
+		template<typename... Args>
+		T *make( Args &&... args ) {
+			auto ptr = m_pool.allocate( );
+			try {
+				return new( ptr ) T( std::forward<Args>( args )... );
+			} catch( ... ) {
+				m_pool.deallocate( ptr );
+				throw;
+			}
+		}
+
+		void destroy( T *ptr ) noexcept {
+			if( ptr == nullptr ) {
+				return;
+			}
+			ptr->~T( );
+			m_pool.deallocate( ptr );
+		}
+
+		fixed_pool &pool( ) noexcept {
+			return m_pool;
+		}
+	};
+
+	// Allocator adapter over a fixed_pool.  Single objects that fit in a block
+	// come from the pool, which suits node based containers.  Anything else,
+	// such as the bucket array of an unordered container, goes to global new
+	template<typename T>
+	class pool_allocator {
+		fixed_pool *m_pool;
+
+		template<typename>
+		friend class pool_allocator;
+
+		bool uses_pool( size_t n ) const noexcept {
+			return n == 1 and sizeof( T ) <= m_pool->block_size( ) and
+			       alignof( T ) <= m_pool->alignment( );
+		}
+
+	public:
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		explicit pool_allocator( fixed_pool &pool ) noexcept
+		  : m_pool( &pool ) {}
+
+		template<typename U>
+		pool_allocator( pool_allocator<U> const &other ) noexcept
+		  : m_pool( other.m_pool ) {}
+
+		T *allocate( size_t n ) {
+			if( uses_pool( n ) ) {
+				return static_cast<T *>( m_pool->allocate( ) );
+			}
+			return std::allocator<T>{}.allocate( n );
+		}
+
+		void deallocate( T *ptr, size_t n ) noexcept {
+			if( uses_pool( n ) ) {
+				m_pool->deallocate( ptr );
+				return;
+			}
+			std::allocator<T>{}.deallocate( ptr, n );
+		}
+
+		fixed_pool &get_pool( ) const noexcept {
+			return *m_pool;
+		}
+
+		template<typename U>
+		bool operator==( pool_allocator<U> const &rhs ) const noexcept {
+			return m_pool == rhs.m_pool;
+		}
+
+		template<typename U>
+		bool operator!=( pool_allocator<U> const &rhs ) const noexcept {
+			return m_pool != rhs.m_pool;
+		}
+	};
+} // namespace daw
@@ -0,0 +1,422 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "daw_exception.h"
+#include "daw_span.h"
+#include "impl/daw_filter_impl.h"
+
+namespace daw {
+	template<typename Key, typename Hash, typename Storage>
+	class basic_bloom_filter;
+
+	template<typename Key, typename Hash = filter_impl::fnv1a_key_hash>
+	using bloom_filter = basic_bloom_filter<Key, Hash, std::vector<uint64_t>>;
+
+	// Read only filter over serialized data, e.g. a memory_mapped_file_t
+	template<typename Key, typename Hash = filter_impl::fnv1a_key_hash>
+	using bloom_filter_view =
+	  basic_bloom_filter<Key, Hash, daw::span<uint64_t const>>;
+
+	// Classic Bloom filter.  The k bit positions come from one hash via double
+	// hashing and the bit count is a power of 2
+	template<typename Key, typename Hash, typename Storage>
+	class basic_bloom_filter {
+		static constexpr bool const is_owning =
+		  filter_impl::is_owning_storage_v<Storage>;
+
+		Storage m_words{};
+		uint64_t m_mask = 0;
+		uint32_t m_hash_count = 0;
+		uint64_t m_item_count = 0;
+
+		template<typename, typename, typename>
+		friend class basic_bloom_filter;
+
+		basic_bloom_filter( Storage words, uint64_t mask, uint32_t hash_count,
+		                    uint64_t item_count ) noexcept
+		  : m_words( std::move( words ) )
+		  , m_mask( mask )
+		  , m_hash_count( hash_count )
+		  , m_item_count( item_count ) {}
+
+		static uint64_t hash_of( Key const &key ) {
+			return filter_impl::mix64( Hash{}( key ) );
+		}
+
+		bool test_hash( uint64_t hash ) const noexcept {
+			uint64_t const step = ( ( hash << 32U ) | ( hash >> 32U ) ) | 1U;
+			for( uint32_t n = 0; n < m_hash_count; ++n ) {
+				uint64_t const bit = hash & m_mask;
+				if( ( m_words[bit >> 6U] & ( 1ULL << ( bit & 63U ) ) ) == 0 ) {
+					return false;
+				}
+				hash += step;
+			}
+			return true;
+		}
+
+	public:
+		using key_type = Key;
+		using hasher = Hash;
+
+		// Size the filter so that expected_items keys give roughly the requested
+		// false positive rate
+		explicit basic_bloom_filter( size_t expected_items,
+		                             double false_positive_rate = 0.01 ) {
+			static_assert( is_owning, "Views can only be created from_bytes" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  false_positive_rate > 0.0 and false_positive_rate < 1.0,
+			  "false_positive_rate must be in the range (0, 1)" );
+			double const items =
+			  static_cast<double>( std::max( expected_items, size_t{1} ) );
+			double const ln2 = std::log( 2.0 );
+			auto const min_bits = static_cast<uint64_t>(
+			  std::ceil( -items * std::log( false_positive_rate ) / ( ln2 * ln2 ) ) );
+			uint64_t bits = 64;
+			while( bits < min_bits ) {
+				bits <<= 1U;
+			}
+			m_words.resize( bits / 64U, 0 );
+			m_mask = bits - 1U;
+			m_hash_count = static_cast<uint32_t>( std::clamp(
+			  std::round( static_cast<double>( bits ) / items * ln2 ), 1.0, 30.0 ) );
+		}
+
+		// Create a read only view over a filter written with serialize.  data must
+		// outlive the view
+		static basic_bloom_filter from_bytes( char const *data, size_t size ) {
+			static_assert( !is_owning, "from_bytes creates a bloom_filter_view" );
+			auto const header = filter_impl::read_filter_header<uint64_t>(
+			  data, size, filter_impl::filter_kind::bloom );
+			// The mask relies on a power of two word count
+			daw::exception::precondition_check<std::invalid_argument>(
+			  header.word_count > 0 and
+			    ( header.word_count & ( header.word_count - 1U ) ) == 0,
+			  "Serialized filter size must be a power of two" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  header.parameter >= 1 and header.parameter <= 30,
+			  "Serialized filter hash count must be in the range [1, 30]" );
+			return basic_bloom_filter(
+			  Storage( reinterpret_cast<uint64_t const *>(
+			             data + sizeof( filter_impl::filter_header_t ) ),
+			           static_cast<size_t>( header.word_count ) ),
+			  header.word_count * 64U - 1U, header.parameter, header.item_count );
+		}
+
+		bloom_filter_view<Key, Hash> view( ) const noexcept {
+			return {daw::span<uint64_t const>( m_words.data( ), m_words.size( ) ),
+			        m_mask, m_hash_count, m_item_count};
+		}
+
+		void insert( Key const &key ) {
+			static_assert( is_owning, "Cannot insert into a bloom_filter_view" );
+			uint64_t hash = hash_of( key );
+			uint64_t const step = ( ( hash << 32U ) | ( hash >> 32U ) ) | 1U;
+			for( uint32_t n = 0; n < m_hash_count; ++n ) {
+				uint64_t const bit = hash & m_mask;
+				m_words[bit >> 6U] |= 1ULL << ( bit & 63U );
+				hash += step;
+			}
+			++m_item_count;
+		}
+
+		bool may_contain( Key const &key ) const {
+			return test_hash( hash_of( key ) );
+		}
+
+		// Test every key, results[n] is the answer for keys[n].  Returns the number
+		// of keys that may be present.  Keys are hashed in batches ahead of the
+		// bit tests so the hashing does not sit in the dependency chain of the
+		// memory loads
+		size_t may_contain( daw::span<Key const> keys,
+		                    daw::span<bool> results ) const {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  results.size( ) >= keys.size( ), "results is too small" );
+			constexpr size_t const batch_size = 32;
+			uint64_t hashes[batch_size];
+			size_t count = 0;
+			for( size_t first = 0; first < keys.size( ); first += batch_size ) {
+				size_t const last = std::min( keys.size( ), first + batch_size );
+				for( size_t n = first; n < last; ++n ) {
+					hashes[n - first] = hash_of( keys[n] );
+				}
+				for( size_t n = first; n < last; ++n ) {
+					bool const found = test_hash( hashes[n - first] );
+					results[n] = found;
+					count += found ? 1U : 0U;
+				}
+			}
+			return count;
+		}
+
+		void clear( ) {
+			static_assert( is_owning, "Cannot clear a bloom_filter_view" );
+			std::fill( m_words.begin( ), m_words.end( ), 0 );
+			m_item_count = 0;
+		}
+
+		// Number of insert calls, including duplicates
+		uint64_t item_count( ) const noexcept {
+			return m_item_count;
+		}
+
+		uint64_t bit_count( ) const noexcept {
+			return m_mask + 1U;
+		}
+
+		uint32_t hash_count( ) const noexcept {
+			return m_hash_count;
+		}
+
+		size_t serialized_size( ) const noexcept {
+			return sizeof( filter_impl::filter_header_t ) +
+			       m_words.size( ) * sizeof( uint64_t );
+		}
+
+		// Write a header and the filter words in native byte order.  Read back
+		// with bloom_filter_view::from_bytes
+		template<typename OStream>
+		void serialize( OStream &os ) const {
+			filter_impl::filter_header_t header{};
+			header.kind = filter_impl::filter_kind::bloom;
+			header.parameter = m_hash_count;
+			header.word_size = sizeof( uint64_t );
+			header.word_count = m_words.size( );
+			header.item_count = m_item_count;
+			filter_impl::write_filter( os, header, m_words.data( ) );
+		}
+	};
+
+	namespace filter_impl {
+		// One cache line of filter bits
+		struct alignas( 64 ) bloom_block_t {
+			uint64_t lanes[8];
+		};
+	} // namespace filter_impl
+
+	template<typename Key, typename Hash, typename Storage>
+	class basic_blocked_bloom_filter;
+
+	template<typename Key, typename Hash = filter_impl::fnv1a_key_hash>
+	using blocked_bloom_filter =
+	  basic_blocked_bloom_filter<Key, Hash,
+	                             std::vector<filter_impl::bloom_block_t>>;
+
+	// Read only filter over serialized data, e.g. a memory_mapped_file_t
+	template<typename Key, typename Hash = filter_impl::fnv1a_key_hash>
+	using blocked_bloom_filter_view =
+	  basic_blocked_bloom_filter<Key, Hash,
+	                             daw::span<filter_impl::bloom_block_t const>>;
+
+	// Bloom filter where all bits of a key live in one 64 byte block, so a
+	// lookup touches a single cache line.  Each key sets one bit in each of the
+	// 8 lanes of its block, chosen by multiplying the hash with a per lane salt.
+	// The lane loops are branch free so they compile to vector compares
+	template<typename Key, typename Hash, typename Storage>
+	class basic_blocked_bloom_filter {
+		static constexpr bool const is_owning =
+		  filter_impl::is_owning_storage_v<Storage>;
+		static constexpr size_t const lane_count = 8;
+		static constexpr uint32_t const salts[lane_count] = {
+		  0x47b6'137bU, 0x4497'4d91U, 0x8824'ad5bU, 0xa2b7'289dU,
+		  0x7054'95c7U, 0x2df1'424bU, 0x9efc'4947U, 0x5c6b'fb31U};
+
+		using block_t = filter_impl::bloom_block_t;
+
+		Storage m_blocks{};
+		uint64_t m_item_count = 0;
+
+		template<typename, typename, typename>
+		friend class basic_blocked_bloom_filter;
+
+		basic_blocked_bloom_filter( Storage blocks, uint64_t item_count ) noexcept
+		  : m_blocks( std::move( blocks ) )
+		  , m_item_count( item_count ) {}
+
+		static uint64_t hash_of( Key const &key ) {
+			return filter_impl::mix64( Hash{}( key ) );
+		}
+
+		static constexpr void make_mask( uint64_t hash,
+		                                 uint64_t ( &mask )[lane_count] ) noexcept {
+			auto const key = static_cast<uint32_t>( hash );
+			for( size_t n = 0; n < lane_count; ++n ) {
+				mask[n] = 1ULL << ( static_cast<uint32_t>( key * salts[n] ) >> 26U );
+			}
+		}
+
+		size_t block_index( uint64_t hash ) const noexcept {
+			auto const block_count = static_cast<uint32_t>( m_blocks.size( ) );
+			return filter_impl::fast_range( static_cast<uint32_t>( hash >> 32U ),
+			                                block_count );
+		}
+
+		bool test_hash( uint64_t hash ) const noexcept {
+			uint64_t mask[lane_count];
+			make_mask( hash, mask );
+			auto const &block = m_blocks[block_index( hash )];
+			uint64_t missing = 0;
+			for( size_t n = 0; n < lane_count; ++n ) {
+				missing |= mask[n] & ~block.lanes[n];
+			}
+			return missing == 0;
+		}
+
+	public:
+		using key_type = Key;
+		using hasher = Hash;
+
+		// Size the filter so that expected_items keys give roughly the requested
+		// false positive rate.  Blocking costs some accuracy so about 20% more
+		// bits than a classic Bloom filter are used
+		explicit basic_blocked_bloom_filter( size_t expected_items,
+		                                     double false_positive_rate = 0.01 ) {
+			static_assert( is_owning, "Views can only be created from_bytes" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  false_positive_rate > 0.0 and false_positive_rate < 1.0,
+			  "false_positive_rate must be in the range (0, 1)" );
+			double const items =
+			  static_cast<double>( std::max( expected_items, size_t{1} ) );
+			double const ln2 = std::log( 2.0 );
+			double const bits =
+			  1.2 * -items * std::log( false_positive_rate ) / ( ln2 * ln2 );
+			auto const block_count = static_cast<size_t>(
+			  std::ceil( bits / static_cast<double>( sizeof( block_t ) * 8U ) ) );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  block_count <= std::numeric_limits<uint32_t>::max( ),
+			  "Filter is too large" );
+			m_blocks.resize( std::max( block_count, size_t{1} ), block_t{} );
+		}
+
+		// Create a read only view over a filter written with serialize.  data must
+		// outlive the view
+		static basic_blocked_bloom_filter from_bytes( char const *data,
+		                                              size_t size ) {
+			static_assert( !is_owning,
+			               "from_bytes creates a blocked_bloom_filter_view" );
+			auto const header = filter_impl::read_filter_header<block_t>(
+			  data, size, filter_impl::filter_kind::blocked_bloom );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  header.word_count > 0, "Serialized filter is empty" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  header.word_count <= std::numeric_limits<uint32_t>::max( ),
+			  "Serialized filter is too large" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  header.parameter == lane_count,
+			  "Serialized filter has a different block layout" );
+			return basic_blocked_bloom_filter(
+			  Storage( reinterpret_cast<block_t const *>(
+			             data + sizeof( filter_impl::filter_header_t ) ),
+			           static_cast<size_t>( header.word_count ) ),
+			  header.item_count );
+		}
+
+		blocked_bloom_filter_view<Key, Hash> view( ) const noexcept {
+			return {daw::span<block_t const>( m_blocks.data( ), m_blocks.size( ) ),
+			        m_item_count};
+		}
+
+		void insert( Key const &key ) {
+			static_assert( is_owning,
+			               "Cannot insert into a blocked_bloom_filter_view" );
+			auto const hash = hash_of( key );
+			uint64_t mask[lane_count];
+			make_mask( hash, mask );
+			auto &block = m_blocks[block_index( hash )];
+			for( size_t n = 0; n < lane_count; ++n ) {
+				block.lanes[n] |= mask[n];
+			}
+			++m_item_count;
+		}
+
+		bool may_contain( Key const &key ) const {
+			return test_hash( hash_of( key ) );
+		}
+
+		// Test every key, results[n] is the answer for keys[n].  Returns the number
+		// of keys that may be present.  Keys are hashed in batches ahead of the
+		// block tests so several cache line loads can be in flight at once
+		size_t may_contain( daw::span<Key const> keys,
+		                    daw::span<bool> results ) const {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  results.size( ) >= keys.size( ), "results is too small" );
+			constexpr size_t const batch_size = 32;
+			uint64_t hashes[batch_size];
+			size_t count = 0;
+			for( size_t first = 0; first < keys.size( ); first += batch_size ) {
+				size_t const last = std::min( keys.size( ), first + batch_size );
+				for( size_t n = first; n < last; ++n ) {
+					hashes[n - first] = hash_of( keys[n] );
+				}
+				for( size_t n = first; n < last; ++n ) {
+					bool const found = test_hash( hashes[n - first] );
+					results[n] = found;
+					count += found ? 1U : 0U;
+				}
+			}
+			return count;
+		}
+
+		void clear( ) {
+			static_assert( is_owning, "Cannot clear a blocked_bloom_filter_view" );
+			std::fill( m_blocks.begin( ), m_blocks.end( ), block_t{} );
+			m_item_count = 0;
+		}
+
+		// Number of insert calls, including duplicates
+		uint64_t item_count( ) const noexcept {
+			return m_item_count;
+		}
+
+		uint64_t bit_count( ) const noexcept {
+			return m_blocks.size( ) * sizeof( block_t ) * 8U;
+		}
+
+		size_t serialized_size( ) const noexcept {
+			return sizeof( filter_impl::filter_header_t ) +
+			       m_blocks.size( ) * sizeof( block_t );
+		}
+
+		// Write a header and the filter blocks in native byte order.  Read back
+		// with blocked_bloom_filter_view::from_bytes
+		template<typename OStream>
+		void serialize( OStream &os ) const {
+			filter_impl::filter_header_t header{};
+			header.kind = filter_impl::filter_kind::blocked_bloom;
+			header.parameter = lane_count;
+			header.word_size = sizeof( block_t );
+			header.word_count = m_blocks.size( );
+			header.item_count = m_item_count;
+			filter_impl::write_filter( os, header, m_blocks.data( ) );
+		}
+	};
+} // namespace daw
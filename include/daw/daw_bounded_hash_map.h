@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <numeric>
 #include <optional>
@@ -29,6 +30,10 @@
 
 #include "cpp_17.h"
 #include "daw_algorithm.h"
+#include "daw_exception.h"
+#include "daw_hash_stats.h"
+#include "daw_prefetch.h"
+#include "daw_span.h"
 #include "daw_traits.h"
 
 namespace daw {
@@ -342,11 +347,8 @@ namespace daw {
 			return ( hash * prime_a + prime_b ) % range_size;
 		}
 
-		constexpr std::optional<size_type> find_index( Key const &key ) const
-		  noexcept {
-			size_type const hash = Hash{}( key );
-			size_type const scaled_hash = scale_hash( hash, capacity( ) );
-
+		constexpr std::optional<size_type>
+		find_index( Key const &key, size_type const scaled_hash ) const noexcept {
 			for( size_type n = scaled_hash; n < capacity( ); ++n ) {
 				if( !m_data[n] or key_equal{}( m_data[n].kv.key, key ) ) {
 					return n;
@@ -360,6 +362,11 @@ namespace daw {
 			return {};
 		}
 
+		constexpr std::optional<size_type> find_index( Key const &key ) const
+		  noexcept {
+			return find_index( key, scale_hash( Hash{}( key ), capacity( ) ) );
+		}
+
 	public:
 		constexpr bounded_hash_map( ) noexcept(
 		  std::is_nothrow_default_constructible_v<
@@ -438,6 +445,51 @@ namespace daw {
 			return item.kv.value;
 		}
 
+		// Look up every key, results[n] points to the value for keys[n] or is
+		// nullptr when it is absent.  Returns the number of keys found.  Keys are
+		// hashed and their home items prefetched a group at a time, then probed
+		size_type find_many( daw::span<Key const> keys,
+		                     daw::span<mapped_type const *> results ) const {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  results.size( ) >= keys.size( ), "results is too small" );
+			constexpr size_type const group_size = daw::prefetch_group_size;
+			size_type homes[group_size];
+			size_type count = 0;
+			for( size_type first = 0; first < keys.size( ); first += group_size ) {
+				size_type const last = std::min( keys.size( ), first + group_size );
+				for( size_type n = first; n < last; ++n ) {
+					auto const home = scale_hash( Hash{}( keys[n] ), capacity( ) );
+					homes[n - first] = home;
+					daw::prefetch( &m_data[home] );
+				}
+				for( size_type n = first; n < last; ++n ) {
+					auto const idx = find_index( keys[n], homes[n - first] );
+					if( idx and m_data[*idx] ) {
+						results[n] = &m_data[*idx].kv.value;
+						++count;
+					} else {
+						results[n] = nullptr;
+					}
+				}
+			}
+			return count;
+		}
+
+		// Probe lengths and occupancy of the map.  erase empties slots, so there
+		// are never tombstones
+		hash_stats_t stats( ) const {
+			hash_stats_t result{};
+			result.capacity = capacity( );
+			for( size_type n = 0; n < capacity( ); ++n ) {
+				if( m_data[n] ) {
+					auto const home =
+					  scale_hash( Hash{}( m_data[n].kv.key ), capacity( ) );
+					result.add_item( hash_stats_t::displacement( home, n, capacity( ) ) );
+				}
+			}
+			return result;
+		}
+
 		constexpr size_type count( Key const &key ) const noexcept {
 			if( exists( key ) ) {
 				return 1U;
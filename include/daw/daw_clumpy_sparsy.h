@@ -19,193 +19,502 @@
 // LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
-
 #pragma once
 
-#include <boost/iterator/iterator_facade.hpp>
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
-#include "daw_algorithm.h"
+#include "daw_exception.h"
 
 namespace daw {
-	template<typename T>
-	class clumpy_sparsy_iterator;
-
-	template<typename T>
-	using clumpy_sparsy_const_iterator = clumpy_sparsy_iterator<T const>;
+	// Footprint of a clumpy_sparsy
+	struct sparse_memory_t {
+		// Number of pages allocated, the element slots in them and how many of
+		// those hold a value
+		size_t page_count = 0;
+		size_t slots = 0;
+		size_t present = 0;
+		// Bytes in pages, including slots for absent elements
+		size_t page_bytes = 0;
+		// Estimated bytes used by the page index
+		size_t index_bytes = 0;
+
+		size_t total_bytes( ) const noexcept {
+			return page_bytes + index_bytes;
+		}
 
-	// Provide a vector like structure that assumes that the sparseness has clumps
-	template<typename T>
+		// Fraction of allocated slots that hold an element
+		double occupancy( ) const noexcept {
+			if( slots == 0 ) {
+				return 0.0;
+			}
+			return static_cast<double>( present ) / static_cast<double>( slots );
+		}
+	};
+
+	// Provide a vector like structure that assumes that the sparseness has
+	// clumps.  Positions are grouped into pages of PageSize elements with a
+	// presence mask, so storage is only needed for the pages a clump touches.
+	// Pages are found through a hash index in O(1).  A sorted list of page
+	// numbers serves ordered traversal; appending pages in order keeps it
+	// sorted, otherwise it is rebuilt on the next traversal.  References stay
+	// valid until their element is erased
+	template<typename T, typename Allocator = std::allocator<T>,
+	         size_t PageSize = 64>
 	class clumpy_sparsy {
-		class Chunk {
-			size_t m_start;
-			std::vector<T> m_items;
+		static_assert( PageSize > 0 and PageSize <= 64 and
+		                 ( PageSize & ( PageSize - 1 ) ) == 0,
+		               "PageSize must be a power of 2 no larger than 64" );
+
+		struct page_t {
+			uint64_t mask = 0;
+			alignas( T ) unsigned char data[sizeof( T ) * PageSize];
 
-		public:
-			Chunk( ) = default;
-			~Chunk( ) = default;
-			Chunk( Chunk const & ) = default;
-			Chunk( Chunk && ) = default;
-			Chunk &operator=( Chunk const & ) = default;
-			Chunk &operator=( Chunk && ) = default;
-			size_t size( ) const {
-				return m_items.size( );
+			T *get( size_t idx ) noexcept {
+				return std::launder( reinterpret_cast<T *>( data ) + idx );
 			}
 
-			size_t &start( ) {
-				return m_start;
+			T const *get( size_t idx ) const noexcept {
+				return std::launder( reinterpret_cast<T const *>( data ) + idx );
 			}
 
-			size_t const &start( ) const {
-				return m_start;
+			bool has( size_t idx ) const noexcept {
+				return ( mask >> idx ) & 1U;
 			}
+		};
+
+		template<typename U>
+		using rebind_alloc_t =
+		  typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+
+		using page_alloc_t = rebind_alloc_t<page_t>;
+		using page_alloc_traits = std::allocator_traits<page_alloc_t>;
+		using index_t =
+		  std::unordered_map<size_t, page_t *, std::hash<size_t>,
+		                     std::equal_to<size_t>,
+		                     rebind_alloc_t<std::pair<size_t const, page_t *>>>;
+		using order_t = std::vector<size_t, rebind_alloc_t<size_t>>;
+
+		static constexpr size_t page_of( size_t pos ) noexcept {
+			return pos / PageSize;
+		}
+
+		static constexpr size_t slot_of( size_t pos ) noexcept {
+			return pos % PageSize;
+		}
 
-			size_t end( ) const {
-				return m_start + size( );
+		page_alloc_t m_page_alloc;
+		index_t m_index;
+		// Page numbers in ascending order, when m_order_valid
+		mutable order_t m_order;
+		mutable bool m_order_valid = true;
+		size_t m_size = 0;
+		size_t m_count = 0;
+		// Last page found, for sequential access
+		mutable size_t m_last_page_no = 0;
+		mutable page_t *m_last_page = nullptr;
+
+		page_t *find_page( size_t page_no ) const {
+			if( m_last_page != nullptr and m_last_page_no == page_no ) {
+				return m_last_page;
 			}
+			auto it = m_index.find( page_no );
+			if( it == m_index.end( ) ) {
+				return nullptr;
+			}
+			m_last_page_no = page_no;
+			m_last_page = it->second;
+			return it->second;
+		}
 
-			std::vector<T> &items( ) {
-				return m_items;
+		page_t *get_page( size_t page_no ) {
+			if( auto page = find_page( page_no ); page != nullptr ) {
+				return page;
 			}
+			page_t *page = page_alloc_traits::allocate( m_page_alloc, 1 );
+			new( page ) page_t{};
+			try {
+				m_index.emplace( page_no, page );
+			} catch( ... ) {
+				page_alloc_traits::deallocate( m_page_alloc, page, 1 );
+				throw;
+			}
+			if( m_order_valid and
+			    ( m_order.empty( ) or m_order.back( ) < page_no ) ) {
+				try {
+					m_order.push_back( page_no );
+				} catch( ... ) { m_order_valid = false; }
+			} else {
+				m_order_valid = false;
+			}
+			m_last_page_no = page_no;
+			m_last_page = page;
+			return page;
+		}
 
-			std::vector<T> const &items( ) const {
-				return m_items;
+		order_t const &ordered_pages( ) const {
+			if( not m_order_valid ) {
+				m_order.clear( );
+				m_order.reserve( m_index.size( ) );
+				for( auto const &item : m_index ) {
+					m_order.push_back( item.first );
+				}
+				std::sort( m_order.begin( ), m_order.end( ) );
+				m_order_valid = true;
 			}
+			return m_order;
+		}
 
-			bool operator<( Chunk const &rhs ) {
-				return start( ) < rhs.start( );
+		// Remove a page that has no values left
+		void remove_page( typename index_t::iterator it ) noexcept {
+			auto const page_no = it->first;
+			destroy_page( it->second );
+			m_index.erase( it );
+			m_last_page = nullptr;
+			if( m_order_valid and not m_order.empty( ) and
+			    m_order.back( ) == page_no ) {
+				m_order.pop_back( );
+			} else {
+				m_order_valid = false;
 			}
-		}; // class Chunk
-	public:
-		using values_type = ::std::vector<Chunk>;
-		using value_type = typename values_type::value_type;
-		using reference = typename values_type::reference;
-		using const_reference = typename values_type::reference;
-		using iterator = clumpy_sparsy_iterator<T>;
-		using const_iterator = clumpy_sparsy_const_iterator<T>;
+		}
 
-	private:
-		// Must be mutable as we hide our size and expand the values < size to fit
-		// as needed
-		values_type mutable m_items;
-		size_t m_size;
-
-		auto lfind( size_t pos ) {
-			if( pos >= size( ) ) {
-				return size( );
-			}
-			auto item_pos = daw::algorithm::find_last_of(
-			  m_items.begin( ), m_items.end( ),
-			  [pos]( auto const &item ) { return pos >= item.start( ); } );
-			if( item_pos < size( ) ) {
-				// We are within the max size of the container.  Feel free to add it
-				auto offset = pos - item_pos->start( );
-				if( offset > item_pos->size( ) + 1 ) {
-					++item_pos;
-					item_pos = m_items.emplace( item_pos );
-					item_pos->start( ) = pos;
-					item_pos->items( ).emplace_back( );
+		void destroy_page( page_t *page ) noexcept {
+			for( size_t n = 0; n < PageSize; ++n ) {
+				if( page->has( n ) ) {
+					page->get( n )->~T( );
 				}
 			}
-			return item_pos;
+			page->~page_t( );
+			page_alloc_traits::deallocate( m_page_alloc, page, 1 );
+		}
+
+		template<typename... Args>
+		T &emplace_in( page_t *page, size_t pos, Args &&... args ) {
+			auto const slot = slot_of( pos );
+			if( page->has( slot ) ) {
+				*page->get( slot ) = T( std::forward<Args>( args )... );
+				return *page->get( slot );
+			}
+			new( page->get( slot ) ) T( std::forward<Args>( args )... );
+			page->mask |= uint64_t{1} << slot;
+			++m_count;
+			if( pos >= m_size ) {
+				m_size = pos + 1;
+			}
+			return *page->get( slot );
+		}
+
+		void copy_from( clumpy_sparsy const &other ) {
+			other.for_each_range( [&]( size_t first, T const *values,
+			                           size_t count ) {
+				page_t *page = get_page( page_of( first ) );
+				for( size_t n = 0; n < count; ++n ) {
+					emplace_in( page, first + n, values[n] );
+				}
+			} );
+			m_size = other.m_size;
 		}
 
 	public:
-		size_t size( ) const {
-			return m_size;
+		using value_type = T;
+		using reference = value_type &;
+		using const_reference = value_type const &;
+		using size_type = size_t;
+		using allocator_type = Allocator;
+
+		static constexpr size_t const page_size = PageSize;
+
+		clumpy_sparsy( ) = default;
+
+		explicit clumpy_sparsy( Allocator const &alloc )
+		  : m_page_alloc( alloc )
+		  , m_index( typename index_t::allocator_type( alloc ) )
+		  , m_order( typename order_t::allocator_type( alloc ) ) {}
+
+		clumpy_sparsy( clumpy_sparsy const &other )
+		  : m_page_alloc( page_alloc_traits::select_on_container_copy_construction(
+		      other.m_page_alloc ) )
+		  , m_index( other.m_index.get_allocator( ) )
+		  , m_order( other.m_order.get_allocator( ) ) {
+
+			copy_from( other );
 		}
 
-		reference operator[]( size_t pos ) {
-			auto item = lfind( pos );
+		clumpy_sparsy( clumpy_sparsy &&other ) noexcept
+		  : m_page_alloc( other.m_page_alloc )
+		  , m_index( std::move( other.m_index ) )
+		  , m_order( std::move( other.m_order ) )
+		  , m_order_valid( std::exchange( other.m_order_valid, true ) )
+		  , m_size( std::exchange( other.m_size, 0 ) )
+		  , m_count( std::exchange( other.m_count, 0 ) ) {
+
+			other.m_index.clear( );
+			other.m_order.clear( );
+			other.m_last_page = nullptr;
 		}
 
-		iterator begin( ) {
-			return clumpy_sparsy_iterator<T>( this );
+		clumpy_sparsy &operator=( clumpy_sparsy const &rhs ) {
+			if( this != &rhs ) {
+				clear( );
+				copy_from( rhs );
+			}
+			return *this;
 		}
 
-		const_iterator begin( ) const {
-			return clumpy_sparsy_const_iterator<T>( this );
+		clumpy_sparsy &operator=( clumpy_sparsy &&rhs ) noexcept {
+			if( this != &rhs ) {
+				clear( );
+				m_page_alloc = rhs.m_page_alloc;
+				m_index = std::move( rhs.m_index );
+				m_order = std::move( rhs.m_order );
+				m_order_valid = std::exchange( rhs.m_order_valid, true );
+				m_size = std::exchange( rhs.m_size, 0 );
+				m_count = std::exchange( rhs.m_count, 0 );
+				rhs.m_index.clear( );
+				rhs.m_order.clear( );
+				rhs.m_last_page = nullptr;
+			}
+			return *this;
 		}
 
-		const_iterator cbegin( ) const {
-			return clumpy_sparsy_const_iterator<T>( this );
+		~clumpy_sparsy( ) {
+			clear( );
 		}
 
-		iterator end( ) {
-			return clumpy_sparsy_iterator<T>( this, size( ) );
+		allocator_type get_allocator( ) const {
+			return allocator_type( m_page_alloc );
 		}
 
-		const_iterator end( ) const {
-			return clumpy_sparsy_const_iterator<T>( this, size( ) );
+		// One past the highest position ever stored
+		size_t size( ) const noexcept {
+			return m_size;
 		}
 
-		const_iterator cend( ) const {
-			return clumpy_sparsy_const_iterator<T>( this, size( ) );
+		// Number of positions holding a value
+		size_t count( ) const noexcept {
+			return m_count;
 		}
 
-	}; // class clumpy_sparsy
+		bool empty( ) const noexcept {
+			return m_count == 0;
+		}
 
-	template<typename T>
-	class clumpy_sparsy_iterator
-	  : public boost::iterator_facade<clumpy_sparsy_iterator<T>, T,
-	                                  boost::random_access_traversal_tag> {
-		size_t m_position;
-		clumpy_sparsy<T> *m_items;
+		bool contains( size_t pos ) const {
+			auto page = find_page( page_of( pos ) );
+			return page != nullptr and page->has( slot_of( pos ) );
+		}
 
-		auto as_tuple( ) {
-			return std::tie( m_position, m_items );
+		T *find( size_t pos ) {
+			auto page = find_page( page_of( pos ) );
+			if( page == nullptr or not page->has( slot_of( pos ) ) ) {
+				return nullptr;
+			}
+			return page->get( slot_of( pos ) );
 		}
 
-		friend class boost::iterator_core_access;
-		void increment( ) {
-			if( m_items->size( ) == m_position ) {
-				return;
+		T const *find( size_t pos ) const {
+			auto page = find_page( page_of( pos ) );
+			if( page == nullptr or not page->has( slot_of( pos ) ) ) {
+				return nullptr;
 			}
-			++m_position;
+			return page->get( slot_of( pos ) );
 		}
 
-		void decrement( ) {
-			if( 0 == m_position ) {
-				return;
+		// Value initializes the element when absent
+		reference operator[]( size_t pos ) {
+			page_t *page = get_page( page_of( pos ) );
+			if( page->has( slot_of( pos ) ) ) {
+				return *page->get( slot_of( pos ) );
 			}
-			--m_position;
+			return emplace_in( page, pos );
 		}
 
-		bool equal( clumpy_sparsy_iterator const &other ) {
-			return as_tuple( ) == other.as_tuple( );
+		reference at( size_t pos ) {
+			auto result = find( pos );
+			daw::exception::precondition_check<std::out_of_range>(
+			  result != nullptr, "No value at position" );
+			return *result;
 		}
 
-		auto &dereference( ) const {
-			return ( *m_items )[m_position];
+		const_reference at( size_t pos ) const {
+			auto result = find( pos );
+			daw::exception::precondition_check<std::out_of_range>(
+			  result != nullptr, "No value at position" );
+			return *result;
 		}
 
-		void advance( ptrdiff_t n ) {
-			if( 0 > n ) {
-				n *= -1;
-				if( n >= m_position ) {
-					m_position = 0;
-				} else {
-					m_position -= n;
+		template<typename... Args>
+		reference emplace( size_t pos, Args &&... args ) {
+			return emplace_in( get_page( page_of( pos ) ), pos,
+			                   std::forward<Args>( args )... );
+		}
+
+		// Store [first, last) at positions start, start + 1, ...
+		template<typename Iterator>
+		void assign( size_t start, Iterator first, Iterator last ) {
+			page_t *page = nullptr;
+			size_t page_no = 0;
+			for( size_t pos = start; first != last; ++first, ++pos ) {
+				if( page == nullptr or page_of( pos ) != page_no ) {
+					page_no = page_of( pos );
+					page = get_page( page_no );
 				}
-			} else {
-				m_position += n;
-				{
-					auto sz = m_items->size( );
-					if( sz < m_position ) {
-						m_position = sz;
+				emplace_in( page, pos, *first );
+			}
+		}
+
+		// Store count copies of value starting at position start
+		void assign( size_t start, size_t count, const_reference value ) {
+			page_t *page = nullptr;
+			size_t page_no = 0;
+			for( size_t pos = start; pos < start + count; ++pos ) {
+				if( page == nullptr or page_of( pos ) != page_no ) {
+					page_no = page_of( pos );
+					page = get_page( page_no );
+				}
+				emplace_in( page, pos, value );
+			}
+		}
+
+		bool erase( size_t pos ) {
+			auto it = m_index.find( page_of( pos ) );
+			if( it == m_index.end( ) or not it->second->has( slot_of( pos ) ) ) {
+				return false;
+			}
+			page_t *page = it->second;
+			page->get( slot_of( pos ) )->~T( );
+			page->mask &= ~( uint64_t{1} << slot_of( pos ) );
+			--m_count;
+			if( page->mask == 0 ) {
+				remove_page( it );
+			}
+			return true;
+		}
+
+		// Erase every value in [first, last).  Returns the number erased
+		size_t erase( size_t first, size_t last ) {
+			if( first >= last ) {
+				return 0;
+			}
+			size_t result = 0;
+			ordered_pages( );
+			auto out = std::lower_bound( m_order.begin( ), m_order.end( ),
+			                             page_of( first ) );
+			auto it = out;
+			for( ; it != m_order.end( ) and *it * PageSize < last; ++it ) {
+				auto pos = m_index.find( *it );
+				page_t *page = pos->second;
+				auto const base = *it * PageSize;
+				for( size_t n = 0; n < PageSize; ++n ) {
+					if( base + n >= first and base + n < last and page->has( n ) ) {
+						page->get( n )->~T( );
+						page->mask &= ~( uint64_t{1} << n );
+						++result;
 					}
 				}
+				if( page->mask == 0 ) {
+					destroy_page( page );
+					m_index.erase( pos );
+				} else {
+					*out++ = *it;
+				}
 			}
+			// The surviving pages keep their order
+			m_order.erase( out, it );
+			m_count -= result;
+			m_last_page = nullptr;
+			return result;
 		}
 
-	public:
-		clumpy_sparsy_iterator( )
-		  : m_position( std::numeric_limits<size_t>::max( ) )
-		  , m_items( nullptr ) {}
-		clumpy_sparsy_iterator( clumpy_sparsy<T> *items, size_t position = 0 )
-		  : m_position( position )
-		  , m_items( items ) {}
-	}; // class clumpy_sparsy_iterator
+		void clear( ) noexcept {
+			for( auto &item : m_index ) {
+				destroy_page( item.second );
+			}
+			m_index.clear( );
+			m_order.clear( );
+			m_order_valid = true;
+			m_size = 0;
+			m_count = 0;
+			m_last_page = nullptr;
+		}
+
+		// Call f( first_pos, T *values, count ) for each run of present values
+		// in position order.  Runs are split at page boundaries
+		template<typename Function>
+		void for_each_range( Function &&f ) {
+			for( auto page_no : ordered_pages( ) ) {
+				for_each_range_in( page_no, m_index.find( page_no )->second, f );
+			}
+		}
 
+		template<typename Function>
+		void for_each_range( Function &&f ) const {
+			for( auto page_no : ordered_pages( ) ) {
+				page_t const *page = m_index.find( page_no )->second;
+				for_each_range_in( page_no, page, f );
+			}
+		}
+
+		// Call f( pos, value ) for each present value in position order
+		template<typename Function>
+		void for_each( Function &&f ) {
+			for_each_range( [&]( size_t first, T *values, size_t count ) {
+				for( size_t n = 0; n < count; ++n ) {
+					f( first + n, values[n] );
+				}
+			} );
+		}
+
+		template<typename Function>
+		void for_each( Function &&f ) const {
+			for_each_range( [&]( size_t first, T const *values, size_t count ) {
+				for( size_t n = 0; n < count; ++n ) {
+					f( first + n, values[n] );
+				}
+			} );
+		}
+
+		sparse_memory_t memory_usage( ) const noexcept {
+			// A hash node holds the value, a next pointer and possibly the hash
+			constexpr size_t const node_size =
+			  sizeof( typename index_t::value_type ) + 2 * sizeof( void * );
+			sparse_memory_t result{};
+			result.page_count = m_index.size( );
+			result.slots = m_index.size( ) * PageSize;
+			result.present = m_count;
+			result.page_bytes = m_index.size( ) * sizeof( page_t );
+			result.index_bytes = sizeof( index_t ) + m_index.size( ) * node_size +
+			                     m_index.bucket_count( ) * sizeof( void * ) +
+			                     m_order.capacity( ) * sizeof( size_t );
+			return result;
+		}
+
+	private:
+		template<typename Page, typename Function>
+		static void for_each_range_in( size_t page_no, Page *page, Function &f ) {
+			size_t n = 0;
+			while( n < PageSize ) {
+				if( not page->has( n ) ) {
+					++n;
+					continue;
+				}
+				auto const first = n;
+				while( n < PageSize and page->has( n ) ) {
+					++n;
+				}
+				f( page_no * PageSize + first, page->get( first ), n - first );
+			}
+		}
+	}; // class clumpy_sparsy
 } // namespace daw
@@ -0,0 +1,294 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "daw_exception.h"
+#include "daw_span.h"
+#include "impl/daw_filter_impl.h"
+
+namespace daw {
+	template<typename Key, typename Hash, typename Fingerprint, typename Storage>
+	class basic_cuckoo_filter;
+
+	template<typename Key, typename Hash = filter_impl::fnv1a_key_hash,
+	         typename Fingerprint = uint16_t>
+	using cuckoo_filter =
+	  basic_cuckoo_filter<Key, Hash, Fingerprint, std::vector<Fingerprint>>;
+
+	// Read only filter over serialized data, e.g. a memory_mapped_file_t
+	template<typename Key, typename Hash = filter_impl::fnv1a_key_hash,
+	         typename Fingerprint = uint16_t>
+	using cuckoo_filter_view =
+	  basic_cuckoo_filter<Key, Hash, Fingerprint, daw::span<Fingerprint const>>;
+
+	// Cuckoo filter with buckets of 4 fingerprints and partial key cuckoo
+	// hashing.  Unlike a Bloom filter it supports erase, but erasing a key that
+	// was never inserted can remove a colliding key.  The false positive rate is
+	// about 8 / 2^bits( Fingerprint )
+	template<typename Key, typename Hash, typename Fingerprint, typename Storage>
+	class basic_cuckoo_filter {
+		static_assert( std::is_unsigned_v<Fingerprint>,
+		               "Fingerprint must be an unsigned integral type" );
+		static constexpr bool const is_owning =
+		  filter_impl::is_owning_storage_v<Storage>;
+		static constexpr size_t const bucket_size = 4;
+		static constexpr size_t const max_kicks = 500;
+		static constexpr Fingerprint const empty_slot = 0;
+
+		Storage m_slots{};
+		uint64_t m_bucket_mask = 0;
+		uint64_t m_item_count = 0;
+
+		template<typename, typename, typename, typename>
+		friend class basic_cuckoo_filter;
+
+		basic_cuckoo_filter( Storage slots, uint64_t item_count ) noexcept
+		  : m_slots( std::move( slots ) )
+		  , m_bucket_mask( m_slots.size( ) / bucket_size - 1U )
+		  , m_item_count( item_count ) {}
+
+		static uint64_t hash_of( Key const &key ) {
+			return filter_impl::mix64( Hash{}( key ) );
+		}
+
+		static constexpr Fingerprint fingerprint( uint64_t hash ) noexcept {
+			auto const result = static_cast<Fingerprint>( hash >> 32U );
+			return result == empty_slot ? Fingerprint{1} : result;
+		}
+
+		constexpr uint64_t alt_bucket( uint64_t bucket, Fingerprint fp ) const
+		  noexcept {
+			return ( bucket ^ filter_impl::mix64( fp ) ) & m_bucket_mask;
+		}
+
+		bool bucket_contains( uint64_t bucket, Fingerprint fp ) const noexcept {
+			auto const first = bucket * bucket_size;
+			bool result = false;
+			for( size_t n = 0; n < bucket_size; ++n ) {
+				result |= m_slots[first + n] == fp;
+			}
+			return result;
+		}
+
+		bool bucket_add( uint64_t bucket, Fingerprint fp ) noexcept {
+			auto const first = bucket * bucket_size;
+			for( size_t n = 0; n < bucket_size; ++n ) {
+				if( m_slots[first + n] == empty_slot ) {
+					m_slots[first + n] = fp;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool bucket_remove( uint64_t bucket, Fingerprint fp ) noexcept {
+			auto const first = bucket * bucket_size;
+			for( size_t n = 0; n < bucket_size; ++n ) {
+				if( m_slots[first + n] == fp ) {
+					m_slots[first + n] = empty_slot;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool test_hash( uint64_t hash ) const noexcept {
+			auto const fp = fingerprint( hash );
+			auto const b1 = hash & m_bucket_mask;
+			return bucket_contains( b1, fp ) or
+			       bucket_contains( alt_bucket( b1, fp ), fp );
+		}
+
+	public:
+		using key_type = Key;
+		using hasher = Hash;
+		using fingerprint_type = Fingerprint;
+
+		// Size the filter for expected_items keys at a 95% load factor
+		explicit basic_cuckoo_filter( size_t expected_items ) {
+			static_assert( is_owning, "Views can only be created from_bytes" );
+			auto const min_buckets = static_cast<uint64_t>(
+			  std::ceil( static_cast<double>( expected_items ) /
+			             ( 0.95 * static_cast<double>( bucket_size ) ) ) );
+			uint64_t buckets = 1;
+			while( buckets < min_buckets ) {
+				buckets <<= 1U;
+			}
+			m_slots.resize( buckets * bucket_size, empty_slot );
+			m_bucket_mask = buckets - 1U;
+		}
+
+		// Create a read only view over a filter written with serialize.  data must
+		// outlive the view
+		static basic_cuckoo_filter from_bytes( char const *data, size_t size ) {
+			static_assert( !is_owning, "from_bytes creates a cuckoo_filter_view" );
+			auto const header = filter_impl::read_filter_header<Fingerprint>(
+			  data, size, filter_impl::filter_kind::cuckoo );
+			auto const buckets = header.word_count / bucket_size;
+			daw::exception::precondition_check<std::invalid_argument>(
+			  buckets > 0 and ( buckets & ( buckets - 1U ) ) == 0 and
+			    header.word_count % bucket_size == 0,
+			  "Serialized filter has an invalid bucket count" );
+			return basic_cuckoo_filter(
+			  Storage( reinterpret_cast<Fingerprint const *>(
+			             data + sizeof( filter_impl::filter_header_t ) ),
+			           static_cast<size_t>( header.word_count ) ),
+			  header.item_count );
+		}
+
+		cuckoo_filter_view<Key, Hash, Fingerprint> view( ) const noexcept {
+			return {daw::span<Fingerprint const>( m_slots.data( ), m_slots.size( ) ),
+			        m_item_count};
+		}
+
+		// Returns false if the filter is too full to place the key.  The filter is
+		// left unchanged in that case
+		bool insert( Key const &key ) {
+			static_assert( is_owning, "Cannot insert into a cuckoo_filter_view" );
+			auto const hash = hash_of( key );
+			auto fp = fingerprint( hash );
+			auto bucket = hash & m_bucket_mask;
+			if( bucket_add( bucket, fp ) or
+			    bucket_add( alt_bucket( bucket, fp ), fp ) ) {
+				++m_item_count;
+				return true;
+			}
+			// Evict fingerprints along a path, remembering it so that a failed
+			// insert can be rolled back
+			std::vector<std::pair<size_t, Fingerprint>> path{};
+			path.reserve( max_kicks );
+			uint64_t rng = hash;
+			if( ( rng >> 63U ) != 0 ) {
+				bucket = alt_bucket( bucket, fp );
+			}
+			for( size_t kick = 0; kick < max_kicks; ++kick ) {
+				rng ^= rng << 13U;
+				rng ^= rng >> 7U;
+				rng ^= rng << 17U;
+				auto const slot =
+				  static_cast<size_t>( bucket * bucket_size + ( rng % bucket_size ) );
+				path.emplace_back( slot, m_slots[slot] );
+				std::swap( fp, m_slots[slot] );
+				bucket = alt_bucket( bucket, fp );
+				if( bucket_add( bucket, fp ) ) {
+					++m_item_count;
+					return true;
+				}
+			}
+			for( auto it = path.rbegin( ); it != path.rend( ); ++it ) {
+				m_slots[it->first] = it->second;
+			}
+			return false;
+		}
+
+		// Remove one copy of key's fingerprint.  Only erase keys that were inserted
+		bool erase( Key const &key ) {
+			static_assert( is_owning, "Cannot erase from a cuckoo_filter_view" );
+			auto const hash = hash_of( key );
+			auto const fp = fingerprint( hash );
+			auto const bucket = hash & m_bucket_mask;
+			if( bucket_remove( bucket, fp ) or
+			    bucket_remove( alt_bucket( bucket, fp ), fp ) ) {
+				--m_item_count;
+				return true;
+			}
+			return false;
+		}
+
+		bool may_contain( Key const &key ) const {
+			return test_hash( hash_of( key ) );
+		}
+
+		// Test every key, results[n] is the answer for keys[n].  Returns the number
+		// of keys that may be present.  Keys are hashed in batches ahead of the
+		// bucket tests so the hashing does not sit in the dependency chain of the
+		// memory loads
+		size_t may_contain( daw::span<Key const> keys,
+		                    daw::span<bool> results ) const {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  results.size( ) >= keys.size( ), "results is too small" );
+			constexpr size_t const batch_size = 32;
+			uint64_t hashes[batch_size];
+			size_t count = 0;
+			for( size_t first = 0; first < keys.size( ); first += batch_size ) {
+				size_t const last = std::min( keys.size( ), first + batch_size );
+				for( size_t n = first; n < last; ++n ) {
+					hashes[n - first] = hash_of( keys[n] );
+				}
+				for( size_t n = first; n < last; ++n ) {
+					bool const found = test_hash( hashes[n - first] );
+					results[n] = found;
+					count += found ? 1U : 0U;
+				}
+			}
+			return count;
+		}
+
+		void clear( ) {
+			static_assert( is_owning, "Cannot clear a cuckoo_filter_view" );
+			std::fill( m_slots.begin( ), m_slots.end( ), empty_slot );
+			m_item_count = 0;
+		}
+
+		uint64_t item_count( ) const noexcept {
+			return m_item_count;
+		}
+
+		uint64_t capacity( ) const noexcept {
+			return m_slots.size( );
+		}
+
+		double load_factor( ) const noexcept {
+			return static_cast<double>( m_item_count ) /
+			       static_cast<double>( m_slots.size( ) );
+		}
+
+		size_t serialized_size( ) const noexcept {
+			return sizeof( filter_impl::filter_header_t ) +
+			       m_slots.size( ) * sizeof( Fingerprint );
+		}
+
+		// Write a header and the fingerprint table in native byte order.  Read
+		// back with cuckoo_filter_view::from_bytes
+		template<typename OStream>
+		void serialize( OStream &os ) const {
+			filter_impl::filter_header_t header{};
+			header.kind = filter_impl::filter_kind::cuckoo;
+			header.parameter = bucket_size;
+			header.word_size = sizeof( Fingerprint );
+			header.word_count = m_slots.size( );
+			header.item_count = m_item_count;
+			filter_impl::write_filter( os, header, m_slots.data( ) );
+		}
+	};
+} // namespace daw
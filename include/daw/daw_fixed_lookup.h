@@ -22,13 +22,17 @@
 
 #pragma once
 
+#include <algorithm>
 #include <stdexcept>
 #include <type_traits>
 
 #include "daw_bounded_array.h"
 #include "daw_exception.h"
 #include "daw_generic_hash.h"
+#include "daw_hash_stats.h"
 #include "daw_move.h"
+#include "daw_prefetch.h"
+#include "daw_span.h"
 #include "daw_traits.h"
 #include "daw_utility.h"
 
@@ -74,6 +78,7 @@ namespace daw {
 
 		using reference = value_t &;
 		using const_reference = value_t const &;
+		using const_pointer = value_t const *;
 
 	private:
 		daw::bounded_array_t<hash_value_t, N> m_hashes;
@@ -110,7 +115,8 @@ namespace daw {
 			       capacity( );
 		}
 
-		constexpr auto lookup( hash_value_t const hash ) const noexcept {
+		constexpr auto lookup( hash_value_t const hash,
+		                       hash_value_t const hash_pos ) const noexcept {
 			struct lookup_result_t {
 				hash_value_t position;
 				bool found;
@@ -124,7 +130,6 @@ namespace daw {
 				}
 			};
 
-			auto const hash_pos = scale_hash( hash );
 			for( hash_value_t n = hash_pos; n != m_hashes.size( ); ++n ) {
 				if( hash == m_hashes[n] ) {
 					return lookup_result_t{n, true};
@@ -142,6 +147,10 @@ namespace daw {
 			return lookup_result_t{m_hashes.size( ), false};
 		}
 
+		constexpr auto lookup( hash_value_t const hash ) const noexcept {
+			return lookup( hash, scale_hash( hash ) );
+		}
+
 	public:
 		constexpr fixed_lookup( ) noexcept(
 		  noexcept( daw::is_nothrow_default_constructible_v<value_t> ) ) = default;
@@ -191,11 +200,61 @@ namespace daw {
 			return m_values[is_found.position];
 		}
 
+		// Probe lengths and occupancy of the table
+		hash_stats_t stats( ) const {
+			hash_stats_t result{};
+			result.capacity = capacity( );
+			for( hash_value_t n = 0; n < capacity( ); ++n ) {
+				auto const hash = m_hashes[n];
+				if( hash == impl::sentinals::removed ) {
+					++result.tombstones;
+				} else if( hash >= impl::sentinals::sentinals_size ) {
+					result.add_item(
+					  hash_stats_t::displacement( scale_hash( hash ), n, capacity( ) ) );
+				}
+			}
+			return result;
+		}
+
 		template<typename Key>
 		constexpr bool exists( Key &&key ) const noexcept {
 			auto const hash = hash_fn( std::forward<Key>( key ) );
 			return static_cast<bool>( lookup( hash ) );
 		}
+
+		// Look up every key, results[n] points to the value for keys[n] or is
+		// nullptr when it is absent.  Returns the number of keys found.  The home
+		// slots of a group of keys are prefetched before that group is probed
+		template<typename Key>
+		size_t find_many( daw::span<Key const> keys,
+		                  daw::span<const_pointer> results ) const {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  results.size( ) >= keys.size( ), "results is too small" );
+			constexpr size_t const group_size = daw::prefetch_group_size;
+			hash_value_t hashes[group_size];
+			hash_value_t homes[group_size];
+			size_t count = 0;
+			for( size_t first = 0; first < keys.size( ); first += group_size ) {
+				size_t const last = std::min( keys.size( ), first + group_size );
+				for( size_t n = first; n < last; ++n ) {
+					auto const hash = hash_fn( keys[n] );
+					auto const home = scale_hash( hash );
+					hashes[n - first] = hash;
+					homes[n - first] = home;
+					daw::prefetch( &m_hashes[home] );
+				}
+				for( size_t n = first; n < last; ++n ) {
+					auto const is_found = lookup( hashes[n - first], homes[n - first] );
+					if( is_found ) {
+						results[n] = &m_values[is_found.position];
+						++count;
+					} else {
+						results[n] = nullptr;
+					}
+				}
+			}
+			return count;
+		}
 	};
 
 	template<typename Value, size_t HashSize = sizeof( size_t ), typename... Keys>
@@ -27,6 +27,7 @@
 #include <functional>
 #include <iterator>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <type_traits>
 #include <unordered_map>
@@ -39,7 +40,7 @@
 #include "daw_utility.h"
 
 namespace daw {
-	template<typename T>
+	template<typename T, typename Allocator = std::allocator<T>>
 	struct graph_t;
 
 	class node_id_t {
@@ -52,7 +53,7 @@ namespace daw {
 			return m_value;
 		}
 
-		template<typename T>
+		template<typename, typename>
 		friend struct graph_t;
 
 	public:
@@ -93,7 +94,7 @@ namespace std {
 
 namespace daw {
 	namespace graph_impl {
-		template<typename T>
+		template<typename T, typename Allocator = std::allocator<T>>
 		class node_impl_t {
 			node_id_t m_id;
 			T m_value;
@@ -102,16 +103,22 @@ namespace daw {
 			using value_type = T;
 			using reference = value_type &;
 			using const_reference = value_type const &;
-			using edges_t = std::unordered_set<node_id_t>;
+			using edges_t = std::unordered_set<
+			  node_id_t, std::hash<node_id_t>, std::equal_to<node_id_t>,
+			  typename std::allocator_traits<Allocator>::template rebind_alloc<
+			    node_id_t>>;
 
 		private:
-			edges_t m_incoming_edges{};
-			edges_t m_outgoing_edges{};
+			edges_t m_incoming_edges;
+			edges_t m_outgoing_edges;
 
 		public:
-			constexpr node_impl_t( node_id_t id, T &&value ) noexcept
+			node_impl_t( node_id_t id, T &&value,
+			             Allocator const &alloc = Allocator( ) )
 			  : m_id( id )
-			  , m_value( daw::move( value ) ) {
+			  , m_value( daw::move( value ) )
+			  , m_incoming_edges( typename edges_t::allocator_type( alloc ) )
+			  , m_outgoing_edges( typename edges_t::allocator_type( alloc ) ) {
 
 				daw::exception::dbg_precondition_check( id );
 			}
@@ -176,20 +183,21 @@ namespace daw {
 	template<typename T>
 	inline constexpr bool is_graph_node_v = graph_node_proxies<T>::value;
 
-	template<typename T>
+	template<typename T, typename Allocator = std::allocator<T>>
 	class const_graph_node_t {
-		graph_t<T> const *m_graph = nullptr;
+		graph_t<T, Allocator> const *m_graph = nullptr;
 		node_id_t m_node_id{};
 
 	public:
 		using value_type = T;
 		using reference = value_type &;
 		using const_reference = value_type const &;
-		using edges_t = typename graph_impl::node_impl_t<T>::edges_t;
+		using edges_t = typename graph_impl::node_impl_t<T, Allocator>::edges_t;
 
 		constexpr const_graph_node_t( ) noexcept = default;
 
-		const_graph_node_t( graph_t<T> const *graph_ptr, node_id_t Id ) noexcept
+		const_graph_node_t( graph_t<T, Allocator> const *graph_ptr,
+		                    node_id_t Id ) noexcept
 		  : m_graph( graph_ptr )
 		  , m_node_id( Id ) {}
 
@@ -197,7 +205,7 @@ namespace daw {
 			return m_node_id;
 		}
 
-		constexpr graph_t<T> const *graph( ) const noexcept {
+		constexpr graph_t<T, Allocator> const *graph( ) const noexcept {
 			return m_graph;
 		}
 
@@ -253,22 +261,23 @@ namespace daw {
 		}
 	};
 
-	template<typename T>
-	struct graph_node_proxies<const_graph_node_t<T>> : std::true_type {};
-	template<typename T>
+	template<typename T, typename Allocator>
+	struct graph_node_proxies<const_graph_node_t<T, Allocator>>
+	  : std::true_type {};
+	template<typename T, typename Allocator = std::allocator<T>>
 	class graph_node_t {
-		graph_t<T> *m_graph = nullptr;
+		graph_t<T, Allocator> *m_graph = nullptr;
 		node_id_t m_node_id{};
 
 	public:
 		using value_type = T;
 		using reference = value_type &;
 		using const_reference = value_type const &;
-		using edges_t = typename graph_impl::node_impl_t<T>::edges_t;
+		using edges_t = typename graph_impl::node_impl_t<T, Allocator>::edges_t;
 
 		constexpr graph_node_t( ) noexcept = default;
 
-		graph_node_t( graph_t<T> *graph_ptr, node_id_t Id ) noexcept
+		graph_node_t( graph_t<T, Allocator> *graph_ptr, node_id_t Id ) noexcept
 		  : m_graph( graph_ptr )
 		  , m_node_id( Id ) {}
 
@@ -276,7 +285,7 @@ namespace daw {
 			return m_node_id;
 		}
 
-		constexpr graph_t<T> const *graph( ) const noexcept {
+		constexpr graph_t<T, Allocator> const *graph( ) const noexcept {
 			return m_graph;
 		}
 
@@ -349,34 +358,49 @@ namespace daw {
 			return m_node_id < rhs.id( );
 		}
 
-		constexpr operator const_graph_node_t<T>( ) const noexcept {
-			return const_graph_node_t<T>( m_graph, m_node_id );
+		constexpr operator const_graph_node_t<T, Allocator>( ) const noexcept {
+			return const_graph_node_t<T, Allocator>( m_graph, m_node_id );
 		}
 	};
 
-	template<typename T>
-	struct graph_node_proxies<graph_node_t<T>> : std::true_type {};
+	template<typename T, typename Allocator>
+	struct graph_node_proxies<graph_node_t<T, Allocator>> : std::true_type {};
 
-	template<typename T>
+	template<typename T, typename Allocator>
 	struct graph_t {
-		using raw_node_t = graph_impl::node_impl_t<T>;
-		using node_t = graph_node_t<T>;
-		using const_node_t = const_graph_node_t<T>;
+		using raw_node_t = graph_impl::node_impl_t<T, Allocator>;
+		using node_t = graph_node_t<T, Allocator>;
+		using const_node_t = const_graph_node_t<T, Allocator>;
+		using allocator_type = Allocator;
 
 	private:
+		using nodes_t = std::unordered_map<
+		  size_t, raw_node_t, std::hash<size_t>, std::equal_to<size_t>,
+		  typename std::allocator_traits<Allocator>::template rebind_alloc<
+		    std::pair<size_t const, raw_node_t>>>;
+
 		size_t cur_id = 0;
-		std::unordered_map<size_t, raw_node_t> m_nodes{};
+		nodes_t m_nodes;
 
 	public:
-		graph_t( ) noexcept = default;
+		graph_t( ) = default;
+
+		// Nodes and their edge sets are all allocated through alloc
+		explicit graph_t( Allocator const &alloc )
+		  : m_nodes( typename nodes_t::allocator_type( alloc ) ) {}
+
+		allocator_type get_allocator( ) const {
+			return allocator_type( m_nodes.get_allocator( ) );
+		}
 
 		template<typename... Args>
 		node_id_t add_node( Args &&... args ) {
 			auto const id = cur_id++;
 			m_nodes.emplace( std::make_pair(
-			  id, graph_impl::node_impl_t<T>(
+			  id, raw_node_t(
 			        node_id_t{id},
-			        daw::construct_a<T>{}( std::forward<Args>( args )... ) ) ) );
+			        daw::construct_a<T>{}( std::forward<Args>( args )... ),
+			        get_allocator( ) ) ) );
 
 			return node_id_t{id};
 		}
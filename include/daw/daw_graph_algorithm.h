@@ -172,8 +172,10 @@ namespace daw {
 		}
 	} // namespace graph_alg_impl
 
-	template<typename T, typename Compare = daw::graph_alg_impl::NoSort>
-	void mst( daw::graph_t<T> &graph, Compare /*TODO comp*/ = Compare{} ) {
+	template<typename T, typename Allocator,
+	         typename Compare = daw::graph_alg_impl::NoSort>
+	void mst( daw::graph_t<T, Allocator> &graph,
+	          Compare /*TODO comp*/ = Compare{} ) {
 		auto root_ids = graph.find_roots( );
 		for( auto start_node_id : root_ids ) {
 			std::unordered_set<daw::node_id_t> visited{};
@@ -204,10 +206,10 @@ namespace daw {
 		}
 	} // namespace daw
 
-	template<typename T, typename Function,
+	template<typename T, typename Allocator, typename Function,
 	         typename Compare = daw::graph_alg_impl::NoSort>
-	void topological_sorted_walk( daw::graph_t<T> const &graph, Function &&func,
-	                              Compare comp = Compare{} ) {
+	void topological_sorted_walk( daw::graph_t<T, Allocator> const &graph,
+	                              Function &&func, Compare comp = Compare{} ) {
 
 		using Node = std::remove_reference_t<decltype(
 		  graph.get_node( std::declval<daw::node_id_t>( ) ) )>;
@@ -216,10 +218,10 @@ namespace daw {
 		  graph, std::forward<Function>( func ), daw::move( comp ) );
 	}
 
-	template<typename T, typename Function,
+	template<typename T, typename Allocator, typename Function,
 	         typename Compare = daw::graph_alg_impl::NoSort>
-	void topological_sorted_walk( daw::graph_t<T> &graph, Function &&func,
-	                              Compare comp = Compare{} ) {
+	void topological_sorted_walk( daw::graph_t<T, Allocator> &graph,
+	                              Function &&func, Compare comp = Compare{} ) {
 
 		using Node = std::remove_reference_t<decltype(
 		  graph.get_node( std::declval<daw::node_id_t>( ) ) )>;
@@ -228,33 +230,33 @@ namespace daw {
 		  graph, std::forward<Function>( func ), daw::move( comp ) );
 	}
 
-	template<typename T, typename Function>
-	void bfs_walk( daw::graph_t<T> const &graph, daw::node_id_t start_node_id,
-	               Function &&func ) {
+	template<typename T, typename Allocator, typename Function>
+	void bfs_walk( daw::graph_t<T, Allocator> const &graph,
+	               daw::node_id_t start_node_id, Function &&func ) {
 
 		graph_alg_impl::bfs_walk<T>( graph, start_node_id,
 		                             std::forward<Function>( func ) );
 	}
 
-	template<typename T, typename Function>
-	void bfs_walk( daw::graph_t<T> &graph, daw::node_id_t start_node_id,
-	               Function &&func ) {
+	template<typename T, typename Allocator, typename Function>
+	void bfs_walk( daw::graph_t<T, Allocator> &graph,
+	               daw::node_id_t start_node_id, Function &&func ) {
 
 		graph_alg_impl::bfs_walk<T>( graph, start_node_id,
 		                             std::forward<Function>( func ) );
 	}
 
-	template<typename T, typename Function>
-	void dfs_walk( daw::graph_t<T> const &graph, daw::node_id_t start_node_id,
-	               Function &&func ) {
+	template<typename T, typename Allocator, typename Function>
+	void dfs_walk( daw::graph_t<T, Allocator> const &graph,
+	               daw::node_id_t start_node_id, Function &&func ) {
 
 		graph_alg_impl::dfs_walk<T>( graph, start_node_id,
 		                             std::forward<Function>( func ) );
 	}
 
-	template<typename T, typename Function>
-	void dfs_walk( daw::graph_t<T> &graph, daw::node_id_t start_node_id,
-	               Function &&func ) {
+	template<typename T, typename Allocator, typename Function>
+	void dfs_walk( daw::graph_t<T, Allocator> &graph,
+	               daw::node_id_t start_node_id, Function &&func ) {
 
 		graph_alg_impl::dfs_walk<T>( graph, start_node_id,
 		                             std::forward<Function>( func ) );
@@ -22,90 +22,451 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <functional>
-#include <optional>
-#include <vector>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
 
-#include "daw_algorithm.h"
+#include "daw_exception.h"
 
 namespace daw {
-	template<typename Key, typename Hash = std::hash<Key>>
-	class hash_set_t {
-		std::vector<std::optional<Key>> m_indices;
+	namespace impl {
+		namespace hash_set_meta {
+			// Occupied slots store a 7bit fingerprint of the hash with the high bit
+			// set so that most failed probes never have to touch the key array.
+			// moved is only ever found in a table that is being migrated away from
+			enum : uint8_t { empty = 0, moved = 1, occupied = 0x80 };
+		} // namespace hash_set_meta
 
-		static constexpr size_t scale_hash( size_t hash, size_t range_size ) {
-			size_t const prime_a = 18446744073709551557u;
-			size_t const prime_b = 18446744073709551533u;
-			return ( hash * prime_a + prime_b ) % range_size;
-		}
+		// Open addressed, linear probed table that keeps its metadata and its keys
+		// in separate arrays.  Capacity is always a power of 2
+		template<typename Key>
+		class hash_set_table {
+			std::unique_ptr<uint8_t[]> m_meta{};
+			Key *m_keys = nullptr;
+			size_t m_capacity = 0;
+			size_t m_shift = std::numeric_limits<size_t>::digits;
+
+			static constexpr size_t log2( size_t n ) noexcept {
+				size_t result = 0;
+				while( n > 1 ) {
+					n >>= 1U;
+					++result;
+				}
+				return result;
+			}
+
+			void destroy_all( ) noexcept {
+				if( m_keys == nullptr ) {
+					return;
+				}
+				for( size_t n = 0; n < m_capacity; ++n ) {
+					if( is_occupied( n ) ) {
+						m_keys[n].~Key( );
+					}
+				}
+				std::allocator<Key>{}.deallocate( m_keys, m_capacity );
+				m_keys = nullptr;
+			}
+
+		public:
+			static constexpr size_t const npos = std::numeric_limits<size_t>::max( );
+
+			hash_set_table( ) noexcept = default;
+
+			explicit hash_set_table( size_t capacity )
+			  : m_meta( std::make_unique<uint8_t[]>( capacity ) )
+			  , m_keys( std::allocator<Key>{}.allocate( capacity ) )
+			  , m_capacity( capacity )
+			  , m_shift( std::numeric_limits<size_t>::digits - log2( capacity ) ) {}
+
+			hash_set_table( hash_set_table const &other )
+			  : m_meta( std::make_unique<uint8_t[]>( other.m_capacity ) )
+			  , m_keys( std::allocator<Key>{}.allocate( other.m_capacity ) )
+			  , m_capacity( other.m_capacity )
+			  , m_shift( other.m_shift ) {
+
+				try {
+					for( size_t n = 0; n < m_capacity; ++n ) {
+						if( other.is_occupied( n ) ) {
+							new( m_keys + n ) Key( other.m_keys[n] );
+						}
+						m_meta[n] = other.m_meta[n];
+					}
+				} catch( ... ) {
+					destroy_all( );
+					throw;
+				}
+			}
+
+			hash_set_table( hash_set_table &&other ) noexcept
+			  : m_meta( std::move( other.m_meta ) )
+			  , m_keys( std::exchange( other.m_keys, nullptr ) )
+			  , m_capacity( std::exchange( other.m_capacity, 0 ) )
+			  , m_shift( std::exchange( other.m_shift,
+			                            std::numeric_limits<size_t>::digits ) ) {}
+
+			hash_set_table &operator=( hash_set_table const &rhs ) {
+				if( this != &rhs ) {
+					hash_set_table tmp( rhs );
+					swap( tmp );
+				}
+				return *this;
+			}
+
+			hash_set_table &operator=( hash_set_table &&rhs ) noexcept {
+				if( this != &rhs ) {
+					hash_set_table tmp( std::move( rhs ) );
+					swap( tmp );
+				}
+				return *this;
+			}
+
+			~hash_set_table( ) noexcept {
+				destroy_all( );
+			}
+
+			void swap( hash_set_table &rhs ) noexcept {
+				using std::swap;
+				swap( m_meta, rhs.m_meta );
+				swap( m_keys, rhs.m_keys );
+				swap( m_capacity, rhs.m_capacity );
+				swap( m_shift, rhs.m_shift );
+			}
+
+			constexpr size_t capacity( ) const noexcept {
+				return m_capacity;
+			}
 
-		std::optional<size_t> find_index( size_t hash, Key const &key ) const {
-			size_t const scaled_hash = scale_hash( hash, m_indices.size( ) );
+			// Hash must already be mixed, the high bits select the home slot
+			constexpr size_t home( size_t hash ) const noexcept {
+				return hash >> m_shift;
+			}
 
-			for( size_t n = scaled_hash; n < m_indices.size( ); ++n ) {
-				if( !m_indices[n] ) {
-					return n;
+			bool is_occupied( size_t pos ) const noexcept {
+				return m_meta[pos] >= hash_set_meta::occupied;
+			}
+
+			Key &key( size_t pos ) noexcept {
+				return m_keys[pos];
+			}
+
+			Key const &key( size_t pos ) const noexcept {
+				return m_keys[pos];
+			}
+
+			template<typename K, typename KeyEqual>
+			size_t find( size_t hash, uint8_t fingerprint, K const &key,
+			             KeyEqual const &key_equal ) const {
+				if( m_capacity == 0 ) {
+					return npos;
 				}
-				if( *m_indices[n] == key ) {
-					return n;
+				size_t const mask = m_capacity - 1;
+				size_t pos = home( hash );
+				for( size_t n = 0; n < m_capacity; ++n ) {
+					auto const meta = m_meta[pos];
+					if( meta == hash_set_meta::empty ) {
+						return npos;
+					}
+					if( meta == fingerprint and key_equal( m_keys[pos], key ) ) {
+						return pos;
+					}
+					pos = ( pos + 1 ) & mask;
+				}
+				return npos;
+			}
+
+			// Table must not be full, the caller ensures this via the load factor
+			size_t find_empty( size_t hash ) const noexcept {
+				size_t const mask = m_capacity - 1;
+				size_t pos = home( hash );
+				while( m_meta[pos] != hash_set_meta::empty ) {
+					pos = ( pos + 1 ) & mask;
 				}
+				return pos;
 			}
-			for( size_t n = 0; n < scaled_hash; ++n ) {
-				if( !m_indices[n] ) {
-					return n;
+
+			template<typename K>
+			void construct( size_t pos, uint8_t fingerprint, K &&key ) {
+				new( m_keys + pos ) Key( std::forward<K>( key ) );
+				m_meta[pos] = fingerprint;
+			}
+
+			// Mark the slot as moved so that probe chains through it stay intact.
+			// Only valid on a table that is being migrated away from
+			void retire( size_t pos ) noexcept {
+				m_keys[pos].~Key( );
+				m_meta[pos] = hash_set_meta::moved;
+			}
+
+			// Backward shift deletion.  Following elements of the cluster are moved
+			// into the hole when that does not put them before their home slot, so
+			// no tombstones are needed
+			template<typename HashOf>
+			void erase( size_t pos, HashOf hash_of ) {
+				size_t const mask = m_capacity - 1;
+				m_keys[pos].~Key( );
+				m_meta[pos] = hash_set_meta::empty;
+				size_t hole = pos;
+				size_t next = ( hole + 1 ) & mask;
+				while( m_meta[next] != hash_set_meta::empty ) {
+					size_t const next_home = home( hash_of( m_keys[next] ) );
+					if( ( ( next - next_home ) & mask ) >= ( ( next - hole ) & mask ) ) {
+						new( m_keys + hole ) Key( std::move( m_keys[next] ) );
+						m_meta[hole] = m_meta[next];
+						m_keys[next].~Key( );
+						m_meta[next] = hash_set_meta::empty;
+						hole = next;
+					}
+					next = ( next + 1 ) & mask;
 				}
-				if( *m_indices[n] == key ) {
-					return n;
+			}
+
+			template<typename Function>
+			void for_each( Function &&func ) const {
+				for( size_t n = 0; n < m_capacity; ++n ) {
+					if( is_occupied( n ) ) {
+						func( m_keys[n] );
+					}
 				}
 			}
-			return {};
+		};
+	} // namespace impl
+
+	// A growable open addressed set.  Metadata and keys are stored in separate
+	// arrays so that a slot costs sizeof( Key ) + 1 bytes.  When the max load
+	// factor is reached a table of twice the size is allocated and the elements
+	// are migrated a few slots at a time on each following insert/erase, so no
+	// single operation pays for the whole rehash.  Lookups consult both tables
+	// while a migration is in progress.  Use reserve to size the table up front
+	// and avoid having both tables alive at once
+	template<typename Key, typename Hash = std::hash<Key>,
+	         typename KeyEqual = std::equal_to<Key>>
+	class hash_set_t {
+		using table_t = impl::hash_set_table<Key>;
+
+		static constexpr size_t const min_capacity = 8;
+		// Number of slots of the old table migrated per mutating operation
+		static constexpr size_t const migrate_step = 16;
+
+		float m_max_load_factor = 0.75f;
+		table_t m_table;
+		table_t m_old{};
+		size_t m_migrate_pos = 0;
+		size_t m_size = 0;
+
+		static constexpr size_t mix( size_t hash ) noexcept {
+			// Fibonacci hashing, the high bits are used to select the slot
+			return hash * static_cast<size_t>( 0x9E37'79B9'7F4A'7C15ULL );
 		}
 
-	public:
-		hash_set_t( size_t range_size ) noexcept
-		  : m_indices( range_size, std::nullopt ) {}
+		// The middle bits of the hash, the high ones already selected the slot
+		static constexpr size_t const fingerprint_shift =
+		  std::numeric_limits<size_t>::digits / 2U;
 
-		size_t insert( Key const &key ) {
-			auto const hash = Hash{}( key );
-			auto const index = find_index( hash, key );
-			if( !index ) {
-				throw std::out_of_range( "Hash table is full" );
+		static constexpr uint8_t fingerprint( size_t hash ) noexcept {
+			return static_cast<uint8_t>(
+			  impl::hash_set_meta::occupied |
+			  ( ( hash >> fingerprint_shift ) & static_cast<size_t>( 0x7FU ) ) );
+		}
+
+		template<typename K>
+		static size_t hash_of( K const &key ) {
+			return mix( Hash{}( key ) );
+		}
+
+		static constexpr size_t round_up_pow2( size_t n ) noexcept {
+			size_t result = min_capacity;
+			while( result < n ) {
+				result <<= 1U;
+			}
+			return result;
+		}
+
+		size_t capacity_for( size_t count ) const noexcept {
+			return round_up_pow2( static_cast<size_t>(
+			  std::ceil( static_cast<double>( count ) /
+			             static_cast<double>( m_max_load_factor ) ) ) );
+		}
+
+		bool fits( size_t count ) const noexcept {
+			return static_cast<double>( count ) <=
+			       static_cast<double>( m_table.capacity( ) ) *
+			         static_cast<double>( m_max_load_factor );
+		}
+
+		void migrate( size_t slot_count ) {
+			if( m_old.capacity( ) == 0 ) {
+				return;
+			}
+			size_t const last =
+			  std::min( m_old.capacity( ), m_migrate_pos + slot_count );
+			for( ; m_migrate_pos < last; ++m_migrate_pos ) {
+				if( m_old.is_occupied( m_migrate_pos ) ) {
+					auto &key = m_old.key( m_migrate_pos );
+					auto const hash = hash_of( key );
+					m_table.construct( m_table.find_empty( hash ), fingerprint( hash ),
+					                   std::move( key ) );
+					m_old.retire( m_migrate_pos );
+				}
 			}
-			m_indices[*index] = key;
-			return *index;
+			if( m_migrate_pos == m_old.capacity( ) ) {
+				m_old = table_t{};
+				m_migrate_pos = 0;
+			}
+		}
+
+		void finish_migration( ) {
+			migrate( std::numeric_limits<size_t>::max( ) - m_migrate_pos );
+		}
+
+		void grow( size_t new_capacity ) {
+			finish_migration( );
+			m_old = std::move( m_table );
+			m_table = table_t( new_capacity );
+			m_migrate_pos = 0;
+			if( m_size == 0 ) {
+				m_old = table_t{};
+			}
+		}
+
+		template<typename K>
+		bool insert_impl( K &&key ) {
+			auto const hash = hash_of( key );
+			auto const fp = fingerprint( hash );
+			if( m_table.find( hash, fp, key, KeyEqual{} ) != table_t::npos or
+			    m_old.find( hash, fp, key, KeyEqual{} ) != table_t::npos ) {
+				return false;
+			}
+			if( !fits( m_size + 1 ) ) {
+				grow( m_table.capacity( ) * 2 );
+			}
+			m_table.construct( m_table.find_empty( hash ), fp,
+			                   std::forward<K>( key ) );
+			++m_size;
+			migrate( migrate_step );
+			return true;
+		}
+
+	public:
+		using key_type = Key;
+		using value_type = Key;
+		using size_type = size_t;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+
+		hash_set_t( )
+		  : m_table( min_capacity ) {}
+
+		// Sized so that expected_size keys can be inserted without growing
+		explicit hash_set_t( size_t expected_size )
+		  : m_table( capacity_for( expected_size ) ) {}
+
+		hash_set_t( size_t expected_size, float max_load_factor )
+		  : m_max_load_factor( max_load_factor ) {
+
+			daw::exception::precondition_check<std::invalid_argument>(
+			  max_load_factor > 0.0f and max_load_factor <= 0.95f,
+			  "max_load_factor must be in the range (0, 0.95]" );
+			m_table = table_t( capacity_for( expected_size ) );
 		}
 
-		std::optional<size_t> erase( Key const &key ) {
-			auto const hash = Hash{}( key );
-			auto const index = find_index( hash, key );
-			if( !index ) {
-				return {};
+		bool insert( Key const &key ) {
+			return insert_impl( key );
+		}
+
+		bool insert( Key &&key ) {
+			return insert_impl( std::move( key ) );
+		}
+
+		bool erase( Key const &key ) {
+			auto const hash = hash_of( key );
+			auto const fp = fingerprint( hash );
+			auto pos = m_table.find( hash, fp, key, KeyEqual{} );
+			if( pos != table_t::npos ) {
+				m_table.erase( pos, []( Key const &k ) { return hash_of( k ); } );
+			} else {
+				pos = m_old.find( hash, fp, key, KeyEqual{} );
+				if( pos == table_t::npos ) {
+					return false;
+				}
+				m_old.retire( pos );
 			}
-			m_indices[index] = std::nullopt;
-			return index;
+			--m_size;
+			migrate( migrate_step );
+			return true;
+		}
+
+		bool exists( Key const &key ) const {
+			auto const hash = hash_of( key );
+			auto const fp = fingerprint( hash );
+			return m_table.find( hash, fp, key, KeyEqual{} ) != table_t::npos or
+			       m_old.find( hash, fp, key, KeyEqual{} ) != table_t::npos;
+		}
+
+		size_t count( Key const &key ) const {
+			return exists( key ) ? 1U : 0U;
 		}
 
-		bool exists( Key const &key ) const noexcept {
-			auto const hash = Hash{}( key );
-			auto const index = find_index( hash, key );
-			return static_cast<bool>( index ) and
-			       static_cast<bool>( m_indices[*index] );
+		// Ensure that count keys fit without further growth.  This rehashes
+		// immediately instead of incrementally
+		void reserve( size_t count ) {
+			if( !fits( count ) ) {
+				grow( capacity_for( count ) );
+			}
+			finish_migration( );
 		}
 
-		bool count( Key const &key ) const noexcept {
-			return exists( key ) ? 1 : 0;
+		void clear( ) {
+			m_table = table_t( m_table.capacity( ) );
+			m_old = table_t{};
+			m_migrate_pos = 0;
+			m_size = 0;
 		}
 
 		size_t capacity( ) const noexcept {
-			return m_indices.size( );
+			return m_table.capacity( );
 		}
 
 		size_t size( ) const noexcept {
-			return daw::algorithm::accumulate(
-			  std::begin( m_indices ), std::end( m_indices ), 0ULL,
-			  []( auto const &opt ) {
-				  return static_cast<bool>( opt ) ? 1ULL : 0ULL;
-			  } );
+			return m_size;
+		}
+
+		bool empty( ) const noexcept {
+			return m_size == 0;
+		}
+
+		float load_factor( ) const noexcept {
+			return static_cast<float>( m_size ) /
+			       static_cast<float>( m_table.capacity( ) );
+		}
+
+		float max_load_factor( ) const noexcept {
+			return m_max_load_factor;
+		}
+
+		void max_load_factor( float value ) {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  value > 0.0f and value <= 0.95f,
+			  "max_load_factor must be in the range (0, 0.95]" );
+			m_max_load_factor = value;
+			reserve( m_size );
+		}
+
+		// True while elements still live in the previous table
+		bool is_rehashing( ) const noexcept {
+			return m_old.capacity( ) != 0;
+		}
+
+		template<typename Function>
+		void for_each( Function &&func ) const {
+			m_table.for_each( func );
+			m_old.for_each( func );
 		}
 	};
 } // namespace daw
@@ -0,0 +1,118 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace daw {
+	// Layout of a hash container at one point in time.  Containers build it by
+	// scanning their slots, so it costs nothing until asked for.  The resize
+	// figures are only kept when DAW_HASH_STATS is defined, otherwise they stay 0
+	struct hash_stats_t {
+		size_t capacity = 0;
+		size_t size = 0;
+		size_t tombstones = 0;
+		size_t max_displacement = 0;
+		// probe_lengths[n] is the number of items a lookup finds after probing
+		// n + 1 slots, i.e. the items n slots away from their home slot
+		std::vector<size_t> probe_lengths{};
+		size_t resize_count = 0;
+		std::chrono::nanoseconds resize_time{0};
+
+		void add_item( size_t displacement ) {
+			if( displacement >= probe_lengths.size( ) ) {
+				probe_lengths.resize( displacement + 1, 0 );
+			}
+			++probe_lengths[displacement];
+			++size;
+			if( displacement > max_displacement ) {
+				max_displacement = displacement;
+			}
+		}
+
+		// Distance from home to pos in a table of table_size slots where probes
+		// wrap around
+		static constexpr size_t displacement( size_t home, size_t pos,
+		                                      size_t table_size ) noexcept {
+			return pos >= home ? pos - home : table_size - home + pos;
+		}
+
+		double load_factor( ) const noexcept {
+			if( capacity == 0 ) {
+				return 0.0;
+			}
+			return static_cast<double>( size ) / static_cast<double>( capacity );
+		}
+
+		// Mean number of slots a successful lookup reads
+		double average_probe_length( ) const noexcept {
+			if( size == 0 ) {
+				return 0.0;
+			}
+			size_t total = 0;
+			for( size_t n = 0; n < probe_lengths.size( ); ++n ) {
+				total += probe_lengths[n] * ( n + 1 );
+			}
+			return static_cast<double>( total ) / static_cast<double>( size );
+		}
+	};
+
+#if defined( DAW_HASH_STATS )
+	namespace impl {
+		struct resize_stats_t {
+			size_t count = 0;
+			std::chrono::nanoseconds time{0};
+
+			void copy_to( hash_stats_t &stats ) const noexcept {
+				stats.resize_count = count;
+				stats.resize_time = time;
+			}
+		};
+
+		// Adds the time until destruction to stats, and counts a resize when
+		// is_new_resize is set
+		class resize_timer_t {
+			resize_stats_t *m_stats;
+			std::chrono::steady_clock::time_point m_start;
+
+		public:
+			resize_timer_t( resize_stats_t &stats, bool is_new_resize ) noexcept
+			  : m_stats( &stats )
+			  , m_start( std::chrono::steady_clock::now( ) ) {
+				if( is_new_resize ) {
+					++m_stats->count;
+				}
+			}
+
+			resize_timer_t( resize_timer_t const & ) = delete;
+			resize_timer_t &operator=( resize_timer_t const & ) = delete;
+
+			~resize_timer_t( ) {
+				m_stats->time += std::chrono::steady_clock::now( ) - m_start;
+			}
+		};
+	} // namespace impl
+#endif
+} // namespace daw
@@ -22,13 +22,18 @@
 
 #pragma once
 
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
 #include <type_traits>
 
 #include "daw_exception.h"
 #include "daw_fnv1a_hash.h"
+#include "daw_hash_stats.h"
 #include "daw_heap_array.h"
 #include "daw_move.h"
+#include "daw_prefetch.h"
+#include "daw_span.h"
 #include "daw_swap.h"
 #include "daw_traits.h"
 
@@ -69,19 +74,65 @@ namespace daw {
 		};
 	} // namespace resize_policies
 
+	namespace rehash_modes {
+		// Move every element to the new arrays as soon as a resize is needed
+		struct all_at_once {};
+
+		// Keep the old arrays after a resize and move MigrateCount of their slots
+		// on each insert.  Lookups consult both until the old arrays are drained.
+		// A resize also starts once resize_ratio percent of the slots are used,
+		// so that misses in the old arrays stay short
+		template<size_t MigrateCount = 64>
+		struct incremental {
+			static_assert( MigrateCount > 0, "Must migrate at least one slot" );
+			static constexpr size_t migrate_count = MigrateCount;
+		};
+	} // namespace rehash_modes
+
+	namespace impl {
+		template<typename RehashMode>
+		inline constexpr bool is_incremental_rehash_v = false;
+
+		template<size_t MigrateCount>
+		inline constexpr bool
+		  is_incremental_rehash_v<rehash_modes::incremental<MigrateCount>> = true;
+	} // namespace impl
+
 	template<typename Value, size_t m_initial_size = 11,
 	         uint8_t resize_ratio = 80,
-	         typename ResizePolicy = resize_policies::golden_ratio>
+	         typename ResizePolicy = resize_policies::golden_ratio,
+	         typename RehashMode = rehash_modes::all_at_once,
+	         typename Allocator = std::allocator<Value>>
 	struct hash_table {
 		static_assert( m_initial_size > 0,
 		               "Must supply a positive initial_size larger than 0" );
 		using value_type = daw::traits::root_type_t<Value>;
 		using reference = value_type &;
 		using const_reference = value_type const &;
+		using pointer = value_type *;
+		using const_pointer = value_type const *;
+		using allocator_type = Allocator;
+
+		static constexpr bool is_incremental =
+		  impl::is_incremental_rehash_v<RehashMode>;
 
 	private:
-		daw::heap_array<size_t> m_hashes;
-		daw::heap_array<value_type> m_values;
+		template<typename T>
+		using rebind_alloc_t =
+		  typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+		using hashes_t = daw::heap_array<size_t, rebind_alloc_t<size_t>>;
+		using values_t = daw::heap_array<value_type, rebind_alloc_t<value_type>>;
+
+		hashes_t m_hashes;
+		values_t m_values;
+		// Slots not yet moved by an incremental resize, empty otherwise
+		hashes_t m_old_hashes;
+		values_t m_old_values;
+		size_t m_migrate_pos = 0;
+		size_t m_item_count = 0;
+#if defined( DAW_HASH_STATS )
+		impl::resize_stats_t m_resize_stats{};
+#endif
 
 		static constexpr size_t max_size( ) noexcept {
 			return static_cast<size_t>( std::numeric_limits<ptrdiff_t>::max( ) - 1 );
@@ -108,7 +159,9 @@ namespace daw {
 			return ( hash * prime_a + prime_b ) % table_size;
 		}
 
-		constexpr auto lookup( size_t const hash ) const {
+		static constexpr auto lookup_in( hashes_t const &hashes,
+		                                 size_t const hash,
+		                                 size_t const s_hash ) {
 			struct lookup_result_t {
 				size_t position;
 				size_t lookup_cost;
@@ -123,62 +176,212 @@ namespace daw {
 				}
 			};
 			lookup_result_t result;
-			auto const s_hash = scale_hash( hash, m_hashes.size( ) );
 			result.position = s_hash;
 			size_t removed_found =
 			  std::numeric_limits<size_t>::max( ); // Need a check and this will be
 			                                       // rare
-			for( ; result.position != m_hashes.size( ); ++result.position ) {
-				if( m_hashes[result.position] == hash ) {
+			for( ; result.position != hashes.size( ); ++result.position ) {
+				if( hashes[result.position] == hash ) {
 					result.found = true;
 					result.lookup_cost = result.position - s_hash;
 					return result;
-				} else if( m_hashes[result.position] == impl::sentinals::empty ) {
+				} else if( hashes[result.position] == impl::sentinals::empty ) {
 					result.lookup_cost = result.position - s_hash;
 					return result;
-				} else if( m_hashes[result.position] == impl::sentinals::removed &&
+				} else if( hashes[result.position] == impl::sentinals::removed &&
 				           result.position < removed_found ) {
 					removed_found = result.position;
 				}
 			}
 			result.position = 0;
 			for( ; result.position != s_hash; ++result.position ) {
-				if( m_hashes[result.position] == hash ) {
+				if( hashes[result.position] == hash ) {
 					result.found = true;
-					result.lookup_cost =
-					  ( m_hashes.size( ) - s_hash ) + result.position - s_hash;
+					result.lookup_cost = ( hashes.size( ) - s_hash ) + result.position;
 					return result;
-				} else if( m_hashes[result.position] == impl::sentinals::empty ) {
-					result.lookup_cost =
-					  ( m_hashes.size( ) - s_hash ) + result.position - s_hash;
+				} else if( hashes[result.position] == impl::sentinals::empty ) {
+					result.lookup_cost = ( hashes.size( ) - s_hash ) + result.position;
 					return result;
-				} else if( m_hashes[result.position] == impl::sentinals::removed &&
+				} else if( hashes[result.position] == impl::sentinals::removed &&
 				           result.position < removed_found ) {
 					removed_found = result.position;
 				}
 			}
 			if( removed_found < std::numeric_limits<size_t>::max( ) ) {
-				result.lookup_cost = m_hashes.size( );
+				result.lookup_cost = hashes.size( );
 				result.position = removed_found;
 				return result;
 			}
-			result.position = m_hashes.size( ); // Indicate that there are no empty or
-			                                    // removed cells, table is full
+			result.position = hashes.size( ); // Indicate that there are no empty or
+			                                  // removed cells, table is full
 			return result;
 		}
 
+		constexpr auto lookup( size_t const hash, size_t const s_hash ) const {
+			return lookup_in( m_hashes, hash, s_hash );
+		}
+
+		constexpr auto lookup( size_t const hash ) const {
+			return lookup( hash, scale_hash( hash, m_hashes.size( ) ) );
+		}
+
+		constexpr bool is_migrating( ) const noexcept {
+			return !m_old_hashes.empty( );
+		}
+
+		// Position of hash in the old arrays, or their size when it is not there
+		size_t find_old( size_t const hash, size_t const s_hash ) const {
+			auto const is_found = lookup_in( m_old_hashes, hash, s_hash );
+			return is_found ? is_found.position : m_old_hashes.size( );
+		}
+
+		size_t find_old( size_t const hash ) const {
+			return find_old( hash, scale_hash( hash, m_old_hashes.size( ) ) );
+		}
+
+		const_pointer find_value( size_t const hash, size_t const s_hash,
+		                          size_t const old_s_hash ) const {
+			if( auto const is_found = lookup( hash, s_hash ); is_found ) {
+				return m_values.data( ) + is_found.position;
+			}
+			if constexpr( is_incremental ) {
+				if( is_migrating( ) ) {
+					auto const pos = find_old( hash, old_s_hash );
+					if( pos != m_old_hashes.size( ) ) {
+						return m_old_values.data( ) + pos;
+					}
+				}
+			}
+			return nullptr;
+		}
+
+		const_pointer find_value( size_t const hash ) const {
+			return find_value( hash, scale_hash( hash, m_hashes.size( ) ),
+			                   is_migrating( )
+			                     ? scale_hash( hash, m_old_hashes.size( ) )
+			                     : 0 );
+		}
+
+		// Claim a slot for hash in the current arrays.  The new arrays are larger
+		// than the old ones, so this cannot run out of space while migrating
+		size_t place_hash( size_t const hash ) {
+			auto const is_found = lookup( hash );
+			daw::exception::daw_throw_on_true(
+			  !is_found and is_found.position == m_hashes.size( ),
+			  "Hash table is full" );
+			m_hashes[is_found.position] = hash;
+			return is_found.position;
+		}
+
+		// Move the entry in old slot pos to the current arrays and return its new
+		// position.  The old slot becomes removed so later probes pass over it
+		size_t migrate_slot( size_t const pos ) {
+			auto const new_pos = place_hash( m_old_hashes[pos] );
+			m_values[new_pos] = daw::move( m_old_values[pos] );
+			m_old_hashes[pos] = impl::sentinals::removed;
+			return new_pos;
+		}
+
+		void migrate( size_t count ) {
+			auto const last =
+			  std::min( m_old_hashes.size( ), m_migrate_pos + count );
+			for( ; m_migrate_pos < last; ++m_migrate_pos ) {
+				if( m_old_hashes[m_migrate_pos] >= impl::sentinals::sentinals_size ) {
+					migrate_slot( m_migrate_pos );
+				}
+			}
+			if( m_migrate_pos == m_old_hashes.size( ) ) {
+				m_old_hashes.clear( );
+				m_old_values.clear( );
+				m_migrate_pos = 0;
+			}
+		}
+
+		// One bounded migration step, as done by each insert
+		void migrate_step( ) {
+#if defined( DAW_HASH_STATS )
+			impl::resize_timer_t timer( m_resize_stats, false );
+#endif
+			migrate( RehashMode::migrate_count );
+		}
+
+		void finish_migration( ) {
+			if( is_migrating( ) ) {
+				migrate( m_old_hashes.size( ) );
+			}
+		}
+
+		// Find or claim the slot for hash, growing the table when it is full or
+		// the probe was too long
+		size_t insert_hash( size_t const hash ) {
+			if constexpr( is_incremental ) {
+				if( is_migrating( ) ) {
+					auto const pos = find_old( hash );
+					if( pos != m_old_hashes.size( ) ) {
+						auto const new_pos = migrate_slot( pos );
+						migrate_step( );
+						return new_pos;
+					}
+					migrate_step( );
+				}
+			}
+			auto is_found = lookup( hash );
+			if( ( !is_found and is_found.position == m_hashes.size( ) ) or
+			    should_resize( is_found.lookup_cost, m_hashes.size( ) ) or
+			    ( is_incremental and !is_found and
+			      should_resize( m_item_count + 1, m_hashes.size( ) ) ) ) {
+				resize_tables( );
+				is_found = lookup( hash );
+			}
+			if( !is_found ) {
+				m_hashes[is_found.position] = hash;
+				++m_item_count;
+			}
+			return is_found.position;
+		}
+
 		void resize_tables( size_t new_size ) {
-			hash_table new_tbl{new_size};
+#if defined( DAW_HASH_STATS )
+			impl::resize_timer_t timer( m_resize_stats, true );
+#endif
+			finish_migration( );
+			hash_table new_tbl( new_size, get_allocator( ) );
 			for( size_t n = 0; n < m_hashes.size( ); ++n ) {
 				if( m_hashes[n] >= impl::sentinals::sentinals_size ) {
-					new_tbl[m_hashes[n]] = daw::move( m_values[n] );
+					new_tbl.m_values[new_tbl.insert_hash( m_hashes[n] )] =
+					  daw::move( m_values[n] );
 				}
 			}
+			new_tbl.finish_migration( );
 			daw::cswap( *this, new_tbl );
+#if defined( DAW_HASH_STATS )
+			m_resize_stats = new_tbl.m_resize_stats;
+#endif
+		}
+
+		// Swap in empty arrays of new_size and leave the current ones to be
+		// drained by later inserts
+		void start_migration( size_t new_size ) {
+#if defined( DAW_HASH_STATS )
+			impl::resize_timer_t timer( m_resize_stats, true );
+#endif
+			finish_migration( );
+			hashes_t hashes( new_size, impl::sentinals::empty,
+			                 m_hashes.get_allocator( ) );
+			values_t values( new_size, m_values.get_allocator( ) );
+			m_old_hashes.swap( m_hashes );
+			m_old_values.swap( m_values );
+			m_hashes.swap( hashes );
+			m_values.swap( values );
+			m_migrate_pos = 0;
 		}
 
 		void resize_tables( ) {
-			resize_tables( ResizePolicy{}( m_hashes.size( ) ) );
+			if constexpr( is_incremental ) {
+				start_migration( ResizePolicy{}( m_hashes.size( ) ) );
+			} else {
+				resize_tables( ResizePolicy{}( m_hashes.size( ) ) );
+			}
 		}
 
 		static constexpr bool should_resize( size_t lookup_cost,
@@ -189,57 +392,139 @@ namespace daw {
 
 	public:
 		hash_table( )
-		  : m_hashes{m_initial_size, impl::sentinals::empty}
-		  , m_values{m_initial_size} {
+		  : hash_table( m_initial_size ) {}
 
-			daw::exception::daw_throw_on_false( m_hashes.size( ) > 0 );
-			daw::exception::daw_throw_on_false( m_values.size( ) > 0 );
-		}
+		explicit hash_table( Allocator const &alloc )
+		  : hash_table( m_initial_size, alloc ) {}
 
-		hash_table( size_t initial_size )
-		  : m_hashes{initial_size, impl::sentinals::empty}
-		  , m_values( initial_size ) {
+		hash_table( size_t initial_size, Allocator const &alloc = Allocator( ) )
+		  : m_hashes( initial_size, impl::sentinals::empty,
+		              rebind_alloc_t<size_t>( alloc ) )
+		  , m_values( initial_size, rebind_alloc_t<value_type>( alloc ) )
+		  , m_old_hashes( rebind_alloc_t<size_t>( alloc ) )
+		  , m_old_values( rebind_alloc_t<value_type>( alloc ) ) {
 
 			daw::exception::daw_throw_on_false( m_hashes.size( ) > 0 );
 			daw::exception::daw_throw_on_false( m_values.size( ) > 0 );
 		}
 
+		allocator_type get_allocator( ) const {
+			return allocator_type( m_values.get_allocator( ) );
+		}
+
 		void swap( hash_table &rhs ) noexcept {
 			daw::cswap( m_hashes, rhs.m_hashes );
 			daw::cswap( m_values, rhs.m_values );
+			daw::cswap( m_old_hashes, rhs.m_old_hashes );
+			daw::cswap( m_old_values, rhs.m_old_values );
+			daw::cswap( m_migrate_pos, rhs.m_migrate_pos );
+			daw::cswap( m_item_count, rhs.m_item_count );
+#if defined( DAW_HASH_STATS )
+			daw::cswap( m_resize_stats, rhs.m_resize_stats );
+#endif
 		}
 
 		template<typename Key>
 		const_reference operator[]( Key const &key ) const {
-			auto const hash = hash_fn<Key>( key );
-			auto const is_found = lookup( hash );
+			auto const value = find_value( hash_fn<Key>( key ) );
 
 			daw::exception::precondition_check<std::out_of_range>(
-			  is_found, "Attempt to access an undefined key" );
+			  value != nullptr, "Attempt to access an undefined key" );
 
-			return m_values[is_found.position];
+			return *value;
 		}
 
 		template<typename Key>
 		reference operator[]( Key const &key ) {
-			auto const hash = hash_fn<Key>( key );
-			auto is_found = lookup( hash );
-			if( ( !is_found and is_found.position == m_hashes.size( ) ) or
-			    should_resize( is_found.lookup_cost, m_hashes.size( ) ) ) {
-				resize_tables( );
-				is_found = lookup( hash );
+			return m_values[insert_hash( hash_fn<Key>( key ) )];
+		}
+
+		template<typename Key>
+		bool exists( Key const &key ) const {
+			return find_value( hash_fn<Key>( key ) ) != nullptr;
+		}
+
+		// True while an incremental resize still has entries in the old arrays
+		constexpr bool is_rehashing( ) const noexcept {
+			return is_migrating( );
+		}
+
+		// Look up every key, results[n] points to the value for keys[n] or is
+		// nullptr when it is absent.  Returns the number of keys found.  Keys are
+		// hashed and their home slots prefetched a group at a time before any
+		// probing, so the cache misses of a group overlap instead of forming one
+		// dependent chain per key
+		template<typename Key>
+		size_t find_many( daw::span<Key const> keys,
+		                  daw::span<const_pointer> results ) const {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  results.size( ) >= keys.size( ), "results is too small" );
+			constexpr size_t const group_size = daw::prefetch_group_size;
+			size_t hashes[group_size];
+			size_t homes[group_size];
+			size_t old_homes[group_size] = {};
+			bool const migrating = is_migrating( );
+			size_t count = 0;
+			for( size_t first = 0; first < keys.size( ); first += group_size ) {
+				size_t const last = std::min( keys.size( ), first + group_size );
+				for( size_t n = first; n < last; ++n ) {
+					auto const hash = hash_fn<Key>( keys[n] );
+					auto const home = scale_hash( hash, m_hashes.size( ) );
+					hashes[n - first] = hash;
+					homes[n - first] = home;
+					daw::prefetch( m_hashes.data( ) + home );
+					if( migrating ) {
+						auto const old_home = scale_hash( hash, m_old_hashes.size( ) );
+						old_homes[n - first] = old_home;
+						daw::prefetch( m_old_hashes.data( ) + old_home );
+					}
+				}
+				for( size_t n = first; n < last; ++n ) {
+					auto const idx = n - first;
+					results[n] = find_value( hashes[idx], homes[idx], old_homes[idx] );
+					count += results[n] != nullptr ? 1U : 0U;
+				}
 			}
-			return m_values[is_found.position];
+			return count;
 		}
 
 		void shrink_to_fit( ) {
-			size_t item_count = 0;
-			for( auto const &hash : m_hashes ) {
-				if( hash >= impl::sentinals::sentinals_size ) {
-					++item_count;
+			resize_tables( m_item_count );
+		}
+
+		// Probe lengths and occupancy of the table.  While an incremental resize
+		// is running the figures cover both the new and the old arrays
+		hash_stats_t stats( ) const {
+			hash_stats_t result{};
+			auto const add_arrays = [&]( hashes_t const &hashes ) {
+				result.capacity += hashes.size( );
+				for( size_t n = 0; n < hashes.size( ); ++n ) {
+					auto const hash = hashes[n];
+					if( hash == impl::sentinals::removed ) {
+						++result.tombstones;
+					} else if( hash >= impl::sentinals::sentinals_size ) {
+						result.add_item( hash_stats_t::displacement(
+						  scale_hash( hash, hashes.size( ) ), n, hashes.size( ) ) );
+					}
 				}
+			};
+			add_arrays( m_hashes );
+			if( is_migrating( ) ) {
+				add_arrays( m_old_hashes );
 			}
-			resize_tables( item_count );
+#if defined( DAW_HASH_STATS )
+			m_resize_stats.copy_to( result );
+#endif
+			return result;
 		}
 	};
+
+	template<typename Value, size_t m_initial_size, uint8_t resize_ratio,
+	         typename ResizePolicy, typename RehashMode, typename Allocator>
+	void swap( hash_table<Value, m_initial_size, resize_ratio, ResizePolicy,
+	                      RehashMode, Allocator> &lhs,
+	           hash_table<Value, m_initial_size, resize_ratio, ResizePolicy,
+	                      RehashMode, Allocator> &rhs ) noexcept {
+		lhs.swap( rhs );
+	}
 } // namespace daw
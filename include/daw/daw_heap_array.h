@@ -23,67 +23,165 @@
 #pragma once
 
 #include <algorithm>
+#include <initializer_list>
+#include <memory>
+#include <new>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 
 #include "daw_exception.h"
 #include "daw_swap.h"
 
 namespace daw {
-	template<typename T>
+	// Construct the elements with default initialization instead of value
+	// initialization.  Trivial types are left indeterminate and their memory is
+	// not written
+	struct default_init_t {};
+	inline constexpr default_init_t const default_init{};
+
+	// Do not construct the elements at all.  Only for trivial types
+	struct uninitialized_t {};
+	inline constexpr uninitialized_t const uninitialized{};
+
+	// Fixed size array allocated through Allocator.  One element more than size
+	// is allocated as a sentinel for find_first_of
+	template<typename T, typename Allocator = std::allocator<T>>
 	struct heap_array {
 		using value_type = T;
 		using reference = T &;
 		using const_reference = T const &;
 		using iterator = T *;
 		using const_iterator = T const *;
+		using allocator_type = Allocator;
 
 	private:
+		using alloc_traits = std::allocator_traits<Allocator>;
+
+		allocator_type m_alloc;
 		value_type *m_begin = nullptr;
 		value_type *m_end = nullptr;
 		size_t m_size = 0;
 
-		static value_type *create_value( size_t n ) {
+		value_type *allocate_value( size_t n ) {
 			try {
-				return new value_type[n];
-			} catch( std::bad_alloc const & ) { std::terminate( ); } catch( ... ) {
+				return alloc_traits::allocate( m_alloc, n + 1 );
+			} catch( std::bad_alloc const & ) { std::terminate( ); }
+		}
+
+		// Allocate n + 1 elements and construct each with
+		// init( ptr, index ) exactly once
+		template<typename Init>
+		value_type *create_value( size_t n, Init init ) {
+			value_type *result = allocate_value( n );
+			size_t constructed = 0;
+			try {
+				for( ; constructed <= n; ++constructed ) {
+					init( result + constructed, constructed );
+				}
+			} catch( ... ) {
+				destroy_value( result, constructed );
+				alloc_traits::deallocate( m_alloc, result, n + 1 );
 				return nullptr;
 			}
+			return result;
+		}
+
+		// Allocate and value initialize n + 1 elements
+		value_type *create_value( size_t n ) {
+			return create_value( n, [&]( value_type *ptr, size_t ) {
+				alloc_traits::construct( m_alloc, ptr );
+			} );
+		}
+
+		// Allocate n + 1 elements, copy constructing the first n from first
+		template<typename Iterator>
+		value_type *create_value_copy( size_t n, Iterator first ) {
+			return create_value( n, [&]( value_type *ptr, size_t idx ) {
+				if( idx < n ) {
+					alloc_traits::construct( m_alloc, ptr, *first );
+					++first;
+				} else {
+					alloc_traits::construct( m_alloc, ptr );
+				}
+			} );
+		}
+
+		void destroy_value( value_type *ptr, size_t count ) noexcept {
+			while( count > 0 ) {
+				--count;
+				alloc_traits::destroy( m_alloc, ptr + count );
+			}
 		}
 
 	public:
-		constexpr heap_array( ) noexcept = default;
+		constexpr heap_array( ) noexcept( noexcept( Allocator( ) ) ) = default;
 
-		heap_array( size_t Size )
-		  : m_begin( create_value( Size + 1 ) )
+		explicit constexpr heap_array( Allocator const &alloc ) noexcept
+		  : m_alloc( alloc ) {}
+
+		heap_array( size_t Size, Allocator const &alloc = Allocator( ) )
+		  : m_alloc( alloc )
+		  , m_begin( create_value( Size ) )
 		  , m_end( m_begin + Size )
 		  , m_size( Size ) {}
 
-		heap_array( size_t Size, value_type const &def_value )
-		  : heap_array( Size ) {
+		heap_array( size_t Size, value_type const &def_value,
+		            Allocator const &alloc = Allocator( ) )
+		  : m_alloc( alloc )
+		  , m_begin( create_value( Size, [&]( value_type *ptr, size_t ) {
+			  alloc_traits::construct( m_alloc, ptr, def_value );
+		  } ) )
+		  , m_end( m_begin + Size )
+		  , m_size( Size ) {}
 
-			std::fill( m_begin, m_end, def_value );
+		heap_array( size_t Size, default_init_t,
+		            Allocator const &alloc = Allocator( ) )
+		  : m_alloc( alloc )
+		  , m_begin( create_value( Size, []( value_type *ptr, size_t ) {
+			  ::new( static_cast<void *>( ptr ) ) value_type;
+		  } ) )
+		  , m_end( m_begin + Size )
+		  , m_size( Size ) {}
+
+		// The elements must be written before being read
+		heap_array( size_t Size, uninitialized_t,
+		            Allocator const &alloc = Allocator( ) )
+		  : m_alloc( alloc )
+		  , m_begin( allocate_value( Size ) )
+		  , m_end( m_begin + Size )
+		  , m_size( Size ) {
+
+			static_assert( std::is_trivially_default_constructible_v<value_type> and
+			                 std::is_trivially_destructible_v<value_type>,
+			               "uninitialized storage requires a trivial type" );
 		}
 
 		constexpr heap_array( heap_array &&other ) noexcept
-		  : m_begin( daw::exchange( other.m_begin, nullptr ) )
-		  , m_end( daw::exchange( other.m_begin, nullptr ) )
+		  : m_alloc( other.m_alloc )
+		  , m_begin( daw::exchange( other.m_begin, nullptr ) )
+		  , m_end( daw::exchange( other.m_end, nullptr ) )
 		  , m_size( daw::exchange( other.m_size, 0ULL ) ) {}
 
-		constexpr heap_array &operator=( heap_array &&rhs ) noexcept {
-			m_begin = daw::exchange( rhs.m_begin, nullptr );
-			m_end = daw::exchange( rhs.m_end, nullptr );
-			m_size = daw::exchange( rhs.m_size, 0ULL );
+		heap_array &operator=( heap_array &&rhs ) noexcept {
+			if( this != &rhs ) {
+				clear( );
+				m_alloc = rhs.m_alloc;
+				m_begin = daw::exchange( rhs.m_begin, nullptr );
+				m_end = daw::exchange( rhs.m_end, nullptr );
+				m_size = daw::exchange( rhs.m_size, 0ULL );
+			}
 			return *this;
 		}
 
 		heap_array( heap_array const &other )
-		  : m_begin( other.m_size == 0 ? nullptr : create_value( other.m_size ) )
-		  , m_end( other.m_size == 0 ? nullptr : m_begin + other.m_size )
-		  , m_size( other.m_size ) {
-
-			std::copy_n( other.m_begin, m_size, m_begin );
-		}
+		  : m_alloc( alloc_traits::select_on_container_copy_construction(
+		      other.m_alloc ) )
+		  , m_begin( other.m_begin == nullptr
+		               ? nullptr
+		               : create_value_copy( other.m_size, other.m_begin ) )
+		  , m_end( m_begin == nullptr ? nullptr : m_begin + other.m_size )
+		  , m_size( other.m_size ) {}
 
 		heap_array &operator=( heap_array const &rhs ) {
 			if( this != &rhs ) {
@@ -92,38 +190,41 @@ namespace daw {
 					return *this;
 				}
 				m_size = rhs.m_size;
-				m_begin = create_value( m_size );
+				m_begin = create_value_copy( m_size, rhs.m_begin );
 				m_end = m_begin + m_size;
-				std::copy_n( rhs.m_begin, m_size, m_begin );
 			}
 			return *this;
 		}
 
 		heap_array &operator=( std::initializer_list<value_type> const &values ) {
-			heap_array tmp( values.size( ) );
-			std::copy_n( values.begin( ), values.size( ), tmp.m_begin );
+			heap_array tmp( m_alloc );
+			tmp.m_begin = tmp.create_value_copy( values.size( ), values.begin( ) );
+			tmp.m_end = tmp.m_begin + values.size( );
+			tmp.m_size = values.size( );
 			daw::cswap( *this, tmp );
 			return *this;
 		}
 
-		heap_array( iterator arry, size_t Size )
-		  : m_begin( create_value( Size ) )
+		heap_array( iterator arry, size_t Size,
+		            Allocator const &alloc = Allocator( ) )
+		  : m_alloc( alloc )
+		  , m_begin( create_value_copy( Size, arry ) )
 		  , m_end( m_begin + Size )
-		  , m_size( Size ) {
-
-			std::copy_n( arry, Size, m_begin );
-		}
+		  , m_size( Size ) {}
 
-		constexpr void clear( ) noexcept {
+		void clear( ) noexcept {
 			if( nullptr != m_begin ) {
 				auto tmp = daw::exchange( m_begin, nullptr );
-				m_size = 0;
+				auto const count = daw::exchange( m_size, 0ULL ) + 1;
 				m_end = nullptr;
-				delete[] tmp;
+				destroy_value( tmp, count );
+				alloc_traits::deallocate( m_alloc, tmp, count );
 			}
 		}
 
-		constexpr void swap( heap_array &rhs ) noexcept {
+		void swap( heap_array &rhs ) noexcept {
+			using std::swap;
+			swap( m_alloc, rhs.m_alloc );
 			daw::cswap( m_begin, rhs.m_begin );
 			daw::cswap( m_end, rhs.m_end );
 			daw::cswap( m_size, rhs.m_size );
@@ -133,6 +234,10 @@ namespace daw {
 			clear( );
 		}
 
+		allocator_type get_allocator( ) const {
+			return m_alloc;
+		}
+
 		explicit constexpr operator bool( ) const noexcept {
 			return nullptr == m_begin;
 		}
@@ -235,9 +340,9 @@ namespace daw {
 		}
 	}; // struct heap_array
 
-	template<typename T>
-	constexpr void swap( daw::heap_array<T> &lhs,
-	                     daw::heap_array<T> &rhs ) noexcept {
+	template<typename T, typename Allocator>
+	void swap( daw::heap_array<T, Allocator> &lhs,
+	           daw::heap_array<T, Allocator> &rhs ) noexcept {
 		lhs.swap( rhs );
 	}
 } // namespace daw
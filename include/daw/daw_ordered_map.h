@@ -23,10 +23,14 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <stdexcept>
-#include <vector>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "daw_algorithm.h"
 #include "daw_enable_if.h"
@@ -90,15 +94,25 @@ namespace daw {
 
 		template<typename Container>
 		decltype( auto ) sizer( Container &&c ) noexcept {
-			using std::size;
-			return size( c );
+			// Qualified, daw::size is found by ADL through a daw allocator
+			return std::size( c );
 		}
+
+		template<typename Hash, typename Key>
+		inline constexpr bool is_hashable_v =
+		  std::is_default_constructible_v<Hash>
+		    and std::is_invocable_r_v<size_t, Hash const &, Key const &>;
 	} // namespace ordered_map_impl
-	// Use linear searching for key, keep values in insertion order
+
+	// Keep values in insertion order.  Small maps use linear searching for key.
+	// When Hash can hash Key, a side index of key hash -> position is built
+	// once the map grows past index_threshold items and find/insert become O(1).
+	// Hash must agree with the equivalence defined by Compare.  Keys must not be
+	// modified through iterators while indexed
 	template<typename Key, typename Value, typename Compare = std::less<Key>,
 	         typename Allocator = std::allocator<std::pair<Key, Value>>,
-	         typename Container =
-	           std::vector<std::pair<Key, Value>, Allocator>>
+	         typename Container = std::vector<std::pair<Key, Value>, Allocator>,
+	         typename Hash = std::hash<Key>>
 	struct ordered_map {
 		using key_type = Key;
 		using mapped_type = Value;
@@ -107,6 +121,7 @@ namespace daw {
 		using size_type = typename values_type::size_type;
 		using difference_type = typename values_type::difference_type;
 		using key_compare = Compare;
+		using hasher = Hash;
 		using allocator_type = Allocator;
 		using reference = mapped_type &;
 		using const_reference = mapped_type const &;
@@ -117,9 +132,117 @@ namespace daw {
 		using reverse_iterator = typename values_type::reverse_iterator;
 		using const_reverse_iterator = typename values_type::const_reverse_iterator;
 
+		static constexpr size_type const index_threshold = 32;
+
 	private:
+		static constexpr bool const has_index =
+		  ordered_map_impl::is_hashable_v<Hash, Key>;
+		static constexpr size_type const npos =
+		  std::numeric_limits<size_type>::max( );
+
 		values_type m_values{};
 		key_compare m_compare{};
+		// Open addressed, linear probed table of positions in m_values.  Empty
+		// until the map grows past index_threshold
+		std::vector<size_type, typename std::allocator_traits<
+		                         Allocator>::template rebind_alloc<size_type>>
+		  m_index{};
+		size_type m_index_shift = 0;
+
+		template<typename K>
+		constexpr bool is_equal( Key const &lhs, K const &rhs ) const {
+			return !m_compare( lhs, rhs ) and !m_compare( rhs, lhs );
+		}
+
+		template<typename K>
+		size_type index_home( K const &key ) const {
+			// Fibonacci hashing, the high bits select the slot
+			return ( static_cast<size_type>( Hash{}( key ) ) *
+			         static_cast<size_type>( 0x9E37'79B9'7F4A'7C15ULL ) ) >>
+			       m_index_shift;
+		}
+
+		template<typename K>
+		size_type index_find( K const &key ) const {
+			size_type const mask = m_index.size( ) - 1;
+			size_type slot = index_home( key );
+			while( m_index[slot] != npos ) {
+				if( is_equal( m_values[m_index[slot]].first, key ) ) {
+					return m_index[slot];
+				}
+				slot = ( slot + 1 ) & mask;
+			}
+			return npos;
+		}
+
+		void index_add( size_type pos ) {
+			size_type const mask = m_index.size( ) - 1;
+			size_type slot = index_home( m_values[pos].first );
+			while( m_index[slot] != npos ) {
+				slot = ( slot + 1 ) & mask;
+			}
+			m_index[slot] = pos;
+		}
+
+		void rebuild_index( ) {
+			size_type index_size = 64;
+			size_type shift = std::numeric_limits<size_type>::digits - 6;
+			while( index_size < size( ) * 2 ) {
+				index_size *= 2;
+				--shift;
+			}
+			m_index.assign( index_size, npos );
+			m_index_shift = shift;
+			for( size_type n = 0; n < size( ); ++n ) {
+				index_add( n );
+			}
+		}
+
+		// Called after a value is appended to m_values
+		void index_appended( ) {
+			if constexpr( has_index ) {
+				if( m_index.empty( ) ) {
+					if( size( ) > index_threshold ) {
+						rebuild_index( );
+					}
+				} else if( size( ) * 2 > m_index.size( ) ) {
+					rebuild_index( );
+				} else {
+					index_add( size( ) - 1 );
+				}
+			}
+		}
+
+		// Called before the value at pos is erased from m_values.  Removes the
+		// entry with backward shift deletion and moves later positions down
+		void index_erasing( size_type pos ) {
+			if constexpr( has_index ) {
+				if( m_index.empty( ) ) {
+					return;
+				}
+				size_type const mask = m_index.size( ) - 1;
+				size_type hole = index_home( m_values[pos].first );
+				while( m_index[hole] != pos ) {
+					hole = ( hole + 1 ) & mask;
+				}
+				m_index[hole] = npos;
+				size_type next = ( hole + 1 ) & mask;
+				while( m_index[next] != npos ) {
+					size_type const home = index_home( m_values[m_index[next]].first );
+					if( ( ( next - home ) & mask ) >= ( ( next - hole ) & mask ) ) {
+						m_index[hole] = m_index[next];
+						m_index[next] = npos;
+						hole = next;
+					}
+					next = ( next + 1 ) & mask;
+				}
+				for( auto &p : m_index ) {
+					if( p != npos and p > pos ) {
+						--p;
+					}
+				}
+			}
+		}
 
 	public:
 		constexpr iterator begin( ) noexcept {
@@ -215,43 +338,72 @@ namespace daw {
 
 		constexpr void clear( ) {
 			m_values.clear( );
+			m_index.clear( );
 		}
+
+		constexpr bool is_indexed( ) const noexcept {
+			return !m_index.empty( );
+		}
+
 		template<typename K>
 		constexpr iterator find( K const &key ) {
-			return daw::algorithm::find_if( begin( ), end( ),
-			                                [&]( auto const &item ) {
-				                                return !m_compare( item.first, key ) and
-				                                       !m_compare( key, item.first );
-			                                } );
+			if constexpr( has_index and ordered_map_impl::is_hashable_v<Hash, K> ) {
+				if( !m_index.empty( ) ) {
+					auto const pos = index_find( key );
+					if( pos == npos ) {
+						return end( );
+					}
+					return std::next( begin( ), static_cast<difference_type>( pos ) );
+				}
+			}
+			return daw::algorithm::find_if(
+			  begin( ), end( ),
+			  [&]( auto const &item ) { return is_equal( item.first, key ); } );
 		}
 
 		template<typename K>
 		constexpr const_iterator find( K const &key ) const {
-			return daw::algorithm::find_if( begin( ), end( ),
-			                                [&]( auto const &item ) {
-				                                return !m_compare( item.first, key ) and
-				                                       !m_compare( key, item.first );
-			                                } );
+			if constexpr( has_index and ordered_map_impl::is_hashable_v<Hash, K> ) {
+				if( !m_index.empty( ) ) {
+					auto const pos = index_find( key );
+					if( pos == npos ) {
+						return end( );
+					}
+					return std::next( begin( ), static_cast<difference_type>( pos ) );
+				}
+			}
+			return daw::algorithm::find_if(
+			  begin( ), end( ),
+			  [&]( auto const &item ) { return is_equal( item.first, key ); } );
+		}
+
+		template<typename K>
+		constexpr size_type count( K const &key ) const {
+			return find( key ) == end( ) ? 0U : 1U;
 		}
 
 		constexpr ordered_map( ) = default;
 
+		explicit constexpr ordered_map( allocator_type const &alloc )
+		  : m_values( alloc )
+		  , m_index( alloc ) {}
+
 		constexpr ordered_map( key_compare const &comp,
 		                       allocator_type const &alloc )
 		  : m_values( alloc )
-		  , m_compare( comp ) {}
+		  , m_compare( comp )
+		  , m_index( alloc ) {}
 
 		template<typename InputIterator>
 		constexpr ordered_map( InputIterator first, InputIterator last,
 		                       key_compare const &comp = key_compare{},
 		                       allocator_type const &alloc = allocator_type{} )
-		  : m_compare( comp )
-		  , m_values( alloc ) {
+		  : m_values( alloc )
+		  , m_compare( comp )
+		  , m_index( alloc ) {
 
 			while( first != last ) {
-				if( auto pos = find( *first ); pos == end( ) ) {
-					m_values.insert( pos, *first );
-				}
+				insert( *first );
 				++first;
 			}
 		}
@@ -259,12 +411,11 @@ namespace daw {
 		template<typename InputIterator>
 		constexpr ordered_map( InputIterator first, InputIterator last,
 		                       allocator_type const &alloc = allocator_type{} )
-		  : m_values( alloc ) {
+		  : m_values( alloc )
+		  , m_index( alloc ) {
 
 			while( first != last ) {
-				if( auto pos = find( *first ); pos == end( ) ) {
-					m_values.insert( pos, *first );
-				}
+				insert( *first );
 				++first;
 			}
 		}
@@ -273,26 +424,28 @@ namespace daw {
 		                       key_compare const &comp,
 		                       allocator_type const &alloc )
 		  : m_values( alloc )
-		  , m_compare( comp ) {
+		  , m_compare( comp )
+		  , m_index( alloc ) {
 
 			for( auto const &value : init ) {
-				if( auto pos = find( value ); pos == end( ) ) {
-					m_values.insert( pos, value );
-				}
+				insert( value );
 			}
 		}
 
 		constexpr ordered_map( std::initializer_list<value_type> init,
 		                       allocator_type const &alloc )
-		  : m_values( alloc ) {
+		  : m_values( alloc )
+		  , m_index( alloc ) {
 
 			for( auto const &value : init ) {
-				if( auto pos = find( value ); pos == end( ) ) {
-					m_values.insert( pos, value );
-				}
+				insert( value );
 			}
 		}
 
+		allocator_type get_allocator( ) const {
+			return allocator_type( m_values.get_allocator( ) );
+		}
+
 		template<typename K>
 		constexpr iterator lower_bound( K const &x ) {
 			return daw::algorithm::lower_bound(
@@ -314,9 +467,10 @@ namespace daw {
 		constexpr std::pair<iterator, bool> insert( P &&value ) {
 			auto pos = find( std::get<0>( value ) );
 			if( pos == end( ) ) {
-				pos = m_values.insert(
+				m_values.insert(
 				  pos, daw::construct_a<value_type>{}( std::forward<P>( value ) ) );
-				return {pos, true};
+				index_appended( );
+				return {std::prev( end( ) ), true};
 			}
 			return {pos, false};
 		}
@@ -324,12 +478,33 @@ namespace daw {
 		constexpr std::pair<iterator, bool> insert( value_type const &value ) {
 			auto pos = find( value.first );
 			if( pos == end( ) ) {
-				pos = m_values.insert( pos, value );
-				return {pos, true};
+				m_values.insert( pos, value );
+				index_appended( );
+				return {std::prev( end( ) ), true};
 			}
 			return {pos, false};
 		}
 
+		constexpr iterator erase( const_iterator pos ) {
+			index_erasing(
+			  static_cast<size_type>( std::distance( cbegin( ), pos ) ) );
+			return m_values.erase( pos );
+		}
+
+		constexpr iterator erase( iterator pos ) {
+			return erase( const_iterator( pos ) );
+		}
+
+		template<typename K>
+		constexpr size_type erase( K const &key ) {
+			auto pos = find( key );
+			if( pos == end( ) ) {
+				return 0;
+			}
+			erase( const_iterator( pos ) );
+			return 1;
+		}
+
 		template<typename K>
 		constexpr reference operator[]( K const &key ) {
 			auto pos = find( key );
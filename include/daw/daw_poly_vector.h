@@ -22,9 +22,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
 #include <vector>
 
 #include "daw_common_mixins.h"
+#include "daw_exception.h"
 #include "daw_heap_value.h"
 
 namespace daw {
@@ -43,4 +53,343 @@ namespace daw {
 			return m_values;
 		}
 	}; // poly_vector_t
+
+	namespace poly_collection_impl {
+		template<typename Base>
+		class segment_base {
+			size_t m_stride;
+
+		protected:
+			explicit segment_base( size_t stride ) noexcept
+			  : m_stride( stride ) {}
+
+		public:
+			segment_base( segment_base const & ) = default;
+			segment_base &operator=( segment_base const & ) = default;
+			virtual ~segment_base( ) = default;
+
+			// A copy of the segment, or nullptr when its type cannot be copied
+			virtual std::unique_ptr<segment_base> clone( ) const = 0;
+			virtual size_t size( ) const noexcept = 0;
+			virtual void clear( ) noexcept = 0;
+			virtual size_t erase_if( bool ( *pred )( void *, Base const & ),
+			                         void *state ) = 0;
+
+			// The Base subobject of the first element.  Later ones are stride( )
+			// bytes apart, as every element has the same most derived type
+			virtual Base *base_data( ) noexcept = 0;
+
+			size_t stride( ) const noexcept {
+				return m_stride;
+			}
+		};
+
+		template<typename Base, typename T>
+		class segment final : public segment_base<Base> {
+		public:
+			std::vector<T> values;
+
+			segment( )
+			  : segment_base<Base>( sizeof( T ) ) {}
+
+			std::unique_ptr<segment_base<Base>> clone( ) const override {
+				if constexpr( std::is_copy_constructible_v<T> ) {
+					return std::make_unique<segment>( *this );
+				} else {
+					return nullptr;
+				}
+			}
+
+			size_t size( ) const noexcept override {
+				return values.size( );
+			}
+
+			void clear( ) noexcept override {
+				values.clear( );
+			}
+
+			size_t erase_if( bool ( *pred )( void *, Base const & ),
+			                 void *state ) override {
+				auto pos = std::remove_if(
+				  values.begin( ), values.end( ),
+				  [&]( T const &value ) { return pred( state, value ); } );
+				auto const count =
+				  static_cast<size_t>( std::distance( pos, values.end( ) ) );
+				values.erase( pos, values.end( ) );
+				return count;
+			}
+
+			Base *base_data( ) noexcept override {
+				return values.empty( ) ? nullptr
+				                       : static_cast<Base *>( values.data( ) );
+			}
+		};
+	} // namespace poly_collection_impl
+
+	// Polymorphic collection that stores each concrete type in a contiguous
+	// array of its own instead of a heap allocation per element.  Iteration is
+	// segment by segment, so elements are not kept in insertion order.  Passing
+	// the concrete types to for_each/erase_if gives the callable the concrete
+	// type, allowing calls to be devirtualized when the type is final.
+	// Inserting into a segment can invalidate references to its elements
+	template<typename Base>
+	class poly_collection {
+		using segment_base_t = poly_collection_impl::segment_base<Base>;
+
+		template<typename T>
+		using segment_t = poly_collection_impl::segment<Base, T>;
+
+		std::vector<std::pair<std::type_index, std::unique_ptr<segment_base_t>>>
+		  m_segments;
+
+		template<typename T>
+		static constexpr void validate_type( ) noexcept {
+			static_assert( std::is_base_of_v<Base, T>, "T must derive from Base" );
+			static_assert( std::is_same_v<T, std::decay_t<T>>,
+			               "T must be an unqualified object type" );
+		}
+
+		segment_base_t *find_segment( std::type_index idx ) const noexcept {
+			for( auto const &seg : m_segments ) {
+				if( seg.first == idx ) {
+					return seg.second.get( );
+				}
+			}
+			return nullptr;
+		}
+
+		template<typename T>
+		segment_t<T> *find_segment( ) const noexcept {
+			validate_type<T>( );
+			return static_cast<segment_t<T> *>( find_segment( typeid( T ) ) );
+		}
+
+		template<typename T>
+		segment_t<T> &get_segment( ) {
+			if( auto seg = find_segment<T>( ); seg != nullptr ) {
+				return *seg;
+			}
+			auto seg = std::make_unique<segment_t<T>>( );
+			auto &result = *seg;
+			m_segments.emplace_back( typeid( T ), std::move( seg ) );
+			return result;
+		}
+
+		// Storing a T that is really a more derived type would slice it
+		template<typename T>
+		static void check_exact_type( T const &value ) {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  typeid( value ) == typeid( T ),
+			  "Value's dynamic type must match its static type" );
+		}
+
+		template<typename T, typename Func>
+		static void for_each_in( segment_t<T> *seg, Func &f ) {
+			if( seg != nullptr ) {
+				for( auto &value : seg->values ) {
+					f( value );
+				}
+			}
+		}
+
+	public:
+		poly_collection( ) = default;
+		poly_collection( poly_collection && ) noexcept = default;
+		poly_collection &operator=( poly_collection && ) noexcept = default;
+		~poly_collection( ) = default;
+
+		poly_collection( poly_collection const &other ) {
+			m_segments.reserve( other.m_segments.size( ) );
+			for( auto const &seg : other.m_segments ) {
+				auto copy = seg.second->clone( );
+				daw::exception::precondition_check<std::invalid_argument>(
+				  copy != nullptr, "Cannot copy a segment of a move only type" );
+				m_segments.emplace_back( seg.first, std::move( copy ) );
+			}
+		}
+
+		poly_collection &operator=( poly_collection const &rhs ) {
+			if( this != &rhs ) {
+				poly_collection tmp( rhs );
+				m_segments = std::move( tmp.m_segments );
+			}
+			return *this;
+		}
+
+		template<typename T, typename... Args>
+		T &emplace( Args &&... args ) {
+			return get_segment<T>( ).values.emplace_back(
+			  std::forward<Args>( args )... );
+		}
+
+		template<typename U>
+		std::decay_t<U> &insert( U &&value ) {
+			using T = std::decay_t<U>;
+			check_exact_type<T>( value );
+			return get_segment<T>( ).values.emplace_back( std::forward<U>( value ) );
+		}
+
+		// Append a range of one concrete type to its segment
+		template<typename Iterator>
+		void insert( Iterator first, Iterator last ) {
+			using traits = std::iterator_traits<Iterator>;
+			using T = typename traits::value_type;
+			auto &values = get_segment<T>( ).values;
+			if constexpr( std::is_base_of_v<std::forward_iterator_tag,
+			                                typename traits::iterator_category> ) {
+				values.reserve( values.size( ) +
+				                static_cast<size_t>( std::distance( first, last ) ) );
+			}
+			for( ; first != last; ++first ) {
+				check_exact_type<T>( *first );
+				values.push_back( *first );
+			}
+		}
+
+		template<typename T>
+		void reserve( size_t count ) {
+			get_segment<T>( ).values.reserve( count );
+		}
+
+		size_t size( ) const noexcept {
+			size_t result = 0;
+			for( auto const &seg : m_segments ) {
+				result += seg.second->size( );
+			}
+			return result;
+		}
+
+		template<typename T>
+		size_t size( ) const noexcept {
+			auto seg = find_segment<T>( );
+			return seg == nullptr ? 0U : seg->values.size( );
+		}
+
+		bool empty( ) const noexcept {
+			return size( ) == 0;
+		}
+
+		// Number of concrete types that have been stored
+		size_t segment_count( ) const noexcept {
+			return m_segments.size( );
+		}
+
+		void clear( ) noexcept {
+			for( auto &seg : m_segments ) {
+				seg.second->clear( );
+			}
+		}
+
+		template<typename T>
+		void clear( ) noexcept {
+			if( auto seg = find_segment<T>( ); seg != nullptr ) {
+				seg->values.clear( );
+			}
+		}
+
+		template<typename T>
+		T *begin( ) noexcept {
+			auto seg = find_segment<T>( );
+			return seg == nullptr ? nullptr : seg->values.data( );
+		}
+
+		template<typename T>
+		T const *begin( ) const noexcept {
+			auto seg = find_segment<T>( );
+			return seg == nullptr ? nullptr : seg->values.data( );
+		}
+
+		template<typename T>
+		T *end( ) noexcept {
+			auto seg = find_segment<T>( );
+			return seg == nullptr ? nullptr
+			                      : seg->values.data( ) + seg->values.size( );
+		}
+
+		template<typename T>
+		T const *end( ) const noexcept {
+			auto seg = find_segment<T>( );
+			return seg == nullptr ? nullptr
+			                      : seg->values.data( ) + seg->values.size( );
+		}
+
+		// Erase [first, last) from T's segment
+		template<typename T>
+		T *erase( T const *first, T const *last ) {
+			auto seg = find_segment<T>( );
+			daw::exception::precondition_check<std::out_of_range>(
+			  seg != nullptr, "No elements of that type are stored" );
+			auto &values = seg->values;
+			T const *const data = values.data( );
+			auto pos = values.erase( values.begin( ) + ( first - data ),
+			                         values.begin( ) + ( last - data ) );
+			return values.data( ) + std::distance( values.begin( ), pos );
+		}
+
+		// With no types given, f is called with Base & for every element.
+		// Otherwise only the segments of Ts... are visited, with f called with
+		// the concrete type
+		template<typename... Ts, typename Func>
+		void for_each( Func &&f ) {
+			if constexpr( sizeof...( Ts ) == 0 ) {
+				for( auto &seg : m_segments ) {
+					auto ptr = reinterpret_cast<char *>( seg.second->base_data( ) );
+					auto const stride = seg.second->stride( );
+					auto const count = seg.second->size( );
+					for( size_t n = 0; n < count; ++n ) {
+						f( *reinterpret_cast<Base *>( ptr + n * stride ) );
+					}
+				}
+			} else {
+				( for_each_in<Ts>( find_segment<Ts>( ), f ), ... );
+			}
+		}
+
+		template<typename... Ts, typename Func>
+		void for_each( Func &&f ) const {
+			if constexpr( sizeof...( Ts ) == 0 ) {
+				for( auto const &seg : m_segments ) {
+					auto ptr = reinterpret_cast<char const *>( seg.second->base_data( ) );
+					auto const stride = seg.second->stride( );
+					auto const count = seg.second->size( );
+					for( size_t n = 0; n < count; ++n ) {
+						f( *reinterpret_cast<Base const *>( ptr + n * stride ) );
+					}
+				}
+			} else {
+				auto const_f = [&]( auto const &value ) { f( value ); };
+				( for_each_in<Ts>( find_segment<Ts>( ), const_f ), ... );
+			}
+		}
+
+		// Erase the elements pred returns true for.  As with for_each, Ts...
+		// restricts the segments visited and gives pred the concrete type
+		template<typename... Ts, typename Predicate>
+		size_t erase_if( Predicate &&pred ) {
+			size_t result = 0;
+			if constexpr( sizeof...( Ts ) == 0 ) {
+				auto invoke = [&pred]( Base const &value ) -> bool {
+					return pred( value );
+				};
+				auto call = []( void *state, Base const &value ) -> bool {
+					return ( *static_cast<decltype( invoke ) *>( state ) )( value );
+				};
+				for( auto &seg : m_segments ) {
+					result += seg.second->erase_if( call, &invoke );
+				}
+			} else {
+				auto erase_in = [&]( auto *seg ) {
+					if( seg != nullptr ) {
+						auto &values = seg->values;
+						auto pos = std::remove_if( values.begin( ), values.end( ), pred );
+						auto const last = values.end( );
+						result += static_cast<size_t>( std::distance( pos, last ) );
+						values.erase( pos, last );
+					}
+				};
+				( erase_in( find_segment<Ts>( ) ), ... );
+			}
+			return result;
+		}
+	}; // poly_collection
 } // namespace daw
@@ -0,0 +1,48 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+
+#if defined( _MSC_VER ) and !defined( __clang__ )
+#include <intrin.h>
+#endif
+
+namespace daw {
+	// Hint that the cache line holding ptr will be read soon.  Used by the batch
+	// lookups of the hash containers to start several independent loads before
+	// any of them is needed
+	template<typename T>
+	inline void prefetch( T const *ptr ) noexcept {
+#if defined( __GNUC__ ) or defined( __clang__ )
+		__builtin_prefetch( static_cast<void const *>( ptr ), 0, 3 );
+#elif defined( _MSC_VER ) and ( defined( _M_X64 ) or defined( _M_IX86 ) )
+		_mm_prefetch( reinterpret_cast<char const *>( ptr ), _MM_HINT_T0 );
+#else
+		static_cast<void>( ptr );
+#endif
+	}
+
+	// Number of lookups whose loads are kept in flight together
+	inline constexpr size_t const prefetch_group_size = 16;
+} // namespace daw
@@ -0,0 +1,532 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "daw_exception.h"
+
+namespace daw {
+	// A type that can be moved to a new address by copying its bytes, with
+	// nothing left to destroy at the old address.  Specialize for types that are
+	// not trivially copyable but still relocate bitwise, such as unique_ptr
+	template<typename T>
+	struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+	template<typename T>
+	inline constexpr bool is_trivially_relocatable_v =
+	  is_trivially_relocatable<T>::value;
+
+	template<typename T, typename Deleter>
+	struct is_trivially_relocatable<std::unique_ptr<T, Deleter>>
+	  : is_trivially_relocatable<Deleter> {};
+
+	// Vector that keeps up to N elements inline and moves them to memory from
+	// Allocator when it grows past that.  Elements are relocated with memcpy
+	// when is_trivially_relocatable_v<T> is true
+	template<typename T, size_t N, typename Allocator = std::allocator<T>>
+	class small_vector {
+		static_assert( N > 0, "Inline capacity must be greater than 0" );
+
+	public:
+		using value_type = T;
+		using reference = value_type &;
+		using const_reference = value_type const &;
+		using iterator = value_type *;
+		using const_iterator = value_type const *;
+		using pointer = value_type *;
+		using const_pointer = value_type const *;
+		using size_type = size_t;
+		using difference_type = intmax_t;
+		using allocator_type = Allocator;
+
+	private:
+		using alloc_traits = std::allocator_traits<Allocator>;
+
+		allocator_type m_alloc{};
+		pointer m_data = inline_data( );
+		size_type m_size = 0;
+		size_type m_capacity = N;
+		alignas( value_type ) unsigned char m_inline[sizeof( value_type ) * N];
+
+		pointer inline_data( ) noexcept {
+			return reinterpret_cast<pointer>( m_inline );
+		}
+
+		template<typename... Args>
+		static pointer construct_at( pointer ptr, Args &&... args ) {
+			if constexpr( std::is_constructible_v<value_type, Args...> ) {
+				return ::new( static_cast<void *>( ptr ) )
+				  value_type( std::forward<Args>( args )... );
+			} else {
+				return ::new( static_cast<void *>( ptr ) )
+				  value_type{std::forward<Args>( args )...};
+			}
+		}
+
+		// Move count elements from src to the uninitialized dest and end the
+		// lifetime of the originals
+		static void relocate( pointer src, size_type count, pointer dest ) {
+			if constexpr( is_trivially_relocatable_v<value_type> ) {
+				if( count > 0 ) {
+					std::memcpy( static_cast<void *>( dest ),
+					             static_cast<void const *>( src ),
+					             count * sizeof( value_type ) );
+				}
+			} else {
+				if constexpr( std::is_nothrow_move_constructible_v<value_type> or
+				              not std::is_copy_constructible_v<value_type> ) {
+					std::uninitialized_move_n( src, count, dest );
+				} else {
+					std::uninitialized_copy_n( src, count, dest );
+				}
+				std::destroy_n( src, count );
+			}
+		}
+
+		void release_heap( ) noexcept {
+			if( not is_inline( ) ) {
+				alloc_traits::deallocate( m_alloc, m_data, m_capacity );
+				m_data = inline_data( );
+				m_capacity = N;
+			}
+		}
+
+		size_type next_capacity( size_type min_capacity ) const {
+			daw::exception::precondition_check<std::length_error>(
+			  min_capacity <= max_size( ), "small_vector is too large" );
+			auto const doubled =
+			  m_capacity <= max_size( ) / 2 ? m_capacity * 2 : max_size( );
+			return doubled > min_capacity ? doubled : min_capacity;
+		}
+
+		void reallocate( size_type new_capacity ) {
+			pointer ptr = alloc_traits::allocate( m_alloc, new_capacity );
+			try {
+				relocate( m_data, m_size, ptr );
+			} catch( ... ) {
+				alloc_traits::deallocate( m_alloc, ptr, new_capacity );
+				throw;
+			}
+			release_heap( );
+			m_data = ptr;
+			m_capacity = new_capacity;
+		}
+
+		// Take other's elements, other must be empty afterwards.  When the
+		// allocators cannot share memory the elements are moved one at a time
+		void steal( small_vector &other ) {
+			if( not other.is_inline( ) and m_alloc == other.m_alloc ) {
+				m_data = std::exchange( other.m_data, other.inline_data( ) );
+				m_capacity = std::exchange( other.m_capacity, N );
+				m_size = std::exchange( other.m_size, 0 );
+				return;
+			}
+			reserve( other.m_size );
+			relocate( other.m_data, other.m_size, m_data );
+			m_size = std::exchange( other.m_size, 0 );
+			other.release_heap( );
+		}
+
+		template<typename... Args>
+		reference grow_emplace_back( Args &&... args ) {
+			auto const new_capacity = next_capacity( m_size + 1 );
+			pointer ptr = alloc_traits::allocate( m_alloc, new_capacity );
+			// Construct the new element first, args may refer to an element
+			try {
+				construct_at( ptr + m_size, std::forward<Args>( args )... );
+			} catch( ... ) {
+				alloc_traits::deallocate( m_alloc, ptr, new_capacity );
+				throw;
+			}
+			try {
+				relocate( m_data, m_size, ptr );
+			} catch( ... ) {
+				std::destroy_at( ptr + m_size );
+				alloc_traits::deallocate( m_alloc, ptr, new_capacity );
+				throw;
+			}
+			release_heap( );
+			m_data = ptr;
+			m_capacity = new_capacity;
+			return m_data[m_size++];
+		}
+
+	public:
+		small_vector( ) noexcept( noexcept( Allocator( ) ) ) {}
+
+		explicit small_vector( Allocator const &alloc ) noexcept
+		  : m_alloc( alloc ) {}
+
+		small_vector( const_pointer ptr, size_type count,
+		              Allocator const &alloc = Allocator( ) )
+		  : m_alloc( alloc ) {
+
+			push_back( ptr, count );
+		}
+
+		small_vector( size_type count, const_reference value,
+		              Allocator const &alloc = Allocator( ) )
+		  : m_alloc( alloc ) {
+
+			reserve( count );
+			std::uninitialized_fill_n( m_data, count, value );
+			m_size = count;
+		}
+
+		small_vector( std::initializer_list<value_type> values,
+		              Allocator const &alloc = Allocator( ) )
+		  : m_alloc( alloc ) {
+
+			push_back( values.begin( ), values.size( ) );
+		}
+
+		small_vector( small_vector const &other )
+		  : m_alloc( alloc_traits::select_on_container_copy_construction(
+		      other.m_alloc ) ) {
+
+			push_back( other.data( ), other.size( ) );
+		}
+
+		small_vector( small_vector &&other ) noexcept(
+		  is_trivially_relocatable_v<value_type> or
+		  std::is_nothrow_move_constructible_v<value_type> )
+		  : m_alloc( other.m_alloc ) {
+
+			steal( other );
+		}
+
+		small_vector &operator=( small_vector const &rhs ) {
+			if( this != &rhs ) {
+				clear( );
+				if constexpr( alloc_traits::propagate_on_container_copy_assignment::
+				                value ) {
+					release_heap( );
+					m_alloc = rhs.m_alloc;
+				}
+				push_back( rhs.data( ), rhs.size( ) );
+			}
+			return *this;
+		}
+
+		// Only an allocator that comes along with rhs's, or is always equal to
+		// it, can take rhs's heap storage without allocating
+		small_vector &operator=( small_vector &&rhs ) noexcept(
+		  ( alloc_traits::propagate_on_container_move_assignment::value or
+		    alloc_traits::is_always_equal::value ) and
+		  ( is_trivially_relocatable_v<value_type> or
+		    std::is_nothrow_move_constructible_v<value_type> ) ) {
+			if( this != &rhs ) {
+				clear( );
+				release_heap( );
+				if constexpr( alloc_traits::propagate_on_container_move_assignment::
+				                value ) {
+					m_alloc = rhs.m_alloc;
+				}
+				steal( rhs );
+			}
+			return *this;
+		}
+
+		~small_vector( ) {
+			clear( );
+			release_heap( );
+		}
+
+		void swap( small_vector &rhs ) {
+			small_vector tmp = std::move( rhs );
+			rhs = std::move( *this );
+			*this = std::move( tmp );
+		}
+
+		allocator_type get_allocator( ) const {
+			return m_alloc;
+		}
+
+		// Are the elements stored in the object itself
+		bool is_inline( ) const noexcept {
+			return m_data == reinterpret_cast<const_pointer>( m_inline );
+		}
+
+		bool empty( ) const noexcept {
+			return m_size == 0;
+		}
+
+		bool full( ) const noexcept {
+			return m_size == m_capacity;
+		}
+
+		size_type size( ) const noexcept {
+			return m_size;
+		}
+
+		size_type capacity( ) const noexcept {
+			return m_capacity;
+		}
+
+		static constexpr size_type inline_capacity( ) noexcept {
+			return N;
+		}
+
+		size_type max_size( ) const noexcept {
+			return alloc_traits::max_size( m_alloc );
+		}
+
+		bool has_room( size_type count ) const noexcept {
+			return count <= available( );
+		}
+
+		// Elements that can be added before the next allocation
+		size_type available( ) const noexcept {
+			return m_capacity - m_size;
+		}
+
+		void reserve( size_type count ) {
+			if( count > m_capacity ) {
+				reallocate( next_capacity( count ) );
+			}
+		}
+
+		// Move back inline when the elements fit, otherwise trim the allocation
+		void shrink_to_fit( ) {
+			if( is_inline( ) or m_size == m_capacity ) {
+				return;
+			}
+			if( m_size <= N ) {
+				pointer heap = m_data;
+				relocate( heap, m_size, inline_data( ) );
+				alloc_traits::deallocate( m_alloc, heap, m_capacity );
+				m_data = inline_data( );
+				m_capacity = N;
+				return;
+			}
+			reallocate( m_size );
+		}
+
+		void clear( ) noexcept {
+			std::destroy_n( m_data, m_size );
+			m_size = 0;
+		}
+
+		reference front( ) noexcept {
+			return m_data[0];
+		}
+
+		const_reference front( ) const noexcept {
+			return m_data[0];
+		}
+
+		reference back( ) noexcept {
+			return m_data[m_size - 1];
+		}
+
+		const_reference back( ) const noexcept {
+			return m_data[m_size - 1];
+		}
+
+		reference operator[]( size_type pos ) noexcept {
+			return m_data[pos];
+		}
+
+		const_reference operator[]( size_type pos ) const noexcept {
+			return m_data[pos];
+		}
+
+		reference at( size_type pos ) {
+			daw::exception::precondition_check<std::out_of_range>(
+			  pos < size( ), "Attempt to access past end of small_vector" );
+			return m_data[pos];
+		}
+
+		const_reference at( size_type pos ) const {
+			daw::exception::precondition_check<std::out_of_range>(
+			  pos < size( ), "Attempt to access past end of small_vector" );
+			return m_data[pos];
+		}
+
+		pointer data( ) noexcept {
+			return m_data;
+		}
+
+		const_pointer data( ) const noexcept {
+			return m_data;
+		}
+
+		iterator begin( ) noexcept {
+			return m_data;
+		}
+
+		const_iterator begin( ) const noexcept {
+			return m_data;
+		}
+
+		const_iterator cbegin( ) const noexcept {
+			return m_data;
+		}
+
+		iterator end( ) noexcept {
+			return m_data + m_size;
+		}
+
+		const_iterator end( ) const noexcept {
+			return m_data + m_size;
+		}
+
+		const_iterator cend( ) const noexcept {
+			return m_data + m_size;
+		}
+
+		template<typename... Args>
+		reference emplace_back( Args &&... args ) {
+			if( m_size == m_capacity ) {
+				return grow_emplace_back( std::forward<Args>( args )... );
+			}
+			construct_at( m_data + m_size, std::forward<Args>( args )... );
+			return m_data[m_size++];
+		}
+
+		void push_back( const_reference value ) {
+			emplace_back( value );
+		}
+
+		void push_back( value_type &&value ) {
+			emplace_back( std::move( value ) );
+		}
+
+		// ptr must not point into this vector
+		template<typename Ptr>
+		void push_back( Ptr const *ptr, size_type count ) {
+			reserve( m_size + count );
+			for( size_type n = 0; n < count; ++n ) {
+				construct_at( m_data + m_size, static_cast<value_type>( ptr[n] ) );
+				++m_size;
+			}
+		}
+
+		void push_back( const_pointer ptr, size_type count ) {
+			reserve( m_size + count );
+			std::uninitialized_copy_n( ptr, count, m_data + m_size );
+			m_size += count;
+		}
+
+		void assign( size_type count, const_reference value ) {
+			small_vector tmp( count, value, m_alloc );
+			*this = std::move( tmp );
+		}
+
+		value_type pop_back( ) {
+			value_type result = std::move( back( ) );
+			std::destroy_at( m_data + --m_size );
+			return result;
+		}
+
+		void pop_front( size_type const count ) {
+			daw::exception::precondition_check<std::out_of_range>(
+			  count <= size( ), "Attempt to pop_front past end of small_vector" );
+
+			erase( cbegin( ), cbegin( ) + count );
+		}
+
+		///	take care calling as it is slow
+		value_type pop_front( ) {
+			value_type result = std::move( front( ) );
+			pop_front( 1 );
+			return result;
+		}
+
+		void resize( size_type const count ) {
+			if( count < m_size ) {
+				std::destroy( m_data + count, m_data + m_size );
+				m_size = count;
+				return;
+			}
+			reserve( count );
+			std::uninitialized_value_construct( m_data + m_size, m_data + count );
+			m_size = count;
+		}
+
+		void resize( size_type const count, const_reference value ) {
+			if( count < m_size ) {
+				std::destroy( m_data + count, m_data + m_size );
+				m_size = count;
+				return;
+			}
+			if( count > m_capacity ) {
+				// value may be an element
+				value_type tmp = value;
+				reserve( count );
+				std::uninitialized_fill( m_data + m_size, m_data + count, tmp );
+			} else {
+				std::uninitialized_fill( m_data + m_size, m_data + count, value );
+			}
+			m_size = count;
+		}
+
+		iterator erase( const_iterator pos ) {
+			return erase( pos, std::next( pos ) );
+		}
+
+		iterator erase( const_iterator first, const_iterator last ) {
+			auto const idx = static_cast<size_type>( first - cbegin( ) );
+			auto const count = static_cast<size_type>( last - first );
+
+			daw::exception::precondition_check<std::out_of_range>(
+			  idx + count <= m_size, "Attempt to erase past end of small_vector" );
+
+			if( count > 0 ) {
+				std::move( m_data + idx + count, m_data + m_size, m_data + idx );
+				std::destroy( m_data + m_size - count, m_data + m_size );
+				m_size -= count;
+			}
+			return m_data + idx;
+		}
+	};
+
+	template<typename T, size_t N, typename Allocator>
+	void swap( small_vector<T, N, Allocator> &lhs,
+	           small_vector<T, N, Allocator> &rhs ) {
+		lhs.swap( rhs );
+	}
+
+	template<typename T, size_t N, typename Allocator>
+	bool operator==( small_vector<T, N, Allocator> const &lhs,
+	                 small_vector<T, N, Allocator> const &rhs ) {
+		return std::equal( lhs.begin( ), lhs.end( ), rhs.begin( ), rhs.end( ) );
+	}
+
+	template<typename T, size_t N, typename Allocator>
+	bool operator!=( small_vector<T, N, Allocator> const &lhs,
+	                 small_vector<T, N, Allocator> const &rhs ) {
+		return not( lhs == rhs );
+	}
+} // namespace daw
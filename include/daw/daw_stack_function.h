@@ -23,9 +23,12 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 #include <functional>
+#include <memory>
 #include <new>
 #include <type_traits>
+#include <utility>
 
 #include "daw_exception.h"
 #include "daw_move.h"
@@ -49,173 +52,88 @@ namespace daw {
 		inline constexpr bool has_empty_member_v =
 		  daw::is_detected_v<has_empty_member_detect, T>;
 
-		template<size_t StorageSize, typename Base>
-		struct function_storage {
-			std::aligned_storage_t<StorageSize> m_data;
-
-			function_storage( function_storage const & ) noexcept = default;
-			function_storage( function_storage && ) noexcept = default;
-
-			function_storage &operator=( function_storage const &rhs ) {
-				if( this == &rhs ) {
-					return *this;
-				}
-				clean( );
-				m_data = rhs.m_data;
-				return *this;
-			}
-
-			function_storage &operator=( function_storage && ) noexcept = default;
-
-			template<
-			  typename Func,
-			  std::enable_if_t<!std::is_same_v<std::decay_t<Func>, function_storage>,
-			                   std::nullptr_t> = nullptr>
-			function_storage( Func &&f ) {
-				static_assert( sizeof( std::decay_t<Func> ) <= StorageSize );
-				store( std::forward<Func>( f ) );
-			}
-
-			Base *ptr( ) noexcept {
-				return reinterpret_cast<Base *>( &m_data );
-			}
-
-			Base const *ptr( ) const noexcept {
-				return reinterpret_cast<Base const *>( &m_data );
-			}
-
-			void clean( ) {
-				ptr( )->~Base( );
-			}
-
-			~function_storage( ) {
-				clean( );
-			}
-
-			template<typename Func>
-			void store( Func &&f ) {
-				static_assert( sizeof( std::decay_t<Func> ) <= StorageSize );
-				static_assert( std::is_base_of_v<Base, Func>,
-				               "Can only store children of func_base" );
-				new( &m_data )
-				  daw::remove_cvref_t<std::decay_t<Func>>( std::forward<Func>( f ) );
-			}
-
-			Base &operator*( ) noexcept {
-				return *ptr( );
-			}
-
-			Base const &operator*( ) const noexcept {
-				return *ptr( );
-			}
-
-			Base *operator->( ) noexcept {
-				return ptr( );
-			}
-
-			Base const *operator->( ) const noexcept {
-				return ptr( );
-			}
+		// Operations on a stored callable, one static table per callable type.  A
+		// null copy, relocate or destroy means the callable is trivially copyable
+		// and its bytes can be copied, or left, as is
+		template<typename Result, typename... FuncArgs>
+		struct function_ops {
+			Result ( *invoke )( void *, FuncArgs... );
+			void ( *copy )( void *dest, void const *src );
+			// Move construct into dest and destroy src
+			void ( *relocate )( void *dest, void *src );
+			void ( *destroy )( void * );
+			// Bytes to copy when copy or relocate is null
+			size_t size;
 		};
 
 		template<typename Result, typename... FuncArgs>
-		struct function_base {
-			virtual Result operator( )( FuncArgs... ) const = 0;
-			virtual Result operator( )( FuncArgs... ) = 0;
-			virtual bool empty( ) const = 0;
-
-			function_base( ) noexcept = default;
-			virtual ~function_base( ) = default;
-			function_base( function_base const & ) noexcept = default;
-			function_base( function_base && ) noexcept = default;
-			function_base &operator=( function_base const & ) noexcept = default;
-			function_base &operator=( function_base && ) noexcept = default;
-		};
+		[[noreturn]] Result empty_invoke( void *, FuncArgs... ) {
+			daw::exception::daw_throw<std::bad_function_call>( );
+		}
 
 		template<typename Result, typename... FuncArgs>
-		struct empty_child final : function_base<Result, FuncArgs...> {
-			[[noreturn]] Result operator( )( FuncArgs... ) const override {
-				daw::exception::daw_throw<std::bad_function_call>( );
-			}
-			[[noreturn]] Result operator( )( FuncArgs... ) override {
-				daw::exception::daw_throw<std::bad_function_call>( );
-			}
+		inline constexpr function_ops<Result, FuncArgs...> const empty_ops = {
+		  &empty_invoke<Result, FuncArgs...>, nullptr, nullptr, nullptr, 0};
 
-			bool empty( ) const override {
-				return true;
+		template<typename Func, typename Result, typename... FuncArgs>
+		Result invoke_stored( void *data, FuncArgs... args ) {
+			if constexpr( std::is_void_v<Result> ) {
+				std::invoke( *static_cast<Func *>( data ),
+				             std::forward<FuncArgs>( args )... );
+			} else {
+				return std::invoke( *static_cast<Func *>( data ),
+				                    std::forward<FuncArgs>( args )... );
 			}
-		};
+		}
 
-		template<typename...>
-		struct function_child;
+		template<typename Func>
+		void copy_stored( void *dest, void const *src ) {
+			new( dest ) Func( *static_cast<Func const *>( src ) );
+		}
 
-		template<typename Func, typename Result, typename... FuncArgs>
-		struct function_child<Func, Result, FuncArgs...> final
-		  : function_base<Result, FuncArgs...> {
-
-			Func m_func;
-
-			template<typename F, std::enable_if_t<
-			                       !std::is_same_v<std::decay_t<F>, function_child>,
-			                       std::nullptr_t> = nullptr>
-			function_child( F &&func ) noexcept(
-			  std::is_nothrow_constructible_v<Func, F> )
-			  : m_func( std::forward<F>( func ) ) {}
-
-			Result operator( )( FuncArgs... args ) override {
-				daw::exception::precondition_check<std::bad_function_call>( !empty( ) );
-				if constexpr( std::is_same_v<std::decay_t<Result>, void> ) {
-					// daw::invoke( m_func, daw::move( args )... );
-					m_func( args... );
-				} else {
-					// return daw::invoke( m_func, daw::move( args )... );
-					return m_func( args... );
-				}
-			}
+		template<typename Func>
+		void relocate_stored( void *dest, void *src ) {
+			auto &f = *static_cast<Func *>( src );
+			new( dest ) Func( std::move( f ) );
+			f.~Func( );
+		}
 
-			Result operator( )( FuncArgs... args ) const override {
-				daw::exception::precondition_check<std::bad_function_call>( !empty( ) );
-				if constexpr( std::is_same_v<std::decay_t<Result>, void> ) {
-					// daw::invoke( m_func, daw::move( args )... );
-					m_func( args... );
-				} else {
-					// return daw::invoke( m_func, daw::move( args )... );
-					return m_func( args... );
-				}
-			}
+		template<typename Func>
+		void destroy_stored( void *data ) {
+			static_cast<Func *>( data )->~Func( );
+		}
 
-			bool empty( ) const override {
-				if constexpr( func_impl::has_empty_member_v<Func> ) {
-					return m_func.empty( );
-				} else if constexpr( func_impl::is_boolable_v<Func> ) {
-					return !static_cast<bool>( m_func );
-				}
-				return false;
+		template<typename Func, typename Result, typename... FuncArgs>
+		inline constexpr function_ops<Result, FuncArgs...> const ops_for = [] {
+			if constexpr( std::is_trivially_copyable_v<Func> ) {
+				return function_ops<Result, FuncArgs...>{
+				  &invoke_stored<Func, Result, FuncArgs...>, nullptr, nullptr,
+				  nullptr, sizeof( Func )};
+			} else {
+				return function_ops<Result, FuncArgs...>{
+				  &invoke_stored<Func, Result, FuncArgs...>, &copy_stored<Func>,
+				  &relocate_stored<Func>, &destroy_stored<Func>, sizeof( Func )};
 			}
-		};
+		}( );
 
-		template<size_t MaxSize, typename function_base, typename function_child,
-		         typename empty_child, typename Func>
-		function_storage<MaxSize, function_base> store_if_not_empty( Func &&f ) {
-			static_assert( sizeof( std::decay_t<Func> ) <= MaxSize );
+		template<typename Func>
+		bool is_empty_callable( Func const &f ) {
 			if constexpr( func_impl::has_empty_member_v<Func> ) {
-				if( f.empty( ) ) {
-					return {empty_child( )};
-				}
+				return f.empty( );
 			} else if constexpr( func_impl::is_boolable_v<Func> ) {
 #if defined( __GNUC__ ) && !defined( __clang__ )
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wnonnull-compare"
 #pragma GCC diagnostic ignored "-Waddress"
 #endif
-				if( !static_cast<bool>( f ) ) {
-					return {empty_child( )};
-				}
+				return !static_cast<bool>( f );
 #if defined( __GNUC__ ) && !defined( __clang__ )
 #pragma GCC diagnostic pop
 #endif
+			} else {
+				static_cast<void>( f );
+				return false;
 			}
-			return {function_child( std::forward<Func>( f ) )};
 		}
 
 		template<size_t Sz, size_t MaxSz>
@@ -229,50 +147,128 @@ namespace daw {
 	template<size_t, typename>
 	class function;
 
+	// Callable wrapper that stores the callable inline in MaxSize bytes.  Calls
+	// go through a function pointer held in the object, the rest of the
+	// operations through a static table per stored type.  Copying or moving a
+	// function holding a trivially copyable callable is a plain copy of its
+	// bytes
 	template<size_t MaxSize, typename Result, typename... FuncArgs>
 	class function<MaxSize, Result( FuncArgs... )> {
-		using function_base = func_impl::function_base<Result, FuncArgs...>;
-		using empty_child = func_impl::empty_child<Result, FuncArgs...>;
+		using ops_t = func_impl::function_ops<Result, FuncArgs...>;
 
-		template<typename Func>
-		using function_child = func_impl::function_child<Func, Result, FuncArgs...>;
+		template<size_t, typename>
+		friend class function;
 
-		func_impl::function_storage<MaxSize, function_base> m_storage;
+		ops_t const *m_ops = &func_impl::empty_ops<Result, FuncArgs...>;
+		Result ( *m_invoke )( void *, FuncArgs... ) = m_ops->invoke;
+		alignas( std::max_align_t ) unsigned char m_data[MaxSize];
+
+		void *data( ) const noexcept {
+			return const_cast<unsigned char *>( m_data );
+		}
+
+		void reset( ) noexcept {
+			if( m_ops->destroy != nullptr ) {
+				m_ops->destroy( data( ) );
+			}
+			m_ops = &func_impl::empty_ops<Result, FuncArgs...>;
+			m_invoke = m_ops->invoke;
+		}
+
+		template<size_t N>
+		void copy_from( function<N, Result( FuncArgs... )> const &other ) {
+			if( other.m_ops->copy != nullptr ) {
+				other.m_ops->copy( data( ), other.data( ) );
+			} else {
+				std::memcpy( m_data, other.m_data, other.m_ops->size );
+			}
+			m_ops = other.m_ops;
+			m_invoke = m_ops->invoke;
+		}
+
+		template<size_t N>
+		void move_from( function<N, Result( FuncArgs... )> &other ) noexcept {
+			if( other.m_ops->relocate != nullptr ) {
+				other.m_ops->relocate( data( ), other.data( ) );
+			} else {
+				std::memcpy( m_data, other.m_data, other.m_ops->size );
+			}
+			m_ops = other.m_ops;
+			m_invoke = m_ops->invoke;
+			other.m_ops = &func_impl::empty_ops<Result, FuncArgs...>;
+			other.m_invoke = other.m_ops->invoke;
+		}
 
 		template<typename Func>
-		decltype( auto ) store_if_not_empty( Func &&f ) {
-			func_impl::validate_size<sizeof( std::decay_t<Func> ), MaxSize>( );
-			return func_impl::store_if_not_empty<MaxSize, function_base,
-			                                     function_child<Func>, empty_child>(
-			  std::forward<Func>( f ) );
+		void store( Func &&f ) {
+			using func_t = std::decay_t<Func>;
+			func_impl::validate_size<sizeof( func_t ), MaxSize>( );
+			static_assert( alignof( func_t ) <= alignof( std::max_align_t ),
+			               "Function is over aligned" );
+			static_assert( std::is_invocable_r_v<Result, func_t &, FuncArgs...>,
+			               "Function isn't callable with FuncArgs" );
+			if( func_impl::is_empty_callable( f ) ) {
+				return;
+			}
+			new( data( ) ) func_t( std::forward<Func>( f ) );
+			m_ops = &func_impl::ops_for<func_t, Result, FuncArgs...>;
+			m_invoke = m_ops->invoke;
 		}
 
 	public:
-		function( ) noexcept
-		  : m_storage( empty_child{} ) {}
+		function( ) noexcept = default;
+
+		function( std::nullptr_t ) noexcept {}
 
-		function( std::nullptr_t )
-		  : m_storage( empty_child{} ) {}
+		function( function const &other ) {
+			copy_from( other );
+		}
+
+		function( function &&other ) noexcept {
+			move_from( other );
+		}
+
+		function &operator=( function const &rhs ) {
+			if( this != &rhs ) {
+				reset( );
+				copy_from( rhs );
+			}
+			return *this;
+		}
+
+		function &operator=( function &&rhs ) noexcept {
+			if( this != &rhs ) {
+				reset( );
+				move_from( rhs );
+			}
+			return *this;
+		}
+
+		~function( ) {
+			reset( );
+		}
 
-		function( function const & ) = default;
-		function( function && ) noexcept = default;
-		function &operator=( function const & ) = default;
-		function &operator=( function && ) noexcept = default;
-		~function( ) = default;
+		template<size_t N,
+		         std::enable_if_t<( N < MaxSize ), std::nullptr_t> = nullptr>
+		function( function<N, Result( FuncArgs... )> const &other ) {
+			copy_from( other );
+		}
 
 		template<size_t N,
-		         std::enable_if_t<( N <= MaxSize ), std::nullptr_t> = nullptr>
-		function( function<N, Result( FuncArgs... )> const &other )
-		  : m_storage( *other.m_storage ) {}
+		         std::enable_if_t<( N < MaxSize ), std::nullptr_t> = nullptr>
+		function( function<N, Result( FuncArgs... )> &&other ) noexcept {
+			move_from( other );
+		}
 
 		template<size_t N,
 		         std::enable_if_t<( N > MaxSize ), std::nullptr_t> = nullptr>
 		function( function<N, Result( FuncArgs... )> const &other ) = delete;
 
 		template<size_t N,
-		         std::enable_if_t<( N <= MaxSize ), std::nullptr_t> = nullptr>
+		         std::enable_if_t<( N < MaxSize ), std::nullptr_t> = nullptr>
 		function &operator=( function<N, Result( FuncArgs... )> const &other ) {
-			m_storage = *other.m_storage;
+			reset( );
+			copy_from( other );
 			return *this;
 		}
 
@@ -286,12 +282,8 @@ namespace daw {
 		           daw::all_true_v<!std::is_same_v<std::decay_t<Func>, function>,
 		                           !std::is_function_v<Func>>,
 		           std::nullptr_t> = nullptr>
-		function( Func &&f )
-		  : m_storage( store_if_not_empty( std::forward<Func>( f ) ) ) {
-
-			func_impl::validate_size<sizeof( std::decay_t<Func> ), MaxSize>( );
-			static_assert( std::is_invocable_r_v<Result, Func, FuncArgs...>,
-			               "Function isn't callable with FuncArgs" );
+		function( Func &&f ) {
+			store( std::forward<Func>( f ) );
 		}
 
 		template<typename Func,
@@ -300,41 +292,89 @@ namespace daw {
 		                           !std::is_function_v<Func>>,
 		           std::nullptr_t> = nullptr>
 		function &operator=( Func &&f ) {
-			func_impl::validate_size<sizeof( std::decay_t<Func> ), MaxSize>( );
-			static_assert( std::is_invocable_r_v<Result, Func, FuncArgs...>,
-			               "Function isn't callable with FuncArgs" );
-			m_storage = store_if_not_empty( std::forward<Func>( f ) );
+			// f may live in this function, so it is stored before being destroyed
+			function tmp( std::forward<Func>( f ) );
+			reset( );
+			move_from( tmp );
 			return *this;
 		}
 
-		template<typename... Args>
-		Result operator( )( Args &&... args ) {
-			daw::exception::precondition_check<std::bad_function_call>( !empty( ) );
-			function_base &f = *m_storage;
-			if constexpr( std::is_same_v<std::decay_t<Result>, void> ) {
-				f( std::forward<Args>( args )... );
+		Result operator( )( FuncArgs... args ) const {
+			return m_invoke( data( ), std::forward<FuncArgs>( args )... );
+		}
+
+		bool empty( ) const noexcept {
+			return m_ops == &func_impl::empty_ops<Result, FuncArgs...>;
+		}
+
+		explicit operator bool( ) const noexcept {
+			return !empty( );
+		}
+	};
+
+	template<typename>
+	class function_ref;
+
+	// Non owning reference to a callable, for callback parameters.  The
+	// callable must outlive the function_ref
+	template<typename Result, typename... FuncArgs>
+	class function_ref<Result( FuncArgs... )> {
+		union storage_t {
+			void *obj;
+			void ( *fn )( );
+		};
+
+		storage_t m_storage;
+		Result ( *m_invoke )( storage_t, FuncArgs... );
+
+		template<typename Func>
+		static Result invoke_obj( storage_t s, FuncArgs... args ) {
+			if constexpr( std::is_void_v<Result> ) {
+				std::invoke( *static_cast<Func *>( s.obj ),
+				             std::forward<FuncArgs>( args )... );
 			} else {
-				return f( std::forward<Args>( args )... );
+				return std::invoke( *static_cast<Func *>( s.obj ),
+				                    std::forward<FuncArgs>( args )... );
 			}
 		}
 
-		template<typename... Args>
-		Result operator( )( Args &&... args ) const {
-			daw::exception::precondition_check<std::bad_function_call>( !empty( ) );
-			function_base const &f = *m_storage;
-			if constexpr( std::is_same_v<std::decay_t<Result>, void> ) {
-				f( std::forward<Args>( args )... );
+		template<typename FuncPtr>
+		static Result invoke_fn( storage_t s, FuncArgs... args ) {
+			if constexpr( std::is_void_v<Result> ) {
+				std::invoke( reinterpret_cast<FuncPtr>( s.fn ),
+				             std::forward<FuncArgs>( args )... );
 			} else {
-				return f( std::forward<Args>( args )... );
+				return std::invoke( reinterpret_cast<FuncPtr>( s.fn ),
+				                    std::forward<FuncArgs>( args )... );
 			}
 		}
 
-		bool empty( ) const {
-			return m_storage->empty( );
+	public:
+		template<typename Func,
+		         std::enable_if_t<
+		           daw::all_true_v<
+		             !std::is_same_v<daw::remove_cvref_t<Func>, function_ref>,
+		             std::is_invocable_r_v<Result, Func &, FuncArgs...>>,
+		           std::nullptr_t> = nullptr>
+		function_ref( Func &&f ) noexcept {
+			using func_t = std::remove_reference_t<Func>;
+			if constexpr( std::is_function_v<func_t> ) {
+				m_storage.fn = reinterpret_cast<void ( * )( )>( &f );
+				m_invoke = &invoke_fn<func_t *>;
+			} else if constexpr( std::is_pointer_v<func_t> and
+			                     std::is_function_v<
+			                       std::remove_pointer_t<func_t>> ) {
+				m_storage.fn = reinterpret_cast<void ( * )( )>( f );
+				m_invoke = &invoke_fn<func_t>;
+			} else {
+				m_storage.obj = const_cast<void *>(
+				  static_cast<void const volatile *>( std::addressof( f ) ) );
+				m_invoke = &invoke_obj<func_t>;
+			}
 		}
 
-		explicit operator bool( ) const {
-			return !empty( );
+		Result operator( )( FuncArgs... args ) const {
+			return m_invoke( m_storage, std::forward<FuncArgs>( args )... );
 		}
 	};
 } // namespace daw
@@ -0,0 +1,420 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "daw_exception.h"
+#include "daw_fnv1a_hash.h"
+#include "daw_string_view.h"
+
+namespace daw {
+	namespace impl {
+		namespace string_map_meta {
+			// Same layout as the hash_set_t metadata, a set high bit marks an
+			// occupied slot and the low 7 bits hold a fingerprint of the hash
+			enum : uint8_t { empty = 0, occupied = 0x80 };
+		} // namespace string_map_meta
+
+		// A key as it is stored in a string_map slot.  The size and the first
+		// prefix_size characters are always in the slot.  Keys of up to
+		// inline_size characters are entirely in the slot, longer ones store the
+		// offset of the whole string in the arena in place of the remaining
+		// characters
+		class string_map_key_t {
+			uint32_t m_size = 0;
+			char m_data[12] = {};
+
+		public:
+			static constexpr size_t const prefix_size = 4;
+			static constexpr size_t const inline_size = sizeof( m_data );
+
+			string_map_key_t( ) noexcept = default;
+
+			string_map_key_t( daw::string_view key, std::vector<char> &arena )
+			  : m_size( static_cast<uint32_t>( key.size( ) ) ) {
+
+				if( is_inline( ) ) {
+					std::memcpy( m_data, key.data( ), key.size( ) );
+					return;
+				}
+				std::memcpy( m_data, key.data( ), prefix_size );
+				auto const offset = static_cast<uint64_t>( arena.size( ) );
+				std::memcpy( m_data + prefix_size, &offset, sizeof( offset ) );
+				arena.insert( arena.end( ), key.begin( ), key.end( ) );
+			}
+
+			constexpr size_t size( ) const noexcept {
+				return m_size;
+			}
+
+			constexpr bool is_inline( ) const noexcept {
+				return m_size <= inline_size;
+			}
+
+			uint64_t offset( ) const noexcept {
+				uint64_t result = 0;
+				std::memcpy( &result, m_data + prefix_size, sizeof( result ) );
+				return result;
+			}
+
+			daw::string_view view( char const *arena ) const noexcept {
+				if( is_inline( ) ) {
+					return daw::string_view( m_data, m_size );
+				}
+				return daw::string_view( arena + offset( ), m_size );
+			}
+
+			// The size and prefix reject most mismatches without leaving the slot
+			bool equals( daw::string_view key, char const *arena ) const noexcept {
+				if( key.size( ) != m_size ) {
+					return false;
+				}
+				if( is_inline( ) ) {
+					return std::memcmp( m_data, key.data( ), m_size ) == 0;
+				}
+				return std::memcmp( m_data, key.data( ), prefix_size ) == 0 and
+				       std::memcmp( arena + offset( ) + prefix_size,
+				                    key.data( ) + prefix_size,
+				                    m_size - prefix_size ) == 0;
+			}
+		};
+	} // namespace impl
+
+	// An open addressed, linear probed map from strings to Value.  Slots hold a
+	// 16 byte key in the style of German strings instead of a pointer to a
+	// separately allocated string, so a lookup only leaves the slot array for
+	// long keys whose size, prefix and fingerprint all match.  Long keys share
+	// one contiguous arena.  Lookups take a daw::string_view and never build a
+	// temporary string.  Erase leaves the arena bytes of long keys behind, they
+	// are reclaimed on the next rehash or once they are over half the arena
+	template<typename Value>
+	class string_map {
+		using key_t = impl::string_map_key_t;
+
+		struct slot_t {
+			key_t key{};
+			Value value{};
+		};
+
+		static constexpr size_t const min_capacity = 8;
+		static constexpr size_t const npos = std::numeric_limits<size_t>::max( );
+
+		float m_max_load_factor = 0.75f;
+		std::vector<uint8_t> m_meta{};
+		std::vector<slot_t> m_slots{};
+		std::vector<char> m_arena{};
+		size_t m_dead_arena = 0;
+		size_t m_shift = std::numeric_limits<size_t>::digits;
+		size_t m_size = 0;
+
+		static size_t hash_of( daw::string_view key ) noexcept {
+			// Fibonacci hashing, the high bits are used to select the slot
+			return daw::fnv1a_hash( key.data( ), key.size( ) ) *
+			       static_cast<size_t>( 0x9E37'79B9'7F4A'7C15ULL );
+		}
+
+		// The middle bits of the hash, the high ones already selected the slot
+		static constexpr size_t const fingerprint_shift =
+		  std::numeric_limits<size_t>::digits / 2U;
+
+		static constexpr uint8_t fingerprint( size_t hash ) noexcept {
+			return static_cast<uint8_t>(
+			  impl::string_map_meta::occupied |
+			  ( ( hash >> fingerprint_shift ) & static_cast<size_t>( 0x7FU ) ) );
+		}
+
+		static constexpr size_t log2( size_t n ) noexcept {
+			size_t result = 0;
+			while( n > 1 ) {
+				n >>= 1U;
+				++result;
+			}
+			return result;
+		}
+
+		size_t capacity_for( size_t count ) const noexcept {
+			auto const needed = static_cast<size_t>(
+			  std::ceil( static_cast<double>( count ) /
+			             static_cast<double>( m_max_load_factor ) ) );
+			size_t result = min_capacity;
+			while( result < needed ) {
+				result <<= 1U;
+			}
+			return result;
+		}
+
+		size_t home( size_t hash ) const noexcept {
+			return hash >> m_shift;
+		}
+
+		size_t mask( ) const noexcept {
+			return m_slots.size( ) - 1;
+		}
+
+		size_t find_pos( daw::string_view key, size_t hash ) const noexcept {
+			if( m_slots.empty( ) ) {
+				return npos;
+			}
+			auto const fp = fingerprint( hash );
+			size_t pos = home( hash );
+			while( m_meta[pos] != impl::string_map_meta::empty ) {
+				if( m_meta[pos] == fp and
+				    m_slots[pos].key.equals( key, m_arena.data( ) ) ) {
+					return pos;
+				}
+				pos = ( pos + 1 ) & mask( );
+			}
+			return npos;
+		}
+
+		size_t find_empty( size_t hash ) const noexcept {
+			size_t pos = home( hash );
+			while( m_meta[pos] != impl::string_map_meta::empty ) {
+				pos = ( pos + 1 ) & mask( );
+			}
+			return pos;
+		}
+
+		// Move every element into a table of new_capacity slots and a fresh arena
+		// that only holds the long keys still in use
+		void rehash( size_t new_capacity ) {
+			std::vector<uint8_t> meta( new_capacity, impl::string_map_meta::empty );
+			std::vector<slot_t> slots( new_capacity );
+			std::vector<char> arena{};
+			arena.reserve( m_arena.size( ) - m_dead_arena );
+			size_t const new_shift =
+			  std::numeric_limits<size_t>::digits - log2( new_capacity );
+			for( size_t n = 0; n < m_slots.size( ); ++n ) {
+				if( m_meta[n] == impl::string_map_meta::empty ) {
+					continue;
+				}
+				auto const key = m_slots[n].key.view( m_arena.data( ) );
+				auto const hash = hash_of( key );
+				size_t pos = hash >> new_shift;
+				while( meta[pos] != impl::string_map_meta::empty ) {
+					pos = ( pos + 1 ) & ( new_capacity - 1 );
+				}
+				meta[pos] = m_meta[n];
+				slots[pos].key = key_t( key, arena );
+				slots[pos].value = std::move( m_slots[n].value );
+			}
+			m_meta = std::move( meta );
+			m_slots = std::move( slots );
+			m_arena = std::move( arena );
+			m_dead_arena = 0;
+			m_shift = new_shift;
+		}
+
+		bool fits( size_t count ) const noexcept {
+			return static_cast<double>( count ) <=
+			       static_cast<double>( m_slots.size( ) ) *
+			         static_cast<double>( m_max_load_factor );
+		}
+
+		// Position of key, adding it with a default constructed value when it is
+		// not present.  The bool is true when it was added
+		std::pair<size_t, bool> emplace_key( daw::string_view key ) {
+			daw::exception::precondition_check<std::length_error>(
+			  key.size( ) <= std::numeric_limits<uint32_t>::max( ),
+			  "Key is too long" );
+			auto const hash = hash_of( key );
+			auto pos = find_pos( key, hash );
+			if( pos != npos ) {
+				return {pos, false};
+			}
+			if( !fits( m_size + 1 ) ) {
+				rehash( std::max( capacity_for( m_size + 1 ), m_slots.size( ) * 2 ) );
+			}
+			pos = find_empty( hash );
+			m_slots[pos].key = key_t( key, m_arena );
+			m_meta[pos] = fingerprint( hash );
+			++m_size;
+			return {pos, true};
+		}
+
+	public:
+		using key_type = daw::string_view;
+		using mapped_type = Value;
+		using size_type = size_t;
+
+		string_map( ) = default;
+
+		explicit string_map( size_t expected_size ) {
+			reserve( expected_size );
+		}
+
+		size_t size( ) const noexcept {
+			return m_size;
+		}
+
+		bool empty( ) const noexcept {
+			return m_size == 0;
+		}
+
+		size_t capacity( ) const noexcept {
+			return m_slots.size( );
+		}
+
+		// Bytes of long key storage, including that of erased keys not yet
+		// reclaimed.  Erased bytes never exceed half of it
+		size_t arena_size( ) const noexcept {
+			return m_arena.size( );
+		}
+
+		float max_load_factor( ) const noexcept {
+			return m_max_load_factor;
+		}
+
+		void max_load_factor( float ml ) {
+			daw::exception::precondition_check<std::invalid_argument>(
+			  ml > 0.0f and ml < 1.0f, "max_load_factor must be in (0, 1)" );
+			m_max_load_factor = ml;
+			if( !fits( m_size ) ) {
+				rehash( capacity_for( m_size ) );
+			}
+		}
+
+		void reserve( size_t count ) {
+			auto const new_capacity = capacity_for( count );
+			if( new_capacity > m_slots.size( ) ) {
+				rehash( new_capacity );
+			}
+		}
+
+		// Add key with value when it is not present.  Returns true when it was
+		// added, an existing value is left untouched
+		bool insert( daw::string_view key, Value value ) {
+			auto const result = emplace_key( key );
+			if( result.second ) {
+				m_slots[result.first].value = std::move( value );
+			}
+			return result.second;
+		}
+
+		Value &operator[]( daw::string_view key ) {
+			return m_slots[emplace_key( key ).first].value;
+		}
+
+		Value *find( daw::string_view key ) noexcept {
+			auto const pos = find_pos( key, hash_of( key ) );
+			return pos == npos ? nullptr : &m_slots[pos].value;
+		}
+
+		Value const *find( daw::string_view key ) const noexcept {
+			auto const pos = find_pos( key, hash_of( key ) );
+			return pos == npos ? nullptr : &m_slots[pos].value;
+		}
+
+		Value &at( daw::string_view key ) {
+			auto result = find( key );
+			daw::exception::precondition_check<std::out_of_range>(
+			  result != nullptr, "Attempt to access an undefined key" );
+			return *result;
+		}
+
+		Value const &at( daw::string_view key ) const {
+			auto result = find( key );
+			daw::exception::precondition_check<std::out_of_range>(
+			  result != nullptr, "Attempt to access an undefined key" );
+			return *result;
+		}
+
+		bool exists( daw::string_view key ) const noexcept {
+			return find_pos( key, hash_of( key ) ) != npos;
+		}
+
+		size_t count( daw::string_view key ) const noexcept {
+			return exists( key ) ? 1U : 0U;
+		}
+
+		// Backward shift deletion, so no tombstones are left in the table
+		bool erase( daw::string_view key ) {
+			auto pos = find_pos( key, hash_of( key ) );
+			if( pos == npos ) {
+				return false;
+			}
+			if( !m_slots[pos].key.is_inline( ) ) {
+				m_dead_arena += m_slots[pos].key.size( );
+			}
+			m_meta[pos] = impl::string_map_meta::empty;
+			m_slots[pos] = slot_t{};
+			size_t hole = pos;
+			size_t next = ( hole + 1 ) & mask( );
+			while( m_meta[next] != impl::string_map_meta::empty ) {
+				auto const next_home =
+				  home( hash_of( m_slots[next].key.view( m_arena.data( ) ) ) );
+				if( ( ( next - next_home ) & mask( ) ) >=
+				    ( ( next - hole ) & mask( ) ) ) {
+					m_slots[hole] = std::move( m_slots[next] );
+					m_meta[hole] = m_meta[next];
+					m_slots[next] = slot_t{};
+					m_meta[next] = impl::string_map_meta::empty;
+					hole = next;
+				}
+				next = ( next + 1 ) & mask( );
+			}
+			--m_size;
+			// Compact in place so a map of steady size does not grow its arena
+			// forever
+			if( m_dead_arena * 2 > m_arena.size( ) ) {
+				rehash( m_slots.size( ) );
+			}
+			return true;
+		}
+
+		void clear( ) {
+			std::fill( m_meta.begin( ), m_meta.end( ), impl::string_map_meta::empty );
+			std::fill( m_slots.begin( ), m_slots.end( ), slot_t{} );
+			m_arena.clear( );
+			m_dead_arena = 0;
+			m_size = 0;
+		}
+
+		// Calls func( daw::string_view key, Value & value ) for every element
+		template<typename Function>
+		void for_each( Function &&func ) {
+			for( size_t n = 0; n < m_slots.size( ); ++n ) {
+				if( m_meta[n] != impl::string_map_meta::empty ) {
+					func( m_slots[n].key.view( m_arena.data( ) ), m_slots[n].value );
+				}
+			}
+		}
+
+		template<typename Function>
+		void for_each( Function &&func ) const {
+			for( size_t n = 0; n < m_slots.size( ); ++n ) {
+				if( m_meta[n] != impl::string_map_meta::empty ) {
+					func( m_slots[n].key.view( m_arena.data( ) ), m_slots[n].value );
+				}
+			}
+		}
+	};
+} // namespace daw
@@ -25,6 +25,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <new>
 #include <utility>
 
 #include "cpp_17.h"
@@ -91,11 +92,12 @@ namespace daw {
 			static_assert( daw::is_convertible_v<T, Type0>,
 			               "Incompatible type T cannot convert to Type0" );
 
-			if( type != data_types::type_0 ) {
-				clear( );
+			if( type == data_types::type_0 ) {
+				value0 = std::forward<T>( value );
+				return;
 			}
-			type = data_types::type_nothing;
-			value0 = std::forward<T>( value );
+			clear( );
+			new( get_type0_ptr( ) ) Type0( std::forward<T>( value ) );
 			type = data_types::type_0;
 		}
 
@@ -104,11 +106,12 @@ namespace daw {
 			static_assert( daw::is_convertible_v<T, Type1>,
 			               "Incompatible type T cannot convert to Type1" );
 
-			if( type != data_types::type_1 ) {
-				clear( );
+			if( type == data_types::type_1 ) {
+				value1 = std::forward<T>( value );
+				return;
 			}
-			type = data_types::type_nothing;
-			value1 = std::forward<T>( value );
+			clear( );
+			new( get_type1_ptr( ) ) Type1( std::forward<T>( value ) );
 			type = data_types::type_1;
 		}
 
@@ -24,18 +24,16 @@
 
 #include <cstddef>
 #include <cstdint>
-#include <functional>
+#include <new>
 #ifndef NOSTRING
 #include <string>
 #endif
 #include <type_traits>
 #include <typeindex>
 #include <typeinfo>
-#include <unordered_map>
 #include <utility>
 
 #include "daw_algorithm.h"
-#include "daw_bounded_array.h"
 #include "daw_exception.h"
 #include "daw_move.h"
 #include "daw_operators.h"
@@ -69,7 +67,7 @@ namespace daw {
 		to_string( ::std::basic_string<CharT, Traits, Allocator> s ) {
 			return daw::move( s );
 		}
-		std::string to_string( ... ) {
+		inline std::string to_string( ... ) {
 			daw::exception::daw_throw(
 			  "Attemp to call to string on unsupported type, overload to enable" );
 		}
@@ -97,222 +95,77 @@ namespace daw {
 	constexpr bool has_to_string_v = false;
 #endif
 
+	namespace variant_impl {
+		// Operations on the stored value, one table entry per alternative so
+		// that dispatch is an index into an array
+		template<typename Variant>
+		struct variant_ops_t {
+			void ( *destruct )( void * );
+			void ( *copy )( void *dest, void const *src );
+			void ( *move )( void *dest, void *src );
 #ifndef NOSTRING
-	template<typename... Types>
-	class generate_to_strings_t {
-		template<typename T,
-		         std::enable_if_t<has_to_string_v<T>, std::nullptr_t> = nullptr>
-		struct to_string_t {
-			static_assert( has_to_string_v<T>, "to_string must be defined for type" );
-
-			std::string operator( )( variant_t<Types...> const &value ) const {
-				using daw::tostrings::to_string;
-				using std::to_string;
-				return to_string( get<T>( value ) );
-			}
-		}; // to_string_t
-	public:
-		template<typename T>
-		auto generate( ) const {
-			return to_string_t<T>{};
-		}
-	}; // generate_to_strings_t
+			std::string ( *to_string )( void const * );
 #endif
-	template<typename... Types>
-	class generate_compare_t {
-		template<typename T,
-		         std::enable_if_t<!daw::traits::is_vector_like_not_string_v<T>>>
-		static bool op_eq( T const &lhs, T const &rhs ) {
-			return lhs == rhs;
-		}
-
-		template<typename T,
-		         std::enable_if_t<daw::traits::is_vector_like_not_string_v<T>>>
-		static auto op_eq( std::vector<T> const &lhs, std::vector<T> const &rhs )
-		  -> decltype( lhs[0] == rhs[0], bool( ) ) {
-			return std::equal( lhs.begin( ), lhs.end( ), rhs.begin( ), rhs.end( ) );
-		}
-
-		template<typename T, typename = std::enable_if_t<
-		                       daw::traits::operators::has_op_eq_v<T> &&
-		                       daw::traits::operators::has_op_lt_v<T>>>
-		static constexpr auto op_compare( variant_t<Types...> const &lhs,
-		                                  variant_t<Types...> const &rhs )
-		  -> decltype( std::declval<T>( ) == std::declval<T>( ) &&
-		                 std::declval<T>( ) < std::declval<T>( ),
-		               int( ) ) {
-			auto const &a = lhs.template get<T>( );
-			auto const &b = rhs.template get<T>( );
-			if( a == b ) {
-				return 0;
-			} else if( a < b ) {
-				return -1;
-			}
-			return 1;
-		}
+			// Compare two values of this alternative
+			int ( *compare )( Variant const &lhs, Variant const &rhs );
+		};
 
-		template<typename T, typename = std::enable_if_t<
-		                       daw::traits::has_to_string_v<variant_t<Types...>> &&
-		                       !( daw::traits::operators::has_op_eq_v<T> &&
-		                          daw::traits::operators::has_op_lt_v<T> )>>
-		static int op_compare( variant_t<Types...> const &lhs,
-		                       variant_t<Types...> const &rhs ) {
-			return lhs.to_string( ).compare( rhs.to_string( ) );
+		template<typename T>
+		void destruct_value( void *ptr ) {
+			static_cast<T *>( ptr )->~T( );
 		}
 
 		template<typename T>
-		struct compare_t final {
-			int operator( )( variant_t<Types...> const &lhs,
-			                 variant_t<Types...> const &rhs ) {
-				if( lhs.type_index( ) == rhs.type_index( ) ) {
-					return op_compare<T>( lhs, rhs );
-				}
-				return lhs.to_string( ).compare( rhs.to_string( ) );
-			}
-		}; // compare_t
-	public:
-		template<typename T>
-		auto generate( ) const {
-			return compare_t<T>{};
+		void copy_value( void *dest, void const *src ) {
+			new( dest ) T( *static_cast<T const *>( src ) );
 		}
-	}; // generate_compare_t
 
-	template<typename... Types>
-	class generate_destruct_t final {
 		template<typename T>
-		struct destruct_t final {
-			void operator( )( variant_t<Types...> &value ) const {
-				auto &tmp = value.template get<T>( );
-				tmp.~T( );
-			}
-		}; // destruct_t
-	public:
-		template<typename T>
-		auto generate( ) const {
-			return destruct_t<T>{};
+		void move_value( void *dest, void *src ) {
+			new( dest ) T( daw::move( *static_cast<T *>( src ) ) );
 		}
-	}; // generate_destruct_t
 
-	template<typename... Types>
-	struct variant_helper_funcs_t {
 #ifndef NOSTRING
-		using to_string_t =
-		  std::function<std::string( variant_t<Types...> const & )>;
-#else
-		using to_string_t = void *;
-#endif
-		using compare_t = std::function<int( variant_t<Types...> const &,
-		                                     variant_t<Types...> const & )>;
-		using destruct_t = std::function<void( variant_t<Types...> & )>;
-
-		to_string_t to_string;
-		compare_t compare;
-		destruct_t destruct;
-
-		variant_helper_funcs_t( )
-		  : to_string{}
-		  , compare{}
-		  , destruct{} {}
-
-		template<typename ToString, typename Compare, typename Destruct>
-		variant_helper_funcs_t( ToString a, Compare b, Destruct c )
-		  : to_string{a}
-		  , compare{b}
-		  , destruct{c} {}
-	}; // variant_helper_funcs_t
-
-	template<typename... Types>
-	struct generate_variant_helper_funcs_t {
-#ifndef NOSTRING
-		generate_to_strings_t<Types...> generate_to_strings;
+		template<typename T>
+		std::string to_string_value( void const *ptr ) {
+			using daw::tostrings::to_string;
+			using std::to_string;
+			return to_string( *static_cast<T const *>( ptr ) );
+		}
 #endif
-		generate_compare_t<Types...> generate_compares;
-		generate_destruct_t<Types...> generate_destructs;
 
-		template<typename T>
-		auto generate( ) const {
-			return variant_helper_funcs_t<Types...>{
+		template<typename T, typename Variant>
+		int compare_value( Variant const &lhs, Variant const &rhs ) {
+			if constexpr( daw::traits::operators::has_op_eq_v<T> and
+			              daw::traits::operators::has_op_lt_v<T> ) {
+				auto const &a = lhs.template get<T>( );
+				auto const &b = rhs.template get<T>( );
+				if( a == b ) {
+					return 0;
+				} else if( a < b ) {
+					return -1;
+				}
+				return 1;
+			} else {
 #ifndef NOSTRING
-			  generate_to_strings.template generate<T>( ),
+				return lhs.to_string( ).compare( rhs.to_string( ) );
+#else
+				static_assert( daw::traits::operators::has_op_eq_v<T> and
+				                 daw::traits::operators::has_op_lt_v<T>,
+				               "Alternatives must be comparable with == and <" );
 #endif
-			  generate_compares.template generate<T>( ),
-			  generate_destructs.template generate<T>( )};
-		}
-	}; // generate_variant_helper_funcs_t
-
-	template<typename... Types>
-	auto get_variant_helpers( ) {
-		static_assert( sizeof...( Types ) != 0, "Must supply at least one type" );
-
-		std::unordered_map<std::type_index, variant_helper_funcs_t<Types...>>
-		  results;
-		generate_variant_helper_funcs_t<Types...> generate_variant_helper_funcs;
-
-		auto list = {
-		  ( (void)( results[get_type_index<Types>( )] =
-		              generate_variant_helper_funcs.template generate<Types>( ) ),
-		    0 )...};
-
-		Unused( list );
-
-		return results;
-	}
-
-	namespace impl {
-		class stored_type_t {
-			std::type_index m_value;
-
-			static std::type_index empty_type( ) noexcept {
-				class no_type_t {};
-				return get_type_index<no_type_t>( );
-			}
-
-		public:
-			stored_type_t( ) noexcept
-			  : m_value{empty_type( )} {}
-
-			stored_type_t( std::type_index ti ) noexcept
-			  : m_value{daw::move( ti )} {}
-
-			stored_type_t &operator=( std::type_index ti ) noexcept {
-				m_value = daw::move( ti );
-				return *this;
-			}
-
-			stored_type_t( stored_type_t const & ) = default;
-			stored_type_t( stored_type_t && ) noexcept = default;
-			stored_type_t &operator=( stored_type_t const & ) = default;
-			stored_type_t &operator=( stored_type_t && ) noexcept = default;
-			~stored_type_t( ) noexcept = default;
-
-			std::type_index const &operator*( ) const noexcept {
-				return m_value;
-			}
-
-			operator bool( ) const noexcept {
-				return m_value != empty_type( );
-			}
-
-			bool empty( ) const noexcept {
-				return m_value == empty_type( );
-			}
-
-			void reset( ) noexcept {
-				m_value = empty_type( );
 			}
-		};
-
-		bool operator==( stored_type_t const &lhs,
-		                 stored_type_t const &rhs ) noexcept {
-			return *lhs == *rhs;
-		}
-
-		bool operator!=( stored_type_t const &lhs,
-		                 stored_type_t const &rhs ) noexcept {
-			return *lhs != *rhs;
 		}
 
-	} // namespace impl
+		template<typename Variant, typename... Types>
+		inline constexpr variant_ops_t<Variant> const
+		  variant_ops[sizeof...( Types )] = {{
+		    &destruct_value<Types>, &copy_value<Types>, &move_value<Types>,
+#ifndef NOSTRING
+		    &to_string_value<Types>,
+#endif
+		    &compare_value<Types, Variant>}...};
+	} // namespace variant_impl
 
 	template<typename... Types>
 	struct variant_t {
@@ -323,25 +176,23 @@ namespace daw {
 		  daw::traits::is_one_of_v<std::remove_cv_t<T>, std::remove_cv_t<Types>...>;
 
 	private:
-	public:
-		bool empty( ) const noexcept {
-			return m_stored_type.empty( );
-		}
-
-	private:
-		void reset_type( ) noexcept {
-			m_stored_type.reset( );
-		}
-
+		static constexpr size_t const npos = sizeof...( Types );
 		static constexpr size_t const s_buffer_size =
 		  daw::traits::max_sizeof_v<Types...>;
-		impl::stored_type_t m_stored_type;
-		alignas( daw::traits::max_sizeof_t<Types...> )
-		  daw::bounded_array_t<uint8_t, s_buffer_size> m_buffer;
 
-		static auto get_helper_funcs( std::type_index idx ) {
-			static auto func_map = get_variant_helpers<Types...>( );
-			return func_map[idx];
+		size_t m_index = npos;
+		alignas( Types... ) unsigned char m_buffer[s_buffer_size];
+
+		template<typename T>
+		static constexpr size_t index_of( ) noexcept {
+			return static_cast<size_t>(
+			  daw::traits::pack_index_of_v<std::remove_cv_t<T>,
+			                               std::remove_cv_t<Types>...> );
+		}
+
+		static variant_impl::variant_ops_t<variant_t> const &
+		ops( size_t idx ) noexcept {
+			return variant_impl::variant_ops<variant_t, Types...>[idx];
 		}
 
 		template<typename T>
@@ -352,11 +203,7 @@ namespace daw {
 			daw::exception::daw_throw_on_false<bad_variant_t_access>(
 			  is_same_type<value_type>( ),
 			  "Attempt to access a value of another type" );
-			static_assert(
-			  sizeof( value_type ) <= s_buffer_size,
-			  "This should never happen.  sizeof(T) does not fit into m_buffer" );
-			return reinterpret_cast<value_type *>(
-			  static_cast<void *>( m_buffer.data( ) ) );
+			return std::launder( reinterpret_cast<value_type *>( m_buffer ) );
 		}
 
 		template<typename T>
@@ -367,51 +214,69 @@ namespace daw {
 			daw::exception::daw_throw_on_false<bad_variant_t_access>(
 			  is_same_type<value_type>( ),
 			  "Attempt to access a value of another type" );
+			return std::launder( reinterpret_cast<value_type const *>( m_buffer ) );
+		}
 
-			static_assert(
-			  sizeof( value_type ) <= s_buffer_size,
-			  "This should never happen.  sizeof(T) does not fit into m_buffer" );
-
-			return reinterpret_cast<value_type const *>(
-			  static_cast<void const *>( m_buffer.data( ) ) );
+		void *raw_ptr( ) noexcept {
+			return static_cast<void *>( m_buffer );
 		}
 
-		void *raw_ptr( ) {
-			return static_cast<void *>( m_buffer.data( ) );
+		void const *raw_ptr( ) const noexcept {
+			return static_cast<void const *>( m_buffer );
 		}
 
-		template<typename T, typename = std::enable_if_t<is_valid_type<T>>>
+		template<typename T>
 		void set_type( T &&value ) {
-			if( !is_same_type<T>( ) ) {
-				reset( );
-			}
-			m_stored_type = get_type_index<T>( );
-			void *p = raw_ptr( );
-			new( p ) T( std::forward<T>( value ) );
+			using value_type = daw::remove_cvref_t<T>;
+			reset( );
+			new( raw_ptr( ) ) value_type( std::forward<T>( value ) );
+			m_index = index_of<value_type>( );
 		}
 
 	public:
-		variant_t( )
-		  : m_stored_type{}
-		  , m_buffer{} {}
+		variant_t( ) noexcept {}
 
 		template<typename T, typename = std::enable_if_t<is_valid_type<T>>>
-		variant_t( T value )
-		  : variant_t{} {
-
+		variant_t( T value ) {
 			store( daw::move( value ) );
 		}
 
 		~variant_t( ) {
-			if( !empty( ) ) {
-				get_helper_funcs( *m_stored_type ).destruct( *this );
+			reset( );
+		}
+
+		variant_t( variant_t const &other ) {
+			if( !other.empty( ) ) {
+				ops( other.m_index ).copy( raw_ptr( ), other.raw_ptr( ) );
+				m_index = other.m_index;
 			}
 		}
 
-		variant_t( variant_t const & ) = default;
-		variant_t &operator=( variant_t const & ) = default;
-		variant_t( variant_t && ) noexcept = default;
-		variant_t &operator=( variant_t && ) noexcept = default;
+		variant_t( variant_t &&other ) noexcept {
+			if( !other.empty( ) ) {
+				ops( other.m_index ).move( raw_ptr( ), other.raw_ptr( ) );
+				m_index = other.m_index;
+			}
+		}
+
+		variant_t &operator=( variant_t const &rhs ) {
+			if( this != &rhs ) {
+				variant_t tmp( rhs );
+				*this = daw::move( tmp );
+			}
+			return *this;
+		}
+
+		variant_t &operator=( variant_t &&rhs ) noexcept {
+			if( this != &rhs ) {
+				reset( );
+				if( !rhs.empty( ) ) {
+					ops( rhs.m_index ).move( raw_ptr( ), rhs.raw_ptr( ) );
+					m_index = rhs.m_index;
+				}
+			}
+			return *this;
+		}
 
 		template<typename T, typename = std::enable_if_t<is_valid_type<T>>>
 		variant_t &operator=( T value ) {
@@ -419,30 +284,45 @@ namespace daw {
 			return *this;
 		}
 
+		bool empty( ) const noexcept {
+			return m_index >= npos;
+		}
+
+		// Position of the stored type in Types..., or sizeof...( Types ) when
+		// empty
+		size_t index( ) const noexcept {
+			return m_index;
+		}
+
 		std::type_index type_index( ) const {
-			return *m_stored_type;
+			static std::type_index const types[] = {
+			  get_type_index<Types>( )..., get_type_index<void>( )};
+			return types[m_index];
 		}
 
-		explicit operator bool( ) const {
+		explicit operator bool( ) const noexcept {
 			return !empty( );
 		}
 
-		void reset( ) {
+		void reset( ) noexcept {
 			if( !empty( ) ) {
-				get_helper_funcs( *m_stored_type ).destruct( *this );
+				ops( m_index ).destruct( raw_ptr( ) );
+				m_index = npos;
 			}
-			reset_type( );
 		}
 
 		template<typename T>
-		bool is_same_type( ) const {
-			return m_stored_type == get_type_index<T>( );
+		bool is_same_type( ) const noexcept {
+			if constexpr( is_valid_type<T> ) {
+				return m_index == index_of<T>( );
+			} else {
+				return false;
+			}
 		}
 
 		template<typename T, typename = std::enable_if_t<is_valid_type<T>>>
 		variant_t &store( T &&value ) {
-			set_type<T>( std::forward<T>( value ) );
-			//			get<T>( ) = value;
+			set_type( std::forward<T>( value ) );
 			return *this;
 		}
 
@@ -471,7 +351,7 @@ namespace daw {
 			if( empty( ) ) {
 				return "";
 			}
-			return get_helper_funcs( *m_stored_type ).to_string( *this );
+			return ops( m_index ).to_string( raw_ptr( ) );
 		}
 
 		std::string operator*( ) const {
@@ -479,8 +359,21 @@ namespace daw {
 		}
 #endif
 
-		auto compare( variant_t const &rhs ) const {
-			return get_helper_funcs( *m_stored_type ).compare( *this, rhs );
+		// Empty variants order first.  Values of different types compare by
+		// their to_string, or by type order when strings are unavailable
+		int compare( variant_t const &rhs ) const {
+			if( empty( ) or rhs.empty( ) ) {
+				return static_cast<int>( rhs.empty( ) ) -
+				       static_cast<int>( empty( ) );
+			}
+			if( m_index == rhs.m_index ) {
+				return ops( m_index ).compare( *this, rhs );
+			}
+#ifndef NOSTRING
+			return to_string( ).compare( rhs.to_string( ) );
+#else
+			return m_index < rhs.m_index ? -1 : 1;
+#endif
 		}
 
 		template<typename T, typename = std::enable_if_t<is_valid_type<T>>>
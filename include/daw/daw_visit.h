@@ -34,31 +34,96 @@
 #include "daw_overload.h"
 
 namespace daw {
-	template<size_t, size_t, typename R, typename... Args>
-	[[noreturn]] constexpr R visit_nt( Args &&... ) noexcept {
-		// This will never be called, it is there to ensure the non-called path will
-		// look like it can be called
-		std::terminate( );
-	}
-
-	template<size_t N, size_t MaxN, typename R, typename Variant,
-	         typename Visitor,
-	         std::enable_if_t<( N < MaxN ), std::nullptr_t> = nullptr>
-	constexpr R visit_nt( Variant &&var, Visitor &&vis ) {
-		if( var.index( ) == N ) {
+	namespace visit_impl {
+		// Variants holding reference_wrappers visit the referred to value
+		template<size_t I, typename Variant>
+		constexpr decltype( auto ) get_alt( Variant &&var ) {
 			if constexpr( daw::is_reference_wrapper_v<decltype(
-			                std::get<N>( std::forward<Variant>( var ) ) )> ) {
-				return daw::invoke(
-				  std::forward<Visitor>( vis ),
-				  std::get<N>( std::forward<Variant>( var ) ).get( ) );
+			                std::get<I>( std::forward<Variant>( var ) ) )> ) {
+				return std::get<I>( std::forward<Variant>( var ) ).get( );
 			} else {
-				return daw::invoke( std::forward<Visitor>( vis ),
-				                    std::get<N>( std::forward<Variant>( var ) ) );
+				return std::get<I>( std::forward<Variant>( var ) );
 			}
 		}
-		return visit_nt<N + 1, MaxN, R>( std::forward<Variant>( var ),
-		                                 std::forward<Visitor>( vis ) );
-	}
+
+		template<size_t I, typename R, typename Visitor, typename Variant>
+		constexpr R visit_alt( Visitor &vis, Variant &&var ) {
+			return daw::invoke( daw::move( vis ),
+			                    get_alt<I>( std::forward<Variant>( var ) ) );
+		}
+
+		template<typename R, typename Visitor, typename Variant,
+		         typename Indices>
+		struct visit_table;
+
+		// One entry per alternative, so dispatch is a single indirect call
+		// whatever the number of alternatives
+		template<typename R, typename Visitor, typename Variant, size_t... Is>
+		struct visit_table<R, Visitor, Variant, std::index_sequence<Is...>> {
+			using fn_t = R ( * )( Visitor &, Variant && );
+			static constexpr fn_t const table[] = {
+			  &visit_alt<Is, R, Visitor, Variant>...};
+		};
+
+		template<typename Variant>
+		inline constexpr size_t variant_size_v =
+		  std::variant_size_v<daw::remove_cvref_t<Variant>>;
+
+		template<typename R, typename Visitor, typename Variant>
+		constexpr R visit( Visitor &vis, Variant &&var ) {
+			constexpr size_t const size = variant_size_v<Variant>;
+			if( var.index( ) >= size ) {
+				// valueless_by_exception
+				std::terminate( );
+			}
+			using table_t = visit_table<R, Visitor, Variant,
+			                            std::make_index_sequence<size>>;
+			return table_t::table[var.index( )]( vis,
+			                                     std::forward<Variant>( var ) );
+		}
+
+		// The alternative of the Kth variant for an index into the table of all
+		// combinations, which is ordered with the last variant varying fastest
+		template<size_t Flat, size_t K, typename... Variants>
+		constexpr size_t alt_index( ) noexcept {
+			constexpr size_t const sizes[] = {variant_size_v<Variants>...};
+			size_t stride = 1;
+			for( size_t n = K + 1; n < sizeof...( Variants ); ++n ) {
+				stride *= sizes[n];
+			}
+			return ( Flat / stride ) % sizes[K];
+		}
+
+		template<size_t Flat, typename R, typename Visitor, size_t... Ks,
+		         typename... Variants>
+		constexpr R multi_visit_alt_impl( std::index_sequence<Ks...>,
+		                                  Visitor &vis, Variants &&... vars ) {
+			return daw::invoke(
+			  daw::move( vis ),
+			  get_alt<alt_index<Flat, Ks, Variants...>( )>(
+			    std::forward<Variants>( vars ) )... );
+		}
+
+		template<size_t Flat, typename R, typename Visitor, typename... Variants>
+		constexpr R multi_visit_alt( Visitor &vis, Variants &&... vars ) {
+			return multi_visit_alt_impl<Flat, R>(
+			  std::index_sequence_for<Variants...>{}, vis,
+			  std::forward<Variants>( vars )... );
+		}
+
+		template<typename R, typename Visitor, typename Indices,
+		         typename... Variants>
+		struct multi_visit_table;
+
+		template<typename R, typename Visitor, size_t... Is,
+		         typename... Variants>
+		struct multi_visit_table<R, Visitor, std::index_sequence<Is...>,
+		                         Variants...> {
+			using fn_t = R ( * )( Visitor &, Variants &&... );
+			static constexpr fn_t const table[] = {
+			  &multi_visit_alt<Is, R, Visitor, Variants...>...};
+		};
+	} // namespace visit_impl
 
 	template<class... Args, typename Visitor, typename... Visitors>
 	constexpr decltype( auto ) visit_nt( std::variant<Args...> const &var,
@@ -69,10 +134,7 @@ namespace daw {
 		using result_t =
 		  decltype( daw::invoke( daw::move( ol ), std::get<0>( var ) ) );
 
-		if( var.index( ) == 0 ) {
-			return daw::invoke( daw::move( ol ), std::get<0>( var ) );
-		}
-		return visit_nt<1, sizeof...( Args ), result_t>( var, daw::move( ol ) );
+		return visit_impl::visit<result_t>( ol, var );
 	}
 
 	template<class... Args, typename Visitor, typename... Visitors>
@@ -84,10 +146,7 @@ namespace daw {
 		using result_t =
 		  decltype( daw::invoke( daw::move( ol ), std::get<0>( var ) ) );
 
-		if( var.index( ) == 0 ) {
-			return daw::invoke( daw::move( ol ), std::get<0>( var ) );
-		}
-		return visit_nt<1, sizeof...( Args ), result_t>( var, daw::move( ol ) );
+		return visit_impl::visit<result_t>( ol, var );
 	}
 
 	template<class... Args, typename Visitor, typename... Visitors>
@@ -99,11 +158,38 @@ namespace daw {
 		using result_t = decltype(
 		  daw::invoke( daw::move( ol ), daw::move( std::get<0>( var ) ) ) );
 
-		if( var.index( ) == 0 ) {
-			return daw::invoke( daw::move( ol ), std::get<0>( daw::move( var ) ) );
+		return visit_impl::visit<result_t>( ol, daw::move( var ) );
+	}
+
+	// Visit several variants at once.  vis is called with the current
+	// alternative of each, through one table of every combination
+	template<typename Visitor, typename... Variants>
+	constexpr decltype( auto ) multi_visit_nt( Visitor &&vis,
+	                                           Variants &&... vars ) {
+		static_assert( sizeof...( Variants ) > 0,
+		               "At least one variant must be supplied" );
+		using result_t =
+		  decltype( daw::invoke( std::forward<Visitor>( vis ),
+		                         visit_impl::get_alt<0>(
+		                           std::forward<Variants>( vars ) )... ) );
+
+		constexpr size_t const sizes[] = {
+		  visit_impl::variant_size_v<Variants>...};
+		size_t const indices[] = {vars.index( )...};
+		size_t flat = 0;
+		for( size_t n = 0; n < sizeof...( Variants ); ++n ) {
+			if( indices[n] >= sizes[n] ) {
+				// valueless_by_exception
+				std::terminate( );
+			}
+			flat = flat * sizes[n] + indices[n];
 		}
-		return visit_nt<1, sizeof...( Args ), result_t>( daw::move( var ),
-		                                                 daw::move( ol ) );
+		using vis_t = std::remove_reference_t<Visitor>;
+		using table_t = visit_impl::multi_visit_table<
+		  result_t, vis_t,
+		  std::make_index_sequence<( visit_impl::variant_size_v<Variants> * ... )>,
+		  Variants...>;
+		return table_t::table[flat]( vis, std::forward<Variants>( vars )... );
 	}
 
 	template<typename Value, typename... Visitors>
@@ -0,0 +1,133 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "../daw_exception.h"
+#include "../daw_fnv1a_hash.h"
+#include "../daw_span.h"
+#include "../daw_traits.h"
+
+namespace daw {
+	namespace filter_impl {
+		// Default hash for the membership filters.  FNV-1a over the value for
+		// integral keys and the characters for string like keys
+		struct fnv1a_key_hash {
+			template<typename T>
+			constexpr uint64_t operator( )( T const &value ) const noexcept {
+				if constexpr( daw::is_integral_v<T> ) {
+					return daw::fnv1a_hash( value );
+				} else {
+					return daw::fnv1a_hash( std::data( value ), std::size( value ) );
+				}
+			}
+		};
+
+		// FNV-1a leaves the high bits poorly mixed for short keys.  The filters
+		// carve several independent values out of one hash so finish it with the
+		// MurmurHash3 finalizer
+		constexpr uint64_t mix64( uint64_t h ) noexcept {
+			h ^= h >> 33U;
+			h *= 0xFF51'AFD7'ED55'8CCDULL;
+			h ^= h >> 33U;
+			h *= 0xC4CE'B9FE'1A85'EC53ULL;
+			h ^= h >> 33U;
+			return h;
+		}
+
+		// Maps a 32bit value onto [0, range) without a division
+		constexpr uint32_t fast_range( uint32_t value, uint32_t range ) noexcept {
+			return static_cast<uint32_t>(
+			  ( static_cast<uint64_t>( value ) * static_cast<uint64_t>( range ) ) >>
+			  32U );
+		}
+
+		enum class filter_kind : uint16_t { bloom = 1, blocked_bloom, cuckoo };
+
+		// Serialized filters are this header followed by the filter words in
+		// native byte order.  The header is one cache line so the payload of a
+		// memory mapped file is suitably aligned for the word type
+		struct filter_header_t {
+			static constexpr uint32_t const magic_value = 0x4644'4157; // "WADF"
+			static constexpr uint16_t const current_version = 1;
+
+			uint32_t magic = magic_value;
+			uint16_t version = current_version;
+			filter_kind kind = filter_kind::bloom;
+			uint32_t parameter = 0;
+			uint32_t word_size = 0;
+			uint64_t word_count = 0;
+			uint64_t item_count = 0;
+			uint8_t reserved[32] = {};
+		};
+		static_assert( sizeof( filter_header_t ) == 64 );
+		static_assert( std::is_trivially_copyable_v<filter_header_t> );
+
+		template<typename Word, typename OStream>
+		void write_filter( OStream &os, filter_header_t const &header,
+		                   Word const *words ) {
+			os.write( reinterpret_cast<char const *>( &header ),
+			          static_cast<std::streamsize>( sizeof( header ) ) );
+			os.write( reinterpret_cast<char const *>( words ),
+			          static_cast<std::streamsize>( header.word_count *
+			                                        sizeof( Word ) ) );
+		}
+
+		// Validate a serialized filter in place and return its header.  The words
+		// start at data + sizeof( filter_header_t )
+		template<typename Word>
+		filter_header_t read_filter_header( char const *data, size_t size,
+		                                    filter_kind kind ) {
+			filter_header_t header{};
+			daw::exception::precondition_check<std::invalid_argument>(
+			  data != nullptr and size >= sizeof( header ),
+			  "Serialized filter is too small" );
+			std::memcpy( &header, data, sizeof( header ) );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  header.magic == filter_header_t::magic_value and
+			    header.version == filter_header_t::current_version,
+			  "Not a serialized filter or from an incompatible version" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  header.kind == kind and header.word_size == sizeof( Word ),
+			  "Serialized filter is of a different type" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  ( size - sizeof( header ) ) / sizeof( Word ) >= header.word_count,
+			  "Serialized filter is truncated" );
+			daw::exception::precondition_check<std::invalid_argument>(
+			  reinterpret_cast<uintptr_t>( data + sizeof( header ) ) %
+			      alignof( Word ) ==
+			    0,
+			  "Serialized filter data is misaligned" );
+			return header;
+		}
+
+		template<typename Storage>
+		inline constexpr bool is_owning_storage_v =
+		  !daw::is_daw_span_v<daw::remove_cvref_t<Storage>>;
+	} // namespace filter_impl
+} // namespace daw
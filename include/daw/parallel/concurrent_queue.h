@@ -8,8 +8,10 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstddef>
 #include <mutex>
 #include <queue>
+#include <utility>
 
 namespace daw {
 	template<typename Data>
@@ -33,6 +35,31 @@ namespace daw {
 			m_condition.notify_one( );
 		}
 
+		void push( Data &&data ) {
+			std::unique_lock<std::mutex> lock( m_mutex );
+			m_queue.push( std::move( data ) );
+			lock.unlock( );
+			m_condition.notify_one( );
+		}
+
+		// Takes the lock once for the whole batch.  Use move iterators to move
+		// the items in
+		template<typename Iterator>
+		void push_range( Iterator first, Iterator last ) {
+			std::unique_lock<std::mutex> lock( m_mutex );
+			size_t count = 0;
+			for( ; first != last; ++first ) {
+				m_queue.push( *first );
+				++count;
+			}
+			lock.unlock( );
+			if( count == 1 ) {
+				m_condition.notify_one( );
+			} else if( count > 1 ) {
+				m_condition.notify_all( );
+			}
+		}
+
 		bool empty( ) const {
 			std::unique_lock<std::mutex> lock( m_mutex );
 			return m_queue.empty( );
@@ -44,7 +71,7 @@ namespace daw {
 				return false;
 			}
 
-			popped_value = m_queue.front( );
+			popped_value = std::move( m_queue.front( ) );
 			m_queue.pop( );
 			return true;
 		}
@@ -58,7 +85,7 @@ namespace daw {
 				}
 			}
 
-			popped_value = m_queue.front( );
+			popped_value = std::move( m_queue.front( ) );
 			m_queue.pop( );
 		}
 
@@ -0,0 +1,345 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "daw_epoch.h"
+
+namespace daw {
+	// A chained hash map with lock-free readers.  Writers take one of a fixed
+	// number of stripe locks, readers never lock.  Nodes are immutable once
+	// published, so insert_or_assign replaces the node and the old one is freed
+	// after all readers that could have seen it have left.  Readers pin the
+	// map's epoch_domain and writers retire replaced nodes to it, so neither
+	// waits on the other.  Growing takes all stripe locks and copies the nodes
+	// into a new bucket array while readers continue on the old one
+	template<typename Key, typename Value, typename Hash = std::hash<Key>,
+	         typename KeyEqual = std::equal_to<Key>>
+	class concurrent_hash_map {
+		struct node_t {
+			Key const key;
+			Value const value;
+			size_t const hash;
+			std::atomic<node_t *> next;
+
+			template<typename K, typename V>
+			node_t( K &&k, V &&v, size_t h )
+			  : key( std::forward<K>( k ) )
+			  , value( std::forward<V>( v ) )
+			  , hash( h )
+			  , next( nullptr ) {}
+		};
+
+		struct bucket_array_t {
+			std::unique_ptr<std::atomic<node_t *>[]> buckets;
+			size_t size;
+			size_t shift;
+
+			explicit bucket_array_t( size_t bucket_count )
+			  : buckets( std::make_unique<std::atomic<node_t *>[]>( bucket_count ) )
+			  , size( bucket_count )
+			  , shift( std::numeric_limits<size_t>::digits - log2( bucket_count ) ) {
+			}
+
+			std::atomic<node_t *> &operator[]( size_t hash ) noexcept {
+				return buckets[hash >> shift];
+			}
+
+			std::atomic<node_t *> const &operator[]( size_t hash ) const noexcept {
+				return buckets[hash >> shift];
+			}
+		};
+
+		struct alignas( 64 ) stripe_t {
+			std::mutex mutex{};
+			std::atomic<size_t> size = 0;
+		};
+
+		static constexpr size_t const stripe_bits = 5;
+		static constexpr size_t const stripe_count = 1ULL << stripe_bits;
+
+		std::atomic<bucket_array_t *> m_table;
+		std::unique_ptr<stripe_t[]> m_stripes =
+		  std::make_unique<stripe_t[]>( stripe_count );
+		epoch_domain m_domain{};
+
+		static constexpr size_t log2( size_t n ) noexcept {
+			size_t result = 0;
+			while( n > 1 ) {
+				n >>= 1U;
+				++result;
+			}
+			return result;
+		}
+
+		template<typename K>
+		static size_t hash_of( K const &key ) {
+			// Fibonacci hashing, the top bits select the stripe and the bucket so
+			// a key stays in the same stripe when the bucket array grows
+			return Hash{}( key ) * static_cast<size_t>( 0x9E37'79B9'7F4A'7C15ULL );
+		}
+
+		stripe_t &stripe_for( size_t hash ) noexcept {
+			return m_stripes[hash >> ( std::numeric_limits<size_t>::digits -
+			                           stripe_bits )];
+		}
+
+		bool needs_grow( stripe_t const &stripe,
+		                 bucket_array_t const &table ) const noexcept {
+			return stripe.size.load( std::memory_order_relaxed ) >
+			       table.size / stripe_count;
+		}
+
+		void grow( bucket_array_t *expected ) {
+			for( size_t n = 0; n < stripe_count; ++n ) {
+				m_stripes[n].mutex.lock( );
+			}
+			struct unlock_all_t {
+				stripe_t *stripes;
+				~unlock_all_t( ) noexcept {
+					for( size_t n = stripe_count; n > 0; --n ) {
+						stripes[n - 1].mutex.unlock( );
+					}
+				}
+			} const unlock_all{m_stripes.get( )};
+
+			auto *old_table = m_table.load( std::memory_order_relaxed );
+			if( old_table != expected ) {
+				// Another writer already grew the table
+				return;
+			}
+			auto *new_table = new bucket_array_t( old_table->size * 2 );
+			try {
+				for( size_t n = 0; n < old_table->size; ++n ) {
+					auto *cur = old_table->buckets[n].load( std::memory_order_relaxed );
+					while( cur != nullptr ) {
+						auto *node = new node_t( cur->key, cur->value, cur->hash );
+						auto &head = ( *new_table )[cur->hash];
+						node->next.store( head.load( std::memory_order_relaxed ),
+						                  std::memory_order_relaxed );
+						head.store( node, std::memory_order_relaxed );
+						cur = cur->next.load( std::memory_order_relaxed );
+					}
+				}
+			} catch( ... ) {
+				destroy_table( new_table );
+				throw;
+			}
+			m_table.store( new_table, std::memory_order_release );
+
+			for( size_t n = 0; n < old_table->size; ++n ) {
+				auto *cur = old_table->buckets[n].load( std::memory_order_relaxed );
+				while( cur != nullptr ) {
+					// Retiring can free this thread's older retirements, read
+					// next first
+					auto *next = cur->next.load( std::memory_order_relaxed );
+					m_domain.retire( cur );
+					cur = next;
+				}
+			}
+			m_domain.retire( old_table );
+		}
+
+		static void destroy_table( bucket_array_t *table ) noexcept {
+			for( size_t n = 0; n < table->size; ++n ) {
+				auto *cur = table->buckets[n].load( std::memory_order_relaxed );
+				while( cur != nullptr ) {
+					auto *next = cur->next.load( std::memory_order_relaxed );
+					delete cur;
+					cur = next;
+				}
+			}
+			delete table;
+		}
+
+		template<typename K, typename Visitor>
+		bool visit_impl( K const &key, Visitor &&visitor ) const {
+			auto const hash = hash_of( key );
+			auto const guard = m_domain.pin( );
+			auto const &table = *m_table.load( std::memory_order_acquire );
+			auto const *cur = table[hash].load( std::memory_order_acquire );
+			while( cur != nullptr ) {
+				if( cur->hash == hash and KeyEqual{}( cur->key, key ) ) {
+					visitor( cur->key, cur->value );
+					return true;
+				}
+				cur = cur->next.load( std::memory_order_acquire );
+			}
+			return false;
+		}
+
+	public:
+		using key_type = Key;
+		using mapped_type = Value;
+		using size_type = size_t;
+		using hasher = Hash;
+		using key_equal = KeyEqual;
+
+		explicit concurrent_hash_map( size_t bucket_count = 1024 )
+		  : m_table( nullptr ) {
+			size_t sz = stripe_count;
+			while( sz < bucket_count ) {
+				sz <<= 1U;
+			}
+			m_table.store( new bucket_array_t( sz ) );
+		}
+
+		concurrent_hash_map( concurrent_hash_map const & ) = delete;
+		concurrent_hash_map( concurrent_hash_map && ) = delete;
+		concurrent_hash_map &operator=( concurrent_hash_map const & ) = delete;
+		concurrent_hash_map &operator=( concurrent_hash_map && ) = delete;
+
+		// Nodes and tables still retired are freed with m_domain
+		~concurrent_hash_map( ) noexcept {
+			destroy_table( m_table.load( ) );
+		}
+
+		// Returns true if the key was inserted and false if an existing value was
+		// replaced
+		template<typename K, typename V>
+		bool insert_or_assign( K &&key, V &&value ) {
+			auto const hash = hash_of( key );
+			auto new_node = std::make_unique<node_t>(
+			  std::forward<K>( key ), std::forward<V>( value ), hash );
+			bucket_array_t *grow_from = nullptr;
+			bool inserted = false;
+			{
+				auto &stripe = stripe_for( hash );
+				std::lock_guard<std::mutex> lock( stripe.mutex );
+				// The table cannot change while a stripe lock is held
+				auto *table = m_table.load( std::memory_order_acquire );
+				std::atomic<node_t *> *link = &( *table )[hash];
+				auto *cur = link->load( std::memory_order_relaxed );
+				while( cur != nullptr and
+				       !( cur->hash == hash and
+				          KeyEqual{}( cur->key, new_node->key ) ) ) {
+					link = &cur->next;
+					cur = link->load( std::memory_order_relaxed );
+				}
+				if( cur != nullptr ) {
+					new_node->next.store( cur->next.load( std::memory_order_relaxed ),
+					                      std::memory_order_relaxed );
+					link->store( new_node.release( ), std::memory_order_release );
+					m_domain.retire( cur );
+				} else {
+					auto &head = ( *table )[hash];
+					new_node->next.store( head.load( std::memory_order_relaxed ),
+					                      std::memory_order_relaxed );
+					head.store( new_node.release( ), std::memory_order_release );
+					stripe.size.fetch_add( 1, std::memory_order_relaxed );
+					inserted = true;
+					if( needs_grow( stripe, *table ) ) {
+						grow_from = table;
+					}
+				}
+			}
+			if( grow_from != nullptr ) {
+				grow( grow_from );
+			}
+			return inserted;
+		}
+
+		bool erase( Key const &key ) {
+			auto const hash = hash_of( key );
+			{
+				auto &stripe = stripe_for( hash );
+				std::lock_guard<std::mutex> lock( stripe.mutex );
+				auto *table = m_table.load( std::memory_order_acquire );
+				std::atomic<node_t *> *link = &( *table )[hash];
+				auto *cur = link->load( std::memory_order_relaxed );
+				while( cur != nullptr and
+				       !( cur->hash == hash and KeyEqual{}( cur->key, key ) ) ) {
+					link = &cur->next;
+					cur = link->load( std::memory_order_relaxed );
+				}
+				if( cur == nullptr ) {
+					return false;
+				}
+				link->store( cur->next.load( std::memory_order_relaxed ),
+				             std::memory_order_release );
+				stripe.size.fetch_sub( 1, std::memory_order_relaxed );
+				m_domain.retire( cur );
+			}
+			return true;
+		}
+
+		// Call visitor( key, value ) with the current value of key, if any.  The
+		// value stays valid until the visitor returns, even if it is erased or
+		// replaced concurrently
+		template<typename Visitor>
+		bool visit( Key const &key, Visitor &&visitor ) const {
+			return visit_impl( key, std::forward<Visitor>( visitor ) );
+		}
+
+		std::optional<Value> find( Key const &key ) const {
+			std::optional<Value> result{};
+			visit_impl( key, [&result]( Key const &, Value const &value ) {
+				result = value;
+			} );
+			return result;
+		}
+
+		bool contains( Key const &key ) const {
+			return visit_impl( key, []( Key const &, Value const & ) {} );
+		}
+
+		// Call func( key, value ) for every element.  This does not block writers,
+		// elements inserted or erased while iterating may or may not be seen
+		template<typename Function>
+		void for_each( Function &&func ) const {
+			auto const guard = m_domain.pin( );
+			auto const &table = *m_table.load( std::memory_order_acquire );
+			for( size_t n = 0; n < table.size; ++n ) {
+				auto const *cur = table.buckets[n].load( std::memory_order_acquire );
+				while( cur != nullptr ) {
+					func( cur->key, cur->value );
+					cur = cur->next.load( std::memory_order_acquire );
+				}
+			}
+		}
+
+		size_t size( ) const noexcept {
+			size_t result = 0;
+			for( size_t n = 0; n < stripe_count; ++n ) {
+				result += m_stripes[n].size.load( std::memory_order_relaxed );
+			}
+			return result;
+		}
+
+		bool empty( ) const noexcept {
+			return size( ) == 0;
+		}
+
+		size_t bucket_count( ) const noexcept {
+			return m_table.load( std::memory_order_acquire )->size;
+		}
+	};
+} // namespace daw
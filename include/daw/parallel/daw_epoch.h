@@ -0,0 +1,409 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../daw_exception.h"
+
+namespace daw {
+	namespace epoch_impl {
+		struct retired_t {
+			void *ptr;
+			void ( *deleter )( void * );
+			uint64_t epoch;
+		};
+
+		template<typename T>
+		void delete_as( void *ptr ) {
+			delete static_cast<T *>( ptr );
+		}
+
+		inline constexpr size_t const hazard_slots = 4;
+
+		// One per thread and domain.  Only the owning thread touches the fields
+		// that are not atomic
+		struct alignas( 64 ) record_t {
+			// ( epoch << 1 ) | pinned
+			std::atomic<uint64_t> epoch{0};
+			std::atomic<bool> in_use{true};
+			std::array<std::atomic<void *>, hazard_slots> hazards{};
+			uint32_t hazards_taken = 0;
+			size_t nesting = 0;
+			std::vector<retired_t> retired{};
+			// Set once when the record is published
+			record_t *next = nullptr;
+		};
+
+		class domain_state {
+			std::atomic<uint64_t> m_epoch{2};
+			std::atomic<record_t *> m_records{nullptr};
+			std::mutex m_orphan_mutex{};
+			std::vector<retired_t> m_orphans{};
+
+			// Everyone pinned has seen the current epoch, move to the next one
+			bool try_advance( ) noexcept {
+				auto epoch = m_epoch.load( );
+				for( auto *rec = m_records.load( std::memory_order_acquire );
+				     rec != nullptr; rec = rec->next ) {
+					auto const local = rec->epoch.load( );
+					if( ( local & 1U ) != 0 and ( local >> 1U ) != epoch ) {
+						return false;
+					}
+				}
+				return m_epoch.compare_exchange_strong( epoch, epoch + 1U );
+			}
+
+			std::vector<void *> protected_pointers( ) const {
+				std::vector<void *> result{};
+				for( auto *rec = m_records.load( std::memory_order_acquire );
+				     rec != nullptr; rec = rec->next ) {
+					for( auto const &hp : rec->hazards ) {
+						if( auto *p = hp.load( ); p != nullptr ) {
+							result.push_back( p );
+						}
+					}
+				}
+				std::sort( result.begin( ), result.end( ) );
+				return result;
+			}
+
+			// Free what no thread can still reach and keep the rest
+			void free_safe( std::vector<retired_t> &items ) {
+				auto const epoch = m_epoch.load( );
+				auto const hazards = protected_pointers( );
+				auto keep = std::partition(
+				  items.begin( ), items.end( ), [&]( retired_t const &item ) {
+					  return item.epoch + 2U > epoch or
+					         std::binary_search( hazards.begin( ), hazards.end( ),
+					                             item.ptr );
+				  } );
+				for( auto it = keep; it != items.end( ); ++it ) {
+					it->deleter( it->ptr );
+				}
+				items.erase( keep, items.end( ) );
+			}
+
+		public:
+			domain_state( ) = default;
+			domain_state( domain_state const & ) = delete;
+			domain_state &operator=( domain_state const & ) = delete;
+
+			// Only runs once no thread can use the domain
+			~domain_state( ) {
+				auto *rec = m_records.load( );
+				while( rec != nullptr ) {
+					for( auto &item : rec->retired ) {
+						item.deleter( item.ptr );
+					}
+					delete std::exchange( rec, rec->next );
+				}
+				for( auto &item : m_orphans ) {
+					item.deleter( item.ptr );
+				}
+			}
+
+			uint64_t epoch( ) const noexcept {
+				return m_epoch.load( );
+			}
+
+			record_t *acquire_record( ) {
+				for( auto *rec = m_records.load( std::memory_order_acquire );
+				     rec != nullptr; rec = rec->next ) {
+					bool expected = false;
+					if( not rec->in_use.load( std::memory_order_relaxed ) and
+					    rec->in_use.compare_exchange_strong( expected, true ) ) {
+						return rec;
+					}
+				}
+				auto *rec = new record_t{};
+				rec->next = m_records.load( std::memory_order_relaxed );
+				while( not m_records.compare_exchange_weak(
+				  rec->next, rec, std::memory_order_release,
+				  std::memory_order_relaxed ) ) {}
+				return rec;
+			}
+
+			// The owning thread is exiting, what it retired becomes shared
+			void release_record( record_t *rec ) {
+				if( not rec->retired.empty( ) ) {
+					std::lock_guard<std::mutex> lck( m_orphan_mutex );
+					m_orphans.insert( m_orphans.end( ), rec->retired.begin( ),
+					                  rec->retired.end( ) );
+					rec->retired.clear( );
+				}
+				rec->epoch.store( 0, std::memory_order_release );
+				rec->in_use.store( false, std::memory_order_release );
+			}
+
+			void pin( record_t &rec ) noexcept {
+				if( rec.nesting++ == 0 ) {
+					// A sequentially consistent RMW publishes the pin before any shared
+					// pointer is read, and is cheaper than a store and a full fence
+					rec.epoch.exchange( ( m_epoch.load( ) << 1U ) | 1U );
+				}
+			}
+
+			void unpin( record_t &rec ) noexcept {
+				if( --rec.nesting == 0 ) {
+					rec.epoch.store( m_epoch.load( std::memory_order_relaxed ) << 1U,
+					                 std::memory_order_release );
+				}
+			}
+
+			void collect( record_t &rec ) {
+				try_advance( );
+				free_safe( rec.retired );
+				std::unique_lock<std::mutex> lck( m_orphan_mutex, std::try_to_lock );
+				if( lck.owns_lock( ) and not m_orphans.empty( ) ) {
+					free_safe( m_orphans );
+				}
+			}
+
+			void collect_all( record_t &rec ) {
+				// Two advances put everything retired so far two epochs behind
+				for( size_t n = 0; n < 2; ++n ) {
+					try_advance( );
+				}
+				free_safe( rec.retired );
+				std::lock_guard<std::mutex> lck( m_orphan_mutex );
+				free_safe( m_orphans );
+			}
+		};
+
+		// A thread's records in every domain it used.  Dead domains are skipped
+		// at thread exit and pruned when a new domain is added
+		class thread_records_t {
+			struct entry_t {
+				uint64_t domain_id;
+				record_t *record;
+				std::weak_ptr<domain_state> state;
+			};
+			std::vector<entry_t> m_entries{};
+
+		public:
+			thread_records_t( ) = default;
+			thread_records_t( thread_records_t const & ) = delete;
+			thread_records_t &operator=( thread_records_t const & ) = delete;
+
+			~thread_records_t( ) {
+				for( auto &entry : m_entries ) {
+					if( auto state = entry.state.lock( ) ) {
+						state->release_record( entry.record );
+					}
+				}
+			}
+
+			record_t &get( uint64_t domain_id,
+			               std::shared_ptr<domain_state> const &state ) {
+				for( auto &entry : m_entries ) {
+					if( entry.domain_id == domain_id ) {
+						return *entry.record;
+					}
+				}
+				m_entries.erase(
+				  std::remove_if(
+				    m_entries.begin( ), m_entries.end( ),
+				    []( entry_t const &entry ) { return entry.state.expired( ); } ),
+				  m_entries.end( ) );
+				auto *rec = state->acquire_record( );
+				m_entries.push_back( entry_t{domain_id, rec, state} );
+				return *rec;
+			}
+		};
+
+		inline uint64_t next_domain_id( ) noexcept {
+			static std::atomic<uint64_t> id{0};
+			return ++id;
+		}
+	} // namespace epoch_impl
+
+	// Epoch based memory reclamation.  A thread pins the domain while it reads
+	// shared pointers, and objects unlinked from a structure are retired
+	// instead of deleted.  Retired objects are freed in batches once every
+	// pinned thread has moved two epochs past the retirement.  A hazard
+	// pointer protects a single object without pinning, for references that
+	// are held long enough that a pin would stall reclamation.
+	//
+	// Pins and retires only touch the calling thread's record.  A domain must
+	// outlive its guards and hazard pointers; threads may outlive the domain
+	template<size_t RetireBatch = 64>
+	class basic_epoch_domain {
+		std::shared_ptr<epoch_impl::domain_state> m_state =
+		  std::make_shared<epoch_impl::domain_state>( );
+		uint64_t m_id = epoch_impl::next_domain_id( );
+
+		epoch_impl::record_t &record( ) const {
+			// Plain thread_locals need no initialization check, so the common case
+			// of a thread using the same domain repeatedly stays cheap.  Domain ids
+			// are never reused, so a stale entry cannot match
+			thread_local uint64_t last_id = 0;
+			thread_local epoch_impl::record_t *last_record = nullptr;
+			if( last_id != m_id ) {
+				thread_local epoch_impl::thread_records_t records{};
+				last_record = &records.get( m_id, m_state );
+				last_id = m_id;
+			}
+			return *last_record;
+		}
+
+	public:
+		basic_epoch_domain( ) = default;
+		basic_epoch_domain( basic_epoch_domain const & ) = delete;
+		basic_epoch_domain &operator=( basic_epoch_domain const & ) = delete;
+
+		// Keeps what was reachable when it was created alive until it ends
+		class guard {
+			epoch_impl::domain_state *m_state;
+			epoch_impl::record_t *m_record;
+
+		public:
+			explicit guard( basic_epoch_domain const &domain )
+			  : m_state( domain.m_state.get( ) )
+			  , m_record( &domain.record( ) ) {
+
+				m_state->pin( *m_record );
+			}
+
+			guard( guard &&other ) noexcept
+			  : m_state( std::exchange( other.m_state, nullptr ) )
+			  , m_record( std::exchange( other.m_record, nullptr ) ) {}
+
+			guard &operator=( guard && ) = delete;
+			guard( guard const & ) = delete;
+			guard &operator=( guard const & ) = delete;
+
+			~guard( ) {
+				if( m_record != nullptr ) {
+					m_state->unpin( *m_record );
+				}
+			}
+		};
+
+		// Protects one pointer at a time from reclamation
+		class hazard_pointer {
+			epoch_impl::record_t *m_record;
+			std::atomic<void *> *m_slot;
+			uint32_t m_slot_bit;
+
+		public:
+			explicit hazard_pointer( basic_epoch_domain const &domain )
+			  : m_record( &domain.record( ) )
+			  , m_slot( nullptr )
+			  , m_slot_bit( 0 ) {
+
+				for( size_t n = 0; n < epoch_impl::hazard_slots; ++n ) {
+					auto const bit = uint32_t{1} << n;
+					if( ( m_record->hazards_taken & bit ) == 0 ) {
+						m_record->hazards_taken |= bit;
+						m_slot = &m_record->hazards[n];
+						m_slot_bit = bit;
+						return;
+					}
+				}
+				daw::exception::daw_throw<std::length_error>(
+				  "Too many hazard pointers on this thread" );
+			}
+
+			hazard_pointer( hazard_pointer const & ) = delete;
+			hazard_pointer &operator=( hazard_pointer const & ) = delete;
+
+			~hazard_pointer( ) {
+				m_slot->store( nullptr, std::memory_order_release );
+				m_record->hazards_taken &= ~m_slot_bit;
+			}
+
+			// Load src and protect the result.  It stays valid, even after being
+			// retired, until reset or another protect
+			template<typename T>
+			T *protect( std::atomic<T *> const &src ) noexcept {
+				auto *ptr = src.load( std::memory_order_relaxed );
+				while( true ) {
+					m_slot->store( ptr );
+					auto *again = src.load( );
+					if( again == ptr ) {
+						return ptr;
+					}
+					ptr = again;
+				}
+			}
+
+			void reset( ) noexcept {
+				m_slot->store( nullptr, std::memory_order_release );
+			}
+		};
+
+		[[nodiscard]] guard pin( ) const {
+			return guard( *this );
+		}
+
+		[[nodiscard]] hazard_pointer make_hazard_pointer( ) const {
+			return hazard_pointer( *this );
+		}
+
+		// Free ptr with deleter once no reader can hold it.  Every RetireBatch
+		// retires on a thread attempt to advance the epoch and free what is safe
+		void retire( void *ptr, void ( *deleter )( void * ) ) {
+			auto &rec = record( );
+			rec.retired.push_back(
+			  epoch_impl::retired_t{ptr, deleter, m_state->epoch( )} );
+			if( rec.retired.size( ) % RetireBatch == 0 ) {
+				m_state->collect( rec );
+			}
+		}
+
+		template<typename T>
+		void retire( T *ptr ) {
+			retire( static_cast<void *>( ptr ), &epoch_impl::delete_as<T> );
+		}
+
+		// Free what the calling thread and exited threads retired that is safe
+		// to, waiting for nothing.  At a point where no thread is pinned this
+		// frees all of those that are not hazard protected.  Objects retired by
+		// other live threads wait until those threads retire or collect, their
+		// lists are only ever touched by their owner
+		void collect( ) {
+			m_state->collect_all( record( ) );
+		}
+
+		// Number of objects the calling thread retired that are not freed yet
+		size_t pending( ) const {
+			return record( ).retired.size( );
+		}
+
+		uint64_t epoch( ) const noexcept {
+			return m_state->epoch( );
+		}
+	};
+
+	using epoch_domain = basic_epoch_domain<>;
+} // namespace daw
@@ -24,13 +24,16 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <thread>
 
 #include "../cpp_17.h"
 #include "../daw_exception.h"
 #include "../daw_move.h"
 #include "daw_condition_variable.h"
+#include "daw_spin_lock.h"
 
 namespace daw {
 	template<typename>
@@ -220,4 +223,112 @@ namespace daw {
 			sem->wait( );
 		}
 	}
+
+	namespace barrier_impl {
+		struct no_completion {
+			constexpr void operator( )( ) const noexcept {}
+		};
+	} // namespace barrier_impl
+
+	// A reusable barrier for a fixed group of threads.  Each phase ends when
+	// every participant has arrived; the last to arrive runs the completion
+	// function, if any, before anyone is released.  Arrival is one atomic
+	// decrement and waiting spins on the phase number before sleeping on it,
+	// so tightly synchronized loops rarely enter the kernel
+	template<typename CompletionFunction = barrier_impl::no_completion>
+	class basic_barrier {
+		// Waiters spin on m_phase while arrivals hammer m_remaining, keep them
+		// on separate cache lines
+		alignas( 64 ) std::atomic<uint32_t> m_phase{0};
+		std::atomic<uint32_t> m_waiters{0};
+		alignas( 64 ) std::atomic<ptrdiff_t> m_remaining;
+		std::atomic<ptrdiff_t> m_expected;
+		CompletionFunction m_completion;
+
+		// Spinning only pays when the threads we wait on can run at the same
+		// time as us
+		static size_t spin_count( ) noexcept {
+			static size_t const result =
+			  std::thread::hardware_concurrency( ) > 1 ? 4096U : 0U;
+			return result;
+		}
+
+		void complete_phase( ) {
+			m_completion( );
+			m_remaining.store( m_expected.load( std::memory_order_relaxed ),
+			                   std::memory_order_relaxed );
+			m_phase.fetch_add( 1 );
+			if( m_waiters.load( ) > 0 ) {
+				spin_lock_impl::unpark_all( m_phase );
+			}
+		}
+
+	public:
+		// Identifies the phase a call to arrive took part in
+		using arrival_token = uint32_t;
+
+		template<typename Integer>
+		explicit basic_barrier( Integer count,
+		                        CompletionFunction completion = {} )
+		  : m_remaining( static_cast<ptrdiff_t>( count ) )
+		  , m_expected( static_cast<ptrdiff_t>( count ) )
+		  , m_completion( daw::move( completion ) ) {
+
+			static_assert( std::is_integral_v<Integer> );
+			assert( count > 0 );
+		}
+
+		basic_barrier( basic_barrier const & ) = delete;
+		basic_barrier &operator=( basic_barrier const & ) = delete;
+
+		// Count update arrivals towards the current phase without waiting
+		[[nodiscard]] arrival_token arrive( ptrdiff_t update = 1 ) {
+			assert( update > 0 );
+			auto const phase = m_phase.load( std::memory_order_acquire );
+			auto const remaining =
+			  m_remaining.fetch_sub( update, std::memory_order_acq_rel ) - update;
+			assert( remaining >= 0 );
+			if( remaining == 0 ) {
+				complete_phase( );
+			}
+			return phase;
+		}
+
+		// Block until the phase token belongs to has completed
+		void wait( arrival_token token ) {
+			for( size_t n = 0; n < spin_count( ); ++n ) {
+				if( m_phase.load( std::memory_order_acquire ) != token ) {
+					return;
+				}
+				spin_lock_impl::cpu_relax( );
+			}
+			m_waiters.fetch_add( 1 );
+			// park returns immediately if the phase has already moved on
+			while( m_phase.load( ) == token ) {
+				spin_lock_impl::park( m_phase, token );
+			}
+			m_waiters.fetch_sub( 1, std::memory_order_relaxed );
+		}
+
+		void arrive_and_wait( ) {
+			wait( arrive( ) );
+		}
+
+		// Arrive and leave the group, later phases wait for one thread fewer
+		void arrive_and_drop( ) {
+			m_expected.fetch_sub( 1, std::memory_order_relaxed );
+			static_cast<void>( arrive( ) );
+		}
+
+		// Number of phases completed so far, modulo 2^32
+		uint32_t phase( ) const noexcept {
+			return m_phase.load( std::memory_order_acquire );
+		}
+	};
+
+	template<typename CompletionFunction>
+	basic_barrier( ptrdiff_t, CompletionFunction )
+	  ->basic_barrier<CompletionFunction>;
+
+	using barrier = basic_barrier<>;
 } // namespace daw
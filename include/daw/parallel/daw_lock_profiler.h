@@ -0,0 +1,409 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace daw {
+	namespace lock_profiler_impl {
+		// Bucket n counts durations in [2^n, 2^(n+1)) nanoseconds, with 0 in the
+		// first and everything from about 4s up in the last
+		inline constexpr size_t const histogram_buckets = 32;
+
+		constexpr size_t bucket_for( uint64_t ns ) noexcept {
+			size_t bucket = 0;
+			while( ns > 1 and bucket + 1 < histogram_buckets ) {
+				ns >>= 1U;
+				++bucket;
+			}
+			return bucket;
+		}
+
+		inline std::string format_ns( uint64_t ns ) {
+			constexpr size_t const unit_count = 4;
+			char const *const units[unit_count] = {"ns", "us", "ms", "s"};
+			auto value = static_cast<double>( ns );
+			size_t unit = 0;
+			while( value >= 1000.0 and unit + 1 < unit_count ) {
+				value /= 1000.0;
+				++unit;
+			}
+			auto result = std::to_string( static_cast<uint64_t>( value ) );
+			return result + units[unit];
+		}
+	} // namespace lock_profiler_impl
+
+	// What was recorded for one lock site at the time of the call
+	struct lock_site_stats {
+		using histogram_t =
+		  std::array<uint64_t, lock_profiler_impl::histogram_buckets>;
+
+		std::string name{};
+		uint64_t acquisitions = 0;
+		// Acquisitions that found the lock held and had to wait
+		uint64_t contended = 0;
+		uint64_t failed_try_locks = 0;
+		std::chrono::nanoseconds total_wait{0};
+		// Hold times are sampled, see profiled_lock
+		uint64_t hold_samples = 0;
+		std::chrono::nanoseconds total_hold{0};
+		histogram_t wait_histogram{};
+		histogram_t hold_histogram{};
+
+		// Upper bound of the histogram bucket holding the p'th fraction of samples
+		static std::chrono::nanoseconds percentile( histogram_t const &hist,
+		                                            double p ) noexcept {
+			uint64_t total = 0;
+			for( auto c : hist ) {
+				total += c;
+			}
+			if( total == 0 ) {
+				return std::chrono::nanoseconds( 0 );
+			}
+			auto const target =
+			  static_cast<uint64_t>( p * static_cast<double>( total ) );
+			uint64_t seen = 0;
+			for( size_t n = 0; n < hist.size( ); ++n ) {
+				seen += hist[n];
+				if( seen > target or seen == total ) {
+					return std::chrono::nanoseconds( uint64_t{1} << ( n + 1 ) );
+				}
+			}
+			return std::chrono::nanoseconds( uint64_t{1} << hist.size( ) );
+		}
+
+		std::chrono::nanoseconds wait_percentile( double p ) const noexcept {
+			return percentile( wait_histogram, p );
+		}
+
+		std::chrono::nanoseconds hold_percentile( double p ) const noexcept {
+			return percentile( hold_histogram, p );
+		}
+
+		std::chrono::nanoseconds mean_hold( ) const noexcept {
+			if( hold_samples == 0 ) {
+				return std::chrono::nanoseconds( 0 );
+			}
+			return total_hold / hold_samples;
+		}
+
+		double contention_ratio( ) const noexcept {
+			if( acquisitions == 0 ) {
+				return 0.0;
+			}
+			return static_cast<double>( contended ) /
+			       static_cast<double>( acquisitions );
+		}
+	};
+
+	// Counters shared by every profiled lock created with the same name.  Updates
+	// are relaxed and mostly happen while the lock is held, so a site's cache
+	// line travels with its lock instead of adding traffic of its own
+	class lock_site {
+		using histogram_t =
+		  std::array<std::atomic<uint64_t>, lock_profiler_impl::histogram_buckets>;
+
+		std::string m_name;
+		std::atomic<uint64_t> m_acquisitions = 0;
+		std::atomic<uint64_t> m_contended = 0;
+		std::atomic<uint64_t> m_failed_try_locks = 0;
+		std::atomic<uint64_t> m_total_wait = 0;
+		std::atomic<uint64_t> m_hold_samples = 0;
+		std::atomic<uint64_t> m_total_hold = 0;
+		histogram_t m_wait{};
+		histogram_t m_hold{};
+
+		static void add( std::atomic<uint64_t> &a, uint64_t v ) noexcept {
+			a.fetch_add( v, std::memory_order_relaxed );
+		}
+
+	public:
+		explicit lock_site( std::string name )
+		  : m_name( std::move( name ) ) {}
+
+		lock_site( lock_site const & ) = delete;
+		lock_site &operator=( lock_site const & ) = delete;
+
+		std::string const &name( ) const noexcept {
+			return m_name;
+		}
+
+		void record_acquire( uint64_t wait_ns, bool contended ) noexcept {
+			add( m_acquisitions, 1 );
+			if( contended ) {
+				add( m_contended, 1 );
+				add( m_total_wait, wait_ns );
+				add( m_wait[lock_profiler_impl::bucket_for( wait_ns )], 1 );
+			}
+		}
+
+		void record_failed_try_lock( ) noexcept {
+			add( m_failed_try_locks, 1 );
+		}
+
+		void record_release( uint64_t hold_ns ) noexcept {
+			add( m_hold_samples, 1 );
+			add( m_total_hold, hold_ns );
+			add( m_hold[lock_profiler_impl::bucket_for( hold_ns )], 1 );
+		}
+
+		lock_site_stats stats( ) const {
+			auto const get = []( std::atomic<uint64_t> const &a ) {
+				return a.load( std::memory_order_relaxed );
+			};
+			lock_site_stats result{};
+			result.name = m_name;
+			result.acquisitions = get( m_acquisitions );
+			result.contended = get( m_contended );
+			result.failed_try_locks = get( m_failed_try_locks );
+			result.total_wait = std::chrono::nanoseconds( get( m_total_wait ) );
+			result.hold_samples = get( m_hold_samples );
+			result.total_hold = std::chrono::nanoseconds( get( m_total_hold ) );
+			for( size_t n = 0; n < lock_profiler_impl::histogram_buckets; ++n ) {
+				result.wait_histogram[n] = get( m_wait[n] );
+				result.hold_histogram[n] = get( m_hold[n] );
+			}
+			// Uncontended acquisitions waited 0ns and are not counted one by one.
+			// The counters are read separately, so contended may have moved ahead
+			if( result.acquisitions > result.contended ) {
+				result.wait_histogram[0] += result.acquisitions - result.contended;
+			}
+			return result;
+		}
+
+		void reset( ) noexcept {
+			for( auto *a : {&m_acquisitions, &m_contended, &m_failed_try_locks,
+			                &m_total_wait, &m_hold_samples, &m_total_hold} ) {
+				a->store( 0, std::memory_order_relaxed );
+			}
+			for( size_t n = 0; n < lock_profiler_impl::histogram_buckets; ++n ) {
+				m_wait[n].store( 0, std::memory_order_relaxed );
+				m_hold[n].store( 0, std::memory_order_relaxed );
+			}
+		}
+	};
+
+	namespace lock_profiler_impl {
+		struct registry_t {
+			std::mutex mutex{};
+			std::map<std::string, std::unique_ptr<lock_site>, std::less<>> sites{};
+		};
+
+		// Never destroyed, so locks with static storage may still unlock after
+		// main returns
+		inline registry_t &registry( ) {
+			static auto *const result = new registry_t{};
+			return *result;
+		}
+	} // namespace lock_profiler_impl
+
+	// The site registered under name, created on first use.  Sites live until
+	// the program ends so stats outlast the locks that recorded them
+	inline lock_site &get_lock_site( std::string_view name ) {
+		auto &reg = lock_profiler_impl::registry( );
+		std::lock_guard<std::mutex> lock( reg.mutex );
+		auto pos = reg.sites.find( name );
+		if( pos == reg.sites.end( ) ) {
+			pos = reg.sites
+			        .emplace( std::string( name ),
+			                  std::make_unique<lock_site>( std::string( name ) ) )
+			        .first;
+		}
+		return *pos->second;
+	}
+
+	// Every site, most total wait time first
+	inline std::vector<lock_site_stats> lock_profile( ) {
+		std::vector<lock_site_stats> result{};
+		{
+			auto &reg = lock_profiler_impl::registry( );
+			std::lock_guard<std::mutex> lock( reg.mutex );
+			result.reserve( reg.sites.size( ) );
+			for( auto const &site : reg.sites ) {
+				result.push_back( site.second->stats( ) );
+			}
+		}
+		std::stable_sort( result.begin( ), result.end( ),
+		                  []( auto const &lhs, auto const &rhs ) {
+			                  if( lhs.total_wait != rhs.total_wait ) {
+				                  return lhs.total_wait > rhs.total_wait;
+			                  }
+			                  return lhs.contended > rhs.contended;
+		                  } );
+		return result;
+	}
+
+	inline void reset_lock_profile( ) {
+		auto &reg = lock_profiler_impl::registry( );
+		std::lock_guard<std::mutex> lock( reg.mutex );
+		for( auto &site : reg.sites ) {
+			site.second->reset( );
+		}
+	}
+
+	// Writes a table of the top sites by total wait time
+	inline void dump_lock_profile( std::ostream &os, size_t top = 10 ) {
+		using lock_profiler_impl::format_ns;
+		auto const profile = lock_profile( );
+		auto const count = std::min( top, profile.size( ) );
+		os << std::left << std::setw( 24 ) << "lock site" << std::right
+		   << std::setw( 12 ) << "acquired" << std::setw( 11 ) << "contended"
+		   << std::setw( 10 ) << "waited" << std::setw( 10 ) << "wait p99"
+		   << std::setw( 10 ) << "hold avg" << std::setw( 10 ) << "hold p99"
+		   << '\n';
+		for( size_t n = 0; n < count; ++n ) {
+			auto const &s = profile[n];
+			os << std::left << std::setw( 24 ) << s.name << std::right
+			   << std::setw( 12 ) << s.acquisitions << std::setw( 11 )
+			   << s.contended << std::setw( 10 )
+			   << format_ns( static_cast<uint64_t>( s.total_wait.count( ) ) )
+			   << std::setw( 10 )
+			   << format_ns(
+			        static_cast<uint64_t>( s.wait_percentile( 0.99 ).count( ) ) )
+			   << std::setw( 10 )
+			   << format_ns( static_cast<uint64_t>( s.mean_hold( ).count( ) ) )
+			   << std::setw( 10 )
+			   << format_ns(
+			        static_cast<uint64_t>( s.hold_percentile( 0.99 ).count( ) ) )
+			   << '\n';
+		}
+	}
+
+	// Wraps any Lockable, such as std::mutex, spin_lock or copiable_mutex, and
+	// records into the named lock_site.  A try_lock is attempted first so an
+	// uncontended acquisition does not read the clock.  Reading the clock costs
+	// more than an uncontended lock, so holds are timed after every contended
+	// acquisition but only one in HoldSampleRate uncontended ones.  Without
+	// DAW_LOCK_PROFILING defined this only forwards to Lockable and the name is
+	// ignored.  It works with std::lock, std::unique_lock and scoped_multilock.
+	// Copies, where Lockable allows them, record into the same site
+	template<typename Lockable, uint32_t HoldSampleRate = 16>
+	class profiled_lock {
+		static_assert( HoldSampleRate > 0, "Sample at least one hold in N" );
+
+		Lockable m_lock{};
+#if defined( DAW_LOCK_PROFILING )
+		using clock_t = std::chrono::steady_clock;
+
+		lock_site *m_site;
+		// Only touched by the thread holding m_lock
+		clock_t::time_point m_acquired{};
+		uint32_t m_uncontended = 0;
+		bool m_timing_hold = false;
+
+		void acquired_uncontended( ) noexcept {
+			m_site->record_acquire( 0, false );
+			if( ++m_uncontended >= HoldSampleRate ) {
+				m_uncontended = 0;
+				m_timing_hold = true;
+				m_acquired = clock_t::now( );
+			}
+		}
+#endif
+
+	public:
+		using lockable_type = Lockable;
+
+		profiled_lock( )
+		  : profiled_lock( "unnamed" ) {}
+
+#if defined( DAW_LOCK_PROFILING )
+		explicit profiled_lock( std::string_view name )
+		  : m_site( &get_lock_site( name ) ) {}
+#else
+		explicit profiled_lock( std::string_view ) noexcept {}
+#endif
+
+		profiled_lock( profiled_lock const & ) = default;
+		profiled_lock &operator=( profiled_lock const & ) = default;
+
+		void lock( ) {
+#if defined( DAW_LOCK_PROFILING )
+			if( m_lock.try_lock( ) ) {
+				acquired_uncontended( );
+				return;
+			}
+			auto const start = clock_t::now( );
+			m_lock.lock( );
+			m_acquired = clock_t::now( );
+			m_timing_hold = true;
+			m_site->record_acquire(
+			  static_cast<uint64_t>(
+			    std::chrono::duration_cast<std::chrono::nanoseconds>( m_acquired -
+			                                                          start )
+			      .count( ) ),
+			  true );
+#else
+			m_lock.lock( );
+#endif
+		}
+
+		bool try_lock( ) {
+#if defined( DAW_LOCK_PROFILING )
+			if( not m_lock.try_lock( ) ) {
+				m_site->record_failed_try_lock( );
+				return false;
+			}
+			acquired_uncontended( );
+			return true;
+#else
+			return m_lock.try_lock( );
+#endif
+		}
+
+		void unlock( ) {
+#if defined( DAW_LOCK_PROFILING )
+			if( m_timing_hold ) {
+				m_timing_hold = false;
+				m_site->record_release( static_cast<uint64_t>(
+				  std::chrono::duration_cast<std::chrono::nanoseconds>(
+				    clock_t::now( ) - m_acquired )
+				    .count( ) ) );
+			}
+#endif
+			m_lock.unlock( );
+		}
+
+		Lockable &underlying( ) noexcept {
+			return m_lock;
+		}
+
+		Lockable const &underlying( ) const noexcept {
+			return m_lock;
+		}
+	};
+} // namespace daw
@@ -22,12 +22,19 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <optional>
 #include <vector>
 
 #include "../daw_value_ptr.h"
 #include "daw_semaphore.h"
+#include "daw_spin_lock.h"
 
 namespace daw {
 	template<typename T>
@@ -137,4 +144,305 @@ namespace daw {
 		}
 	}; // locked_stack_t
 
+
+	namespace lock_free_stack_impl {
+		// Stack heads and elimination offers pack a 32bit node index, plus one
+		// so that 0 is null, with a 32bit tag.  The tag changes on every update
+		// so a head that was popped and pushed back in between a load and a CAS
+		// no longer compares equal, which is the ABA problem
+		constexpr uint64_t pack( uint32_t tag, uint32_t idx ) noexcept {
+			return ( static_cast<uint64_t>( tag ) << 32U ) | idx;
+		}
+
+		constexpr uint32_t index_of( uint64_t v ) noexcept {
+			return static_cast<uint32_t>( v );
+		}
+
+		constexpr uint32_t tag_of( uint64_t v ) noexcept {
+			return static_cast<uint32_t>( v >> 32U );
+		}
+
+		inline uint32_t random_slot( ) noexcept {
+			thread_local uint32_t state = static_cast<uint32_t>(
+			  reinterpret_cast<uintptr_t>( &state ) >> 4U ) | 1U;
+			state ^= state << 13U;
+			state ^= state >> 17U;
+			state ^= state << 5U;
+			return state;
+		}
+	} // namespace lock_free_stack_impl
+
+	// A lock free LIFO stack.  Nodes come from an internal pool and are
+	// recycled, never freed, while the stack lives.  That keeps a node that
+	// another thread is reading valid, and tagged heads guard against ABA.
+	// When a CAS on the head fails, push and pop meet in an elimination array
+	// and hand values over directly, without touching the head
+	template<typename T, size_t EliminationSlots = 16>
+	class lock_free_stack {
+		static_assert( EliminationSlots > 0 and
+		                 ( EliminationSlots & ( EliminationSlots - 1 ) ) == 0,
+		               "EliminationSlots must be a power of 2" );
+
+		struct node_t {
+			std::atomic<uint32_t> next{0};
+			// Bumped each time the node is reused, tags elimination offers
+			uint32_t generation = 0;
+			alignas( T ) unsigned char data[sizeof( T )];
+
+			T *value( ) noexcept {
+				return std::launder( reinterpret_cast<T *>( data ) );
+			}
+		};
+
+		struct alignas( 64 ) slot_t {
+			std::atomic<uint64_t> offer{0};
+		};
+
+		// Chunk c holds first_chunk << c nodes, so 27 chunks cover every index
+		static constexpr uint32_t const first_chunk_bits = 6;
+		static constexpr size_t const max_chunks = 33 - first_chunk_bits;
+		static constexpr size_t const elimination_spins = 128;
+
+		alignas( 64 ) std::atomic<uint64_t> m_head{0};
+		alignas( 64 ) std::atomic<uint64_t> m_free{0};
+		alignas( 64 ) std::atomic<uint32_t> m_waiters{0};
+		std::atomic<uint32_t> m_wake{0};
+		std::array<slot_t, EliminationSlots> m_slots{};
+		std::atomic<uint32_t> m_node_count{0};
+		std::array<std::atomic<node_t *>, max_chunks> m_chunks{};
+		std::mutex m_grow_mutex{};
+
+		static constexpr size_t chunk_of( uint32_t idx ) noexcept {
+			auto const n = static_cast<uint64_t>( idx ) + ( 1U << first_chunk_bits );
+			size_t bit = 0;
+			while( ( n >> ( bit + 1U ) ) != 0 ) {
+				++bit;
+			}
+			return bit - first_chunk_bits;
+		}
+
+		static constexpr uint32_t chunk_start( size_t chunk ) noexcept {
+			return static_cast<uint32_t>(
+			  ( ( uint64_t{1} << chunk ) - 1U ) << first_chunk_bits );
+		}
+
+		node_t &node( uint32_t idx ) const noexcept {
+			auto const chunk = chunk_of( idx );
+			return m_chunks[chunk].load( std::memory_order_acquire )
+			  [idx - chunk_start( chunk )];
+		}
+
+		// Treiber push of node idx, which this thread owns, onto list
+		bool try_link( std::atomic<uint64_t> &list, uint32_t idx ) noexcept {
+			auto head = list.load( std::memory_order_relaxed );
+			node( idx ).next.store( lock_free_stack_impl::index_of( head ),
+			                        std::memory_order_relaxed );
+			// Sequentially consistent so that a push is ordered against the waiter
+			// count check in push_node and a parking pop_back
+			return list.compare_exchange_strong(
+			  head, lock_free_stack_impl::pack(
+			          lock_free_stack_impl::tag_of( head ) + 1U, idx + 1U ) );
+		}
+
+		// Returns the index plus one of the node taken, 0 when empty and -1 when
+		// the CAS lost a race
+		int64_t try_unlink( std::atomic<uint64_t> &list ) noexcept {
+			auto head = list.load( );
+			auto const top = lock_free_stack_impl::index_of( head );
+			if( top == 0 ) {
+				return 0;
+			}
+			// The node may be popped and reused meanwhile, the tag then fails the
+			// CAS and the stale next is never used
+			auto const next =
+			  node( top - 1U ).next.load( std::memory_order_relaxed );
+			if( list.compare_exchange_strong(
+			      head, lock_free_stack_impl::pack(
+			              lock_free_stack_impl::tag_of( head ) + 1U, next ) ) ) {
+				return top;
+			}
+			return -1;
+		}
+
+		uint32_t allocate_node( ) {
+			while( true ) {
+				auto const r = try_unlink( m_free );
+				if( r > 0 ) {
+					auto const idx = static_cast<uint32_t>( r - 1 );
+					++node( idx ).generation;
+					return idx;
+				}
+				if( r == 0 ) {
+					break;
+				}
+			}
+			auto const idx = m_node_count.fetch_add( 1, std::memory_order_relaxed );
+			auto const chunk = chunk_of( idx );
+			if( m_chunks[chunk].load( std::memory_order_acquire ) == nullptr ) {
+				std::lock_guard<std::mutex> lck( m_grow_mutex );
+				if( m_chunks[chunk].load( std::memory_order_relaxed ) == nullptr ) {
+					auto const count = size_t{1} << ( chunk + first_chunk_bits );
+					m_chunks[chunk].store( new node_t[count],
+					                       std::memory_order_release );
+				}
+			}
+			return idx;
+		}
+
+		void free_node( uint32_t idx ) noexcept {
+			while( not try_link( m_free, idx ) ) {}
+		}
+
+		void push_node( uint32_t idx ) noexcept {
+			auto backoff = 0U;
+			while( not try_link( m_head, idx ) ) {
+				if( eliminate_push( idx ) ) {
+					return;
+				}
+				for( auto n = 0U; n < backoff; ++n ) {
+					spin_lock_impl::cpu_relax( );
+				}
+				backoff = backoff == 0 ? 1 : ( backoff < 64 ? backoff * 2 : 64 );
+			}
+			if( m_waiters.load( ) > 0 ) {
+				m_wake.fetch_add( 1 );
+				spin_lock_impl::unpark_one( m_wake );
+			}
+		}
+
+		// Offer idx to a popper, true when one took it
+		bool eliminate_push( uint32_t idx ) noexcept {
+			auto &slot = m_slots[lock_free_stack_impl::random_slot( ) %
+			                     EliminationSlots]
+			               .offer;
+			auto const offer =
+			  lock_free_stack_impl::pack( node( idx ).generation, idx + 1U );
+			uint64_t expected = 0;
+			if( not slot.compare_exchange_strong( expected, offer ) ) {
+				return false;
+			}
+			for( size_t n = 0; n < elimination_spins; ++n ) {
+				if( slot.load( std::memory_order_acquire ) != offer ) {
+					return true;
+				}
+				spin_lock_impl::cpu_relax( );
+			}
+			expected = offer;
+			// Failing to withdraw means a popper took it at the last moment
+			return not slot.compare_exchange_strong( expected, 0 );
+		}
+
+		// Take a pending push offer, 0 when there was none.  Pushers wait in
+		// the array, so a popper only looks once before retrying the head
+		uint32_t eliminate_pop( ) noexcept {
+			auto &slot = m_slots[lock_free_stack_impl::random_slot( ) %
+			                     EliminationSlots]
+			               .offer;
+			auto offer = slot.load( std::memory_order_acquire );
+			if( offer != 0 and slot.compare_exchange_strong(
+			                     offer, 0, std::memory_order_acquire ) ) {
+				return lock_free_stack_impl::index_of( offer );
+			}
+			return 0;
+		}
+
+		// Index plus one of the node popped, 0 when empty
+		uint32_t pop_node( ) noexcept {
+			while( true ) {
+				auto const r = try_unlink( m_head );
+				if( r >= 0 ) {
+					return static_cast<uint32_t>( r );
+				}
+				if( auto const idx = eliminate_pop( ); idx != 0 ) {
+					return idx;
+				}
+			}
+		}
+
+		T take( uint32_t idx ) {
+			node_t &n = node( idx );
+			struct recycle_t {
+				lock_free_stack *self;
+				node_t &n;
+				uint32_t idx;
+
+				~recycle_t( ) {
+					n.value( )->~T( );
+					self->free_node( idx );
+				}
+			} const recycle{this, n, idx};
+			return std::move( *n.value( ) );
+		}
+
+	public:
+		using value_type = T;
+
+		lock_free_stack( ) = default;
+		lock_free_stack( lock_free_stack const & ) = delete;
+		lock_free_stack &operator=( lock_free_stack const & ) = delete;
+
+		~lock_free_stack( ) {
+			auto top = lock_free_stack_impl::index_of( m_head.load( ) );
+			while( top != 0 ) {
+				node_t &n = node( top - 1U );
+				n.value( )->~T( );
+				top = n.next.load( std::memory_order_relaxed );
+			}
+			for( auto &chunk : m_chunks ) {
+				delete[] chunk.load( );
+			}
+		}
+
+		template<typename... Args>
+		void emplace_back( Args &&... args ) {
+			auto const idx = allocate_node( );
+			try {
+				new( node( idx ).data ) T( std::forward<Args>( args )... );
+			} catch( ... ) {
+				free_node( idx );
+				throw;
+			}
+			push_node( idx );
+		}
+
+		template<typename U>
+		void push_back( U &&value ) {
+			emplace_back( std::forward<U>( value ) );
+		}
+
+		std::optional<value_type> try_pop_back( ) {
+			auto const idx = pop_node( );
+			if( idx == 0 ) {
+				return std::nullopt;
+			}
+			return take( idx - 1U );
+		}
+
+		// Waits until there is a value to pop
+		value_type pop_back( ) {
+			while( true ) {
+				for( size_t n = 0; n < 64; ++n ) {
+					if( auto const idx = pop_node( ); idx != 0 ) {
+						return take( idx - 1U );
+					}
+					spin_lock_impl::cpu_relax( );
+				}
+				m_waiters.fetch_add( 1 );
+				auto const wake = m_wake.load( );
+				auto const idx = pop_node( );
+				if( idx == 0 ) {
+					spin_lock_impl::park( m_wake, wake );
+				}
+				m_waiters.fetch_sub( 1 );
+				if( idx != 0 ) {
+					return take( idx - 1U );
+				}
+			}
+		}
+
+		// A snapshot, other threads may change it immediately
+		bool empty( ) const noexcept {
+			return lock_free_stack_impl::index_of( m_head.load( ) ) == 0;
+		}
+	}; // lock_free_stack
 } // namespace daw
@@ -22,12 +22,19 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <future>
 #include <mutex>
+#include <type_traits>
 #include <utility>
 
 #include "../cpp_17.h"
+#include "../daw_exception.h"
 #include "../daw_value_ptr.h"
+#include "daw_spin_lock.h"
 
 namespace daw {
 	template<typename T>
@@ -119,4 +126,321 @@ namespace daw {
 			return get( );
 		}
 	}; // lockable_value_t
+
+	// A value that readers copy out without writing shared memory.  Writers
+	// make the sequence number odd while they update; a reader retries when
+	// it saw an odd number or the number changed during its copy.  The value
+	// is held in atomic words so the racing copy is well defined.  Reads are
+	// cheap but not wait free, a steady stream of writes can starve them
+	template<typename T>
+	class seqlock_cell {
+		static_assert( std::is_trivially_copyable_v<T>,
+		               "seqlock_cell values are copied while being written" );
+
+		using word_t = uintptr_t;
+		static constexpr size_t const word_count =
+		  ( sizeof( T ) + sizeof( word_t ) - 1 ) / sizeof( word_t );
+
+		std::atomic<uint64_t> m_sequence{0};
+		std::array<std::atomic<word_t>, word_count> m_words{};
+
+		void write_words( T const &value ) noexcept {
+			std::array<word_t, word_count> buff{};
+			std::memcpy( buff.data( ), &value, sizeof( T ) );
+			for( size_t n = 0; n < word_count; ++n ) {
+				m_words[n].store( buff[n], std::memory_order_relaxed );
+			}
+		}
+
+		T read_words( ) const noexcept {
+			std::array<word_t, word_count> buff{};
+			for( size_t n = 0; n < word_count; ++n ) {
+				buff[n] = m_words[n].load( std::memory_order_relaxed );
+			}
+			T result;
+			std::memcpy( &result, buff.data( ), sizeof( T ) );
+			return result;
+		}
+
+		// Writers exclude each other by moving the sequence from even to odd
+		uint64_t begin_write( ) noexcept {
+			auto seq = m_sequence.load( std::memory_order_relaxed );
+			while( ( seq & 1U ) != 0 or
+			       not m_sequence.compare_exchange_weak(
+			         seq, seq + 1U, std::memory_order_acquire,
+			         std::memory_order_relaxed ) ) {
+				spin_lock_impl::cpu_relax( );
+				seq = m_sequence.load( std::memory_order_relaxed );
+			}
+			std::atomic_thread_fence( std::memory_order_release );
+			return seq;
+		}
+
+		void end_write( uint64_t seq ) noexcept {
+			m_sequence.store( seq + 2U, std::memory_order_release );
+		}
+
+	public:
+		using value_type = T;
+
+		seqlock_cell( ) noexcept( std::is_nothrow_default_constructible_v<T> )
+		  : seqlock_cell( T{} ) {}
+
+		explicit seqlock_cell( T const &value ) noexcept {
+			write_words( value );
+		}
+
+		seqlock_cell( seqlock_cell const & ) = delete;
+		seqlock_cell &operator=( seqlock_cell const & ) = delete;
+
+		T load( ) const noexcept {
+			while( true ) {
+				auto const before = m_sequence.load( std::memory_order_acquire );
+				if( ( before & 1U ) == 0 ) {
+					T result = read_words( );
+					std::atomic_thread_fence( std::memory_order_acquire );
+					if( m_sequence.load( std::memory_order_relaxed ) == before ) {
+						return result;
+					}
+				}
+				spin_lock_impl::cpu_relax( );
+			}
+		}
+
+		void store( T const &value ) noexcept {
+			auto const seq = begin_write( );
+			write_words( value );
+			end_write( seq );
+		}
+
+		// Replace the value with f( old_value ), other writers wait meanwhile
+		template<typename Function>
+		void update( Function &&f ) {
+			auto const seq = begin_write( );
+			T value = read_words( );
+			try {
+				std::forward<Function>( f )( value );
+			} catch( ... ) {
+				end_write( seq );
+				throw;
+			}
+			write_words( value );
+			end_write( seq );
+		}
+	}; // seqlock_cell
+
+	// Holds an immutable version of a value that is replaced as a whole.
+	// Readers take a snapshot, keeping their version alive, with one atomic
+	// add and never wait on writers.  A replaced version is destructed when
+	// its last snapshot goes away.
+	//
+	// The current version's address and the count of snapshots taken from
+	// the cell share one 64bit word, the address in the low 48 bits.  When a
+	// version is replaced, its outstanding count moves to the version itself.
+	// Once half of the 16 bits of count are used, a reader republishes a copy
+	// of the current version so the count starts over.  When T cannot be
+	// copied, or the count overflows anyway, load terminates instead of
+	// losing count.  A snapshot must not outlive its cell
+	template<typename T>
+	class snapshot_cell {
+		static_assert( sizeof( void * ) == sizeof( uint64_t ),
+		               "snapshot_cell packs pointers into 48 bits" );
+
+		struct version_t {
+			T const value;
+			// Snapshots released after the version was replaced, minus those
+			// handed over when it was
+			std::atomic<int64_t> detached{0};
+
+			template<typename... Args>
+			explicit version_t( Args &&... args )
+			  : value( std::forward<Args>( args )... ) {}
+		};
+
+		static constexpr uint64_t const count_one = uint64_t{1} << 48U;
+		static constexpr uint64_t const address_mask = count_one - 1U;
+		static constexpr uint64_t const max_count = 0xFFFFU;
+		static constexpr uint64_t const republish_count = 0x8000U;
+
+		mutable std::atomic<uint64_t> m_current;
+		std::mutex m_update_mutex{};
+
+		static version_t *version_of( uint64_t word ) noexcept {
+			return reinterpret_cast<version_t *>( word & address_mask );
+		}
+
+		static uint64_t pack( version_t *ver ) {
+			auto const address = reinterpret_cast<uintptr_t>( ver );
+			daw::exception::precondition_check( ( address & ~address_mask ) == 0,
+			                                    "Address does not fit in 48 bits" );
+			return static_cast<uint64_t>( address );
+		}
+
+		version_t *acquire( ) const noexcept {
+			auto const word =
+			  m_current.fetch_add( count_one, std::memory_order_acquire );
+			auto const count = word >> 48U;
+			// At max_count the add has carried out of the word and the count of
+			// snapshots is lost, any further use could free a version in use
+			daw::exception::precondition_check(
+			  count < max_count, "Too many snapshots of the current version" );
+			if constexpr( std::is_copy_constructible_v<T> ) {
+				if( count >= republish_count ) {
+					try {
+						republish( version_of( word ) );
+					} catch( ... ) {
+						// A later reader tries again, well before max_count
+					}
+				}
+			}
+			return version_of( word );
+		}
+
+		void release( version_t *ver ) const noexcept {
+			auto word = m_current.load( std::memory_order_relaxed );
+			// While ver is current, hand the count back to the shared word.  ver
+			// cannot be reused meanwhile as this snapshot keeps it alive
+			while( version_of( word ) == ver ) {
+				if( m_current.compare_exchange_weak( word, word - count_one,
+				                                     std::memory_order_release,
+				                                     std::memory_order_relaxed ) ) {
+					return;
+				}
+			}
+			if( ver->detached.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+				delete ver;
+			}
+		}
+
+		// Hand the outstanding count of a replaced version over to it
+		static void retire( uint64_t old_word ) noexcept {
+			version_t *old = version_of( old_word );
+			if( old == nullptr ) {
+				return;
+			}
+			auto const outstanding = static_cast<int64_t>( old_word >> 48U );
+			if( old->detached.fetch_add( outstanding, std::memory_order_acq_rel ) ==
+			    -outstanding ) {
+				delete old;
+			}
+		}
+
+		void publish( version_t *ver ) {
+			retire( m_current.exchange( pack( ver ), std::memory_order_acq_rel ) );
+		}
+
+		// Replace ver, which the caller holds a snapshot of, with a copy of
+		// itself unless another version was published meanwhile
+		void republish( version_t *ver ) const {
+			auto word = m_current.load( std::memory_order_relaxed );
+			if( version_of( word ) != ver ) {
+				return;
+			}
+			auto copy = new version_t( ver->value );
+			auto const copy_word = pack( copy );
+			while( version_of( word ) == ver ) {
+				if( m_current.compare_exchange_weak( word, copy_word,
+				                                     std::memory_order_acq_rel,
+				                                     std::memory_order_relaxed ) ) {
+					retire( word );
+					return;
+				}
+			}
+			delete copy;
+		}
+
+	public:
+		using value_type = T;
+
+		class snapshot {
+			snapshot_cell const *m_cell = nullptr;
+			version_t *m_version = nullptr;
+
+			friend class snapshot_cell;
+
+			snapshot( snapshot_cell const *cell, version_t *ver ) noexcept
+			  : m_cell( cell )
+			  , m_version( ver ) {}
+
+		public:
+			snapshot( ) = default;
+
+			snapshot( snapshot &&other ) noexcept
+			  : m_cell( std::exchange( other.m_cell, nullptr ) )
+			  , m_version( std::exchange( other.m_version, nullptr ) ) {}
+
+			snapshot &operator=( snapshot &&rhs ) noexcept {
+				if( this != &rhs ) {
+					reset( );
+					m_cell = std::exchange( rhs.m_cell, nullptr );
+					m_version = std::exchange( rhs.m_version, nullptr );
+				}
+				return *this;
+			}
+
+			snapshot( snapshot const & ) = delete;
+			snapshot &operator=( snapshot const & ) = delete;
+
+			~snapshot( ) {
+				reset( );
+			}
+
+			void reset( ) noexcept {
+				auto ver = std::exchange( m_version, nullptr );
+				if( ver != nullptr ) {
+					m_cell->release( ver );
+				}
+				m_cell = nullptr;
+			}
+
+			T const *get( ) const noexcept {
+				return m_version == nullptr ? nullptr : &m_version->value;
+			}
+
+			T const &operator*( ) const noexcept {
+				return m_version->value;
+			}
+
+			T const *operator->( ) const noexcept {
+				return &m_version->value;
+			}
+
+			explicit operator bool( ) const noexcept {
+				return m_version != nullptr;
+			}
+		}; // snapshot
+
+		template<typename... Args>
+		explicit snapshot_cell( Args &&... args )
+		  : m_current( pack( new version_t( std::forward<Args>( args )... ) ) ) {}
+
+		snapshot_cell( snapshot_cell const & ) = delete;
+		snapshot_cell &operator=( snapshot_cell const & ) = delete;
+
+		~snapshot_cell( ) {
+			publish( nullptr );
+		}
+
+		snapshot load( ) const noexcept {
+			return snapshot( this, acquire( ) );
+		}
+
+		// Publish a new version, readers still holding the old one keep it.
+		// Stores wait for a running update so it cannot overwrite them
+		template<typename... Args>
+		void store( Args &&... args ) {
+			auto ver = new version_t( std::forward<Args>( args )... );
+			std::lock_guard<std::mutex> lck( m_update_mutex );
+			publish( ver );
+		}
+
+		// Publish f( current ) as the new version.  Updates and stores are
+		// serialized so none is lost, reads are never blocked
+		template<typename Function>
+		void update( Function &&f ) {
+			std::lock_guard<std::mutex> lck( m_update_mutex );
+			auto current = load( );
+			publish( new version_t( std::forward<Function>( f )( *current ) ) );
+		}
+	}; // snapshot_cell
 } // namespace daw
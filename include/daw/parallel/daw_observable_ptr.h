@@ -24,42 +24,73 @@
 
 #include <atomic>
 #include <cstdint>
-#include <functional>
 #include <memory>
-#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 #include "../daw_expected.h"
 #include "../daw_traits.h"
+#include "daw_spin_lock.h"
 
 namespace daw {
 	template<typename T>
 	class observable_ptr;
 
 	namespace impl {
+		template<typename T>
+		class control_block_t;
+
+		// A borrow of the guarded value.  The value is not destructed while a
+		// borrow is alive.  A borrow must not outlive the owner/observer it came
+		// from.  locked_ptr<T const> is a shared borrow that other readers may
+		// hold at the same time, locked_ptr<T> is exclusive
 		template<typename T>
 		class locked_ptr {
+			using control_block_type = control_block_t<std::remove_const_t<T>>;
+
 			T *m_ptr;
-			std::function<void( )> m_on_exit;
+			control_block_type const *m_control_block;
+
+			void release( ) noexcept {
+				auto tmp = std::exchange( m_control_block, nullptr );
+				m_ptr = nullptr;
+				if( tmp ) {
+					if constexpr( std::is_const_v<T> ) {
+						tmp->release_shared( );
+					} else {
+						tmp->release_exclusive( );
+					}
+				}
+			}
 
 		public:
 			locked_ptr( locked_ptr const & ) = delete;
 			locked_ptr &operator=( locked_ptr const & ) = delete;
 
-			locked_ptr( locked_ptr && ) noexcept = default;
-			locked_ptr &operator=( locked_ptr && ) noexcept = default;
+			constexpr locked_ptr( ) noexcept
+			  : m_ptr( nullptr )
+			  , m_control_block( nullptr ) {}
 
-			template<typename OnExit>
-			constexpr locked_ptr( T *ptr, OnExit &&on_exit ) noexcept
+			constexpr locked_ptr( T *ptr, control_block_type const *cb ) noexcept
 			  : m_ptr( ptr )
-			  , m_on_exit( std::forward<OnExit>( on_exit ) ) {}
+			  , m_control_block( cb ) {}
+
+			locked_ptr( locked_ptr &&other ) noexcept
+			  : m_ptr( std::exchange( other.m_ptr, nullptr ) )
+			  , m_control_block( std::exchange( other.m_control_block, nullptr ) ) {}
+
+			locked_ptr &operator=( locked_ptr &&rhs ) noexcept {
+				if( this != &rhs ) {
+					release( );
+					m_ptr = std::exchange( rhs.m_ptr, nullptr );
+					m_control_block = std::exchange( rhs.m_control_block, nullptr );
+				}
+				return *this;
+			}
 
 			~locked_ptr( ) noexcept {
-				m_ptr = nullptr;
-				try {
-					if( m_on_exit ) {
-						m_on_exit( );
-					}
-				} catch( ... ) {}
+				release( );
 			}
 
 			constexpr T *operator->( ) const noexcept {
@@ -83,48 +114,89 @@ namespace daw {
 			}
 		};
 
+		// Borrows are counted in m_borrow_state without a mutex.  Any number of
+		// shared borrows can read the value at once, while an exclusive borrow
+		// waits for them to leave and keeps everyone else out.  The high bit
+		// records that the owner is gone; once it is set no new borrow succeeds
+		// and whoever drops the last borrow destructs the value.  The control
+		// block itself lives until the owner and every observer have released it
 		template<typename T>
 		class control_block_t {
-			using observer_count_t = int16_t;
+			using state_t = uint32_t;
+			static constexpr state_t const owner_gone = state_t{1} << 31U;
+			static constexpr state_t const writer = state_t{1} << 30U;
 
 			// Pointer we are guarding
 			T *m_ptr;
 
-			// The owner has gone out of scope, as soon as there are no borrows, run
-			// values destructor
-			std::atomic_bool m_ptr_destruct;
+			// owner_gone | writer | number of shared borrows alive
+			mutable std::atomic<state_t> m_borrow_state;
 
-			// This controls access to deleting the control block
-			std::once_flag m_cb_destruct;
+			// Owner plus observers alive, the last one deletes the control block
+			std::atomic<size_t> m_ref_count;
 
-			// Pointer has been borrowed
-			mutable std::mutex m_is_borrowed;
+			constexpr control_block_t( T *ptr )
+			  : m_ptr( ptr )
+			  , m_borrow_state( 0 )
+			  , m_ref_count( 1 ) {}
 
-			// Number of observers alive, cannot delete control block unless this is 0
-			std::atomic<observer_count_t> m_observer_count;
+			friend class observable_ptr<T>;
+			friend class locked_ptr<T>;
+			friend class locked_ptr<T const>;
 
-			void destruct_if_should( std::lock_guard<std::mutex> const & ) {
-				if( m_ptr_destruct.load( ) ) {
-					auto tmp = std::exchange( m_ptr, nullptr );
-					if( tmp ) {
-						delete tmp;
-					}
+			void destruct_value( ) const noexcept {
+				delete m_ptr;
+			}
+
+			void release_shared( ) const noexcept {
+				if( m_borrow_state.fetch_sub( 1, std::memory_order_acq_rel ) ==
+				    ( owner_gone | 1U ) ) {
+					destruct_value( );
 				}
 			}
 
-			void destruct_if_should( ) {
-				std::lock_guard<std::mutex> lck( m_is_borrowed );
-				destruct_if_should( lck );
+			void release_exclusive( ) const noexcept {
+				if( m_borrow_state.fetch_sub( writer, std::memory_order_acq_rel ) ==
+				    ( owner_gone | writer ) ) {
+					destruct_value( );
+				}
 			}
 
-			constexpr control_block_t( T *ptr )
-			  : m_ptr( ptr )
-			  , m_ptr_destruct( false )
-			  , m_cb_destruct( )
-			  , m_is_borrowed( )
-			  , m_observer_count( 0 ) {}
+			// Blocked is the set of bits that make the borrow wait, or fail when
+			// Wait is false
+			template<bool Wait>
+			bool acquire( state_t blocked, state_t add ) const noexcept {
+				auto state = m_borrow_state.load( std::memory_order_relaxed );
+				uint32_t spins = 0;
+				while( true ) {
+					if( state & owner_gone ) {
+						return false;
+					}
+					if( ( state & blocked ) == 0 ) {
+						if( m_borrow_state.compare_exchange_weak(
+						      state, state + add, std::memory_order_acquire,
+						      std::memory_order_relaxed ) ) {
+							return true;
+						}
+						continue;
+					}
+					if constexpr( not Wait ) {
+						return false;
+					}
+					if( ++spins < 64U ) {
+						spin_lock_impl::cpu_relax( );
+					} else {
+						std::this_thread::yield( );
+					}
+					state = m_borrow_state.load( std::memory_order_relaxed );
+				}
+			}
 
-			friend class observable_ptr<T>;
+			static void release_ref( control_block_t *cb ) noexcept {
+				if( cb->m_ref_count.fetch_sub( 1, std::memory_order_acq_rel ) == 1U ) {
+					delete cb;
+				}
+			}
 
 		public:
 			control_block_t( ) = delete;
@@ -133,91 +205,72 @@ namespace daw {
 			control_block_t &operator=( control_block_t const & ) = delete;
 			control_block_t &operator=( control_block_t && ) noexcept = delete;
 
-			// Should never get to this point without point without owner/observer
-			// cleaning up ptr
-			//~control_block_t( ) noexcept = default;
-
 			bool expired( ) const noexcept {
-				return m_ptr_destruct;
+				return ( m_borrow_state.load( std::memory_order_acquire ) &
+				         owner_gone ) != 0;
 			}
 
-			locked_ptr<T> try_borrow( ) const {
-				if( !m_is_borrowed.try_lock( ) ) {
-					return locked_ptr<T>( nullptr, []( ) {} );
+			// Read only access alongside other shared borrows.  Waits while an
+			// exclusive borrow is held, empty once expired
+			locked_ptr<T const> borrow_shared( ) const noexcept {
+				if( not acquire<true>( writer, 1U ) ) {
+					return locked_ptr<T const>( );
 				}
-				return locked_ptr<T>{m_ptr, [&]( ) { m_is_borrowed.unlock( ); }};
-			}
-
-			locked_ptr<T> borrow( ) const {
-				m_is_borrowed.lock( );
-				return locked_ptr<T>( m_ptr, [&]( ) { m_is_borrowed.unlock( ); } );
+				return locked_ptr<T const>( m_ptr, this );
 			}
 
-			locked_ptr<T> borrow( ) {
-				m_is_borrowed.lock( );
-				return locked_ptr<T>( m_ptr, [&]( ) { m_is_borrowed.unlock( ); } );
-			}
-
-			constexpr T *get( ) const noexcept {
-				return m_ptr;
-			}
-
-			bool add_observer( ) {
-				if( m_ptr_destruct.load( ) ) {
-					return false;
+			// Empty if expired or an exclusive borrow is held
+			locked_ptr<T const> try_borrow_shared( ) const noexcept {
+				if( not acquire<false>( writer, 1U ) ) {
+					return locked_ptr<T const>( );
 				}
-				++m_observer_count;
-				return true;
+				return locked_ptr<T const>( m_ptr, this );
 			}
 
-		private:
-			bool remove_observer( std::lock_guard<std::mutex> &lck ) {
-				--m_observer_count;
-				destruct_if_should( lck );
-				return m_observer_count <= 0;
+			// Mutable access that excludes every other borrow.  Waits for the
+			// current borrows to be released, empty once expired
+			locked_ptr<T> borrow( ) const noexcept {
+				if( not acquire<true>( ~owner_gone, writer ) ) {
+					return locked_ptr<T>( );
+				}
+				return locked_ptr<T>( m_ptr, this );
 			}
 
-			bool remove_observer( std::lock_guard<std::mutex> &&lck ) {
-				return remove_observer( lck );
+			// Empty if expired or any other borrow is held
+			locked_ptr<T> try_borrow( ) const noexcept {
+				if( not acquire<false>( ~owner_gone, writer ) ) {
+					return locked_ptr<T>( );
+				}
+				return locked_ptr<T>( m_ptr, this );
 			}
 
-			bool remove_owner( std::lock_guard<std::mutex> &lck ) {
-				m_ptr_destruct = true;
-				destruct_if_should( lck );
-				return m_observer_count <= 0;
+			// Unguarded access, null once the owner is gone
+			T *get( ) const noexcept {
+				if( expired( ) ) {
+					return nullptr;
+				}
+				return m_ptr;
 			}
 
-			bool remove_owner( std::lock_guard<std::mutex> &&lck ) {
-				return remove_owner( lck );
+			void add_observer( ) noexcept {
+				m_ref_count.fetch_add( 1, std::memory_order_relaxed );
 			}
 
-			static void destruct_cb( control_block_t *cb ) {
-				if( !cb ) {
-					return;
-				}
-				bool do_destruct = false;
-				std::call_once( cb->m_cb_destruct,
-				                [&do_destruct]( ) { do_destruct = true; } );
-				if( do_destruct ) {
-					delete cb;
+			static void remove_observer( control_block_t *cb ) noexcept {
+				if( cb ) {
+					release_ref( cb );
 				}
 			}
 
-		public:
-			static void remove_observer( control_block_t *cb ) {
-				if( cb and cb->remove_observer(
-				             std::lock_guard<std::mutex>( cb->m_is_borrowed ) ) ) {
-
-					destruct_cb( cb );
+			static void remove_owner( control_block_t *cb ) noexcept {
+				if( not cb ) {
+					return;
 				}
-			}
-
-			static void remove_owner( control_block_t *cb ) {
-				if( cb and cb->remove_owner(
-				             std::lock_guard<std::mutex>( cb->m_is_borrowed ) ) ) {
-
-					destruct_cb( cb );
+				if( cb->m_borrow_state.fetch_or( owner_gone,
+				                                 std::memory_order_acq_rel ) == 0 ) {
+					cb->destruct_value( );
 				}
+				release_ref( cb );
 			}
 		};
 	} // namespace impl
@@ -234,34 +287,35 @@ namespace daw {
 		  : m_control_block( nullptr ) {}
 
 		/// @brief An observer of an observable_ptr
-		/// @param cb Control block for observable pointer.  Must never be null,
-		/// will abort if so
-		observer_ptr( impl::control_block_t<T> *cb )
-		  : m_control_block( cb ) {}
+		/// @param cb Control block for observable pointer, the observer holds a
+		/// reference to it
+		observer_ptr( impl::control_block_t<T> *cb ) noexcept
+		  : m_control_block( cb ) {
 
-		void reset( ) {
-			auto tmp = std::exchange( m_control_block, nullptr );
-			if( tmp ) {
-				try {
-					impl::control_block_t<T>::remove_observer( tmp );
-				} catch( ... ) {}
+			if( m_control_block ) {
+				m_control_block->add_observer( );
 			}
 		}
 
+		void reset( ) noexcept {
+			impl::control_block_t<T>::remove_observer(
+			  std::exchange( m_control_block, nullptr ) );
+		}
+
 		~observer_ptr( ) {
 			reset( );
 		}
 
-		constexpr observer_ptr( observer_ptr const &other )
-		  : m_control_block( other.m_control_block ) {
+		observer_ptr( observer_ptr const &other ) noexcept
+		  : observer_ptr( other.m_control_block ) {}
 
-			m_control_block->add_observer( );
-		}
-
-		observer_ptr &operator=( observer_ptr const &rhs ) {
+		observer_ptr &operator=( observer_ptr const &rhs ) noexcept {
 			if( this != &rhs ) {
+				reset( );
 				m_control_block = rhs.m_control_block;
-				m_control_block->add_observer( );
+				if( m_control_block ) {
+					m_control_block->add_observer( );
+				}
 			}
 			return *this;
 		}
@@ -269,14 +323,15 @@ namespace daw {
 		constexpr observer_ptr( observer_ptr &&other ) noexcept
 		  : m_control_block( std::exchange( other.m_control_block, nullptr ) ) {}
 
-		constexpr observer_ptr &operator=( observer_ptr &&rhs ) noexcept {
+		observer_ptr &operator=( observer_ptr &&rhs ) noexcept {
 			if( this != &rhs ) {
+				reset( );
 				m_control_block = std::exchange( rhs.m_control_block, nullptr );
 			}
 			return *this;
 		}
 
-		constexpr T *get( ) const noexcept {
+		T *get( ) const noexcept {
 			if( !m_control_block ) {
 				return nullptr;
 			}
@@ -285,25 +340,41 @@ namespace daw {
 
 		impl::locked_ptr<T> try_borrow( ) const {
 			if( !m_control_block ) {
-				return impl::locked_ptr<T>( nullptr, []( ) {} );
+				return impl::locked_ptr<T>( );
 			}
 			return m_control_block->try_borrow( );
 		}
 
 		impl::locked_ptr<T> borrow( ) const {
 			if( !m_control_block ) {
-				return impl::locked_ptr<T>( nullptr, []( ) {} );
+				return impl::locked_ptr<T>( );
 			}
 			return m_control_block->borrow( );
 		}
 
+		impl::locked_ptr<T const> try_borrow_shared( ) const {
+			if( !m_control_block ) {
+				return impl::locked_ptr<T const>( );
+			}
+			return m_control_block->try_borrow_shared( );
+		}
+
+		impl::locked_ptr<T const> borrow_shared( ) const {
+			if( !m_control_block ) {
+				return impl::locked_ptr<T const>( );
+			}
+			return m_control_block->borrow_shared( );
+		}
+
+		// Calls c with a shared, read only borrow.  Other readers may run at the
+		// same time
 		template<typename Callable,
 		         std::enable_if_t<traits::is_callable_v<Callable, T const &>,
 		                          std::nullptr_t> = nullptr>
 		decltype( auto ) lock( Callable &&c ) const
 		  noexcept( noexcept( c( std::declval<T const &>( ) ) ) ) {
 
-			auto lck_ptr = borrow( );
+			auto lck_ptr = borrow_shared( );
 			using result_t = std::decay_t<decltype( c( *lck_ptr ) )>;
 
 			if( !lck_ptr ) {
@@ -313,6 +384,7 @@ namespace daw {
 			                                             *lck_ptr );
 		}
 
+		// Calls c with an exclusive borrow, no other borrow runs at the same time
 		template<typename Callable,
 		         std::enable_if_t<traits::is_callable_v<Callable, T &>,
 		                          std::nullptr_t> = nullptr>
@@ -334,7 +406,7 @@ namespace daw {
 		}
 
 		T const &operator*( ) const {
-			T const &r = *borrow( );
+			T const &r = *borrow_shared( );
 			return r;
 		}
 
@@ -368,18 +440,16 @@ namespace daw {
 
 		observable_ptr &operator=( observable_ptr &&rhs ) noexcept {
 			if( this != &rhs ) {
-				m_control_block = std::exchange( rhs.m_control_block, nullptr );
+				impl::control_block_t<T>::remove_owner(
+				  std::exchange( m_control_block, rhs.m_control_block ) );
+				rhs.m_control_block = nullptr;
 			}
 			return *this;
 		}
 
 		~observable_ptr( ) noexcept {
-			auto tmp = std::exchange( m_control_block, nullptr );
-			try {
-				if( tmp ) {
-					impl::control_block_t<T>::remove_owner( tmp );
-				}
-			} catch( ... ) {}
+			impl::control_block_t<T>::remove_owner(
+			  std::exchange( m_control_block, nullptr ) );
 		}
 
 		/// @brief Take ownership of pointer and construct shared_ptr with it
@@ -397,7 +467,7 @@ namespace daw {
 			return observer_ptr<T>( m_control_block );
 		}
 
-		constexpr T *get( ) const noexcept {
+		T *get( ) const noexcept {
 			if( !m_control_block ) {
 				return nullptr;
 			}
@@ -410,23 +480,38 @@ namespace daw {
 
 		impl::locked_ptr<T> try_borrow( ) const {
 			if( !m_control_block ) {
-				return impl::locked_ptr<T>( nullptr, []( ) {} );
+				return impl::locked_ptr<T>( );
 			}
 			return m_control_block->try_borrow( );
 		}
 
 		impl::locked_ptr<T> borrow( ) const {
 			if( !m_control_block ) {
-				return impl::locked_ptr<T>( nullptr, []( ) {} );
+				return impl::locked_ptr<T>( );
 			}
 			return m_control_block->borrow( );
 		}
 
+		impl::locked_ptr<T const> try_borrow_shared( ) const {
+			if( !m_control_block ) {
+				return impl::locked_ptr<T const>( );
+			}
+			return m_control_block->try_borrow_shared( );
+		}
+
+		impl::locked_ptr<T const> borrow_shared( ) const {
+			if( !m_control_block ) {
+				return impl::locked_ptr<T const>( );
+			}
+			return m_control_block->borrow_shared( );
+		}
+
+		// Calls c with a shared, read only borrow
 		template<typename Callable>
 		decltype( auto ) lock( Callable &&c ) const {
 			using result_t =
 			  std::decay_t<decltype( c( std::declval<T const &>( ) ) )>;
-			auto lck_ptr = borrow( );
+			auto lck_ptr = borrow_shared( );
 			if( !lck_ptr ) {
 				return daw::expected_t<result_t>{};
 			}
@@ -435,6 +520,7 @@ namespace daw {
 			                                             r );
 		}
 
+		// Calls c with an exclusive borrow
 		template<typename Callable>
 		decltype( auto ) lock( Callable &&c ) {
 			using result_t = std::decay_t<decltype(
@@ -448,14 +534,13 @@ namespace daw {
 			                                             r );
 		}
 
-		T const &operator*( ) const {
-			T const &r = *borrow( );
-			return r;
+		// The owner keeps the value alive, so no borrow is needed
+		T const &operator*( ) const noexcept {
+			return *m_control_block->m_ptr;
 		}
 
-		T &operator*( ) {
-			T &r = *borrow( );
-			return r;
+		T &operator*( ) noexcept {
+			return *m_control_block->m_ptr;
 		}
 
 		explicit operator bool( ) const {
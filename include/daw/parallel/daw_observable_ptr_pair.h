@@ -95,7 +95,7 @@ namespace daw {
 		template<typename Visitor>
 		decltype( auto ) visit( Visitor vis ) const {
 			return m_ptrs.visit( [&]( auto const &p ) -> decltype( auto ) {
-				return vis( *p.borrow( ) );
+				return vis( *p.borrow_shared( ) );
 			} );
 		}
 
@@ -135,6 +135,16 @@ namespace daw {
 			  []( auto const &obs_ptr ) { return obs_ptr.try_borrow( ); } );
 		}
 
+		decltype( auto ) borrow_shared( ) const {
+			return apply_visitor(
+			  []( auto const &obs_ptr ) { return obs_ptr.borrow_shared( ); } );
+		}
+
+		decltype( auto ) try_borrow_shared( ) const {
+			return apply_visitor(
+			  []( auto const &obs_ptr ) { return obs_ptr.try_borrow_shared( ); } );
+		}
+
 		decltype( auto ) get( ) const {
 			return apply_visitor(
 			  []( auto const &obs_ptr ) { return obs_ptr.get( ); } );
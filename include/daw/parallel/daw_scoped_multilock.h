@@ -57,7 +57,9 @@ namespace daw {
 		  m_locks;
 
 		template<typename Arg>
-		void _lock( Arg const & ) {}
+		void _lock( Arg &arg ) {
+			arg.lock( );
+		}
 
 		template<typename Arg1, typename Arg2, typename... Args>
 		void _lock( Arg1 &arg1, Arg2 &arg2, Args &... args ) {
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <memory>
@@ -29,7 +31,7 @@
 
 #include "../cpp_17.h"
 #include "../daw_move.h"
-#include "../daw_value_ptr.h"
+#include "daw_spin_lock.h"
 
 namespace daw {
 	template<typename>
@@ -44,90 +46,128 @@ namespace daw {
 	template<typename T>
 	inline constexpr bool is_shared_semaphore_v = is_shared_semaphore<daw::remove_cvref_t<T>>::value;	
 
+	// A counting semaphore whose uncontended notify and try_wait are a single
+	// atomic RMW on the count.  The mutex and condition variable are only
+	// used to park when the count is exhausted, and notify only touches them
+	// when a waiter is registered.  While unlatched no wait succeeds
 	template<typename Mutex, typename ConditionVariable>
 	class basic_semaphore {
-		value_ptr<Mutex> m_mutex;
-		value_ptr<ConditionVariable> m_condition;
-		intmax_t m_count = 0;
-		bool m_latched = true;
+		struct state_t {
+			std::atomic<intmax_t> count;
+			std::atomic<bool> latched;
+			// Threads that are, or are about to be, parked
+			std::atomic<uint32_t> waiters{0};
+			Mutex mutex{};
+			ConditionVariable condition{};
+
+			state_t( intmax_t c, bool l )
+			  : count( c )
+			  , latched( l ) {}
+		};
+		std::unique_ptr<state_t> m_state =
+		  std::make_unique<state_t>( intmax_t{0}, true );
+
+		void wake( bool all ) {
+			if( m_state->waiters.load( ) == 0 ) {
+				return;
+			}
+			// Taking the lock orders us after a waiter that checked the count but
+			// has not started waiting yet
+			{ auto lock = std::unique_lock<Mutex>( m_state->mutex ); }
+			if( all ) {
+				m_state->condition.notify_all( );
+			} else {
+				m_state->condition.notify_one( );
+			}
+		}
+
+		template<typename Park>
+		bool wait_slow( Park park ) {
+			m_state->waiters.fetch_add( 1 );
+			auto lock = std::unique_lock<Mutex>( m_state->mutex );
+			bool const result = park( lock, [&]( ) { return try_wait( ); } );
+			lock.unlock( );
+			m_state->waiters.fetch_sub( 1 );
+			return result;
+		}
 
 	public:
 		basic_semaphore( ) = default;
 
 		template<typename Int>
 		explicit basic_semaphore( Int count )
-		  : m_mutex( )
-		  , m_condition( )
-		  , m_count( static_cast<intmax_t>( count ) )
-		  , m_latched( true ) {}
+		  : m_state(
+		      std::make_unique<state_t>( static_cast<intmax_t>( count ), true ) ) {}
 
 		template<typename Int>
 		basic_semaphore( Int count, bool latched )
-		  : m_mutex( )
-		  , m_condition( )
-		  , m_count( static_cast<intmax_t>( count ) )
-		  , m_latched( latched ) {}
+		  : m_state( std::make_unique<state_t>( static_cast<intmax_t>( count ),
+		                                        latched ) ) {}
 
 		void notify( ) {
-			auto lock = std::unique_lock<Mutex>( *m_mutex );
-			++m_count;
-			if( m_latched ) {
-				m_condition->notify_one( );
+			m_state->count.fetch_add( 1 );
+			if( m_state->latched.load( std::memory_order_relaxed ) ) {
+				wake( false );
 			}
 		}
 
 		void add_notifier( ) {
-			auto lock = std::unique_lock<Mutex>( *m_mutex );
-			--m_count;
+			m_state->count.fetch_sub( 1, std::memory_order_relaxed );
 		}
 
 		void set_latch( ) {
-			auto lock = std::unique_lock<Mutex>( *m_mutex );
-			m_latched = true;
-			m_condition->notify_one( );
+			m_state->latched.store( true );
+			wake( true );
 		}
 
 		void wait( ) {
+			// A short spin catches a notify that is already on its way
 			for( size_t n = 0; n < 100; ++n ) {
 				if( try_wait( ) ) {
 					return;
 				}
+				spin_lock_impl::cpu_relax( );
 			}
-			auto lock = std::unique_lock<Mutex>( *m_mutex );
-			m_condition->wait( lock, [&]( ) { return m_latched and m_count > 0; } );
-			--m_count;
+			wait_slow( [&]( auto &lock, auto pred ) {
+				m_state->condition.wait( lock, pred );
+				return true;
+			} );
 		}
 
 		bool try_wait( ) {
-			auto lock = std::unique_lock<Mutex>( *m_mutex );
-			if( m_latched and m_count > 0 ) {
-				--m_count;
-				return true;
+			// These loads pair with the waiter count checks in notify/set_latch
+			// and so must stay sequentially consistent
+			if( not m_state->latched.load( ) ) {
+				return false;
+			}
+			auto count = m_state->count.load( );
+			while( count > 0 ) {
+				if( m_state->count.compare_exchange_weak( count, count - 1 ) ) {
+					return true;
+				}
 			}
 			return false;
 		}
 
 		template<typename Rep, typename Period>
 		auto wait_for( std::chrono::duration<Rep, Period> const &rel_time ) {
-			auto lock = std::unique_lock<Mutex>( *m_mutex );
-			auto status = m_condition->wait_for(
-			  lock, rel_time, [&]( ) { return m_latched and m_count > 0; } );
-			if( status ) {
-				--m_count;
+			if( try_wait( ) ) {
+				return true;
 			}
-			return status;
+			return wait_slow( [&]( auto &lock, auto pred ) {
+				return m_state->condition.wait_for( lock, rel_time, pred );
+			} );
 		}
 
 		template<typename Clock, typename Duration>
 		auto
 		wait_until( std::chrono::time_point<Clock, Duration> const &timeout_time ) {
-			auto lock = std::unique_lock<Mutex>( *m_mutex );
-			auto status = m_condition->wait_until(
-			  lock, timeout_time, [&]( ) { return m_latched and m_count > 0; } );
-			if( status ) {
-				--m_count;
+			if( try_wait( ) ) {
+				return true;
 			}
-			return status;
+			return wait_slow( [&]( auto &lock, auto pred ) {
+				return m_state->condition.wait_until( lock, timeout_time, pred );
+			} );
 		}
 	}; // basic_semaphore
 	template<typename Mutex, typename ConditionVariable>
@@ -0,0 +1,407 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include "daw_spin_lock.h"
+
+namespace daw {
+	namespace sharded_impl {
+		// Power of two so a thread's shard is a mask away
+		inline size_t default_shard_count( ) noexcept {
+			static size_t const result = [] {
+				size_t const cores =
+				  std::max( std::thread::hardware_concurrency( ), 1U );
+				size_t count = 1;
+				while( count < cores and count < 256 ) {
+					count *= 2;
+				}
+				return count;
+			}( );
+			return result;
+		}
+
+		// Threads are dealt shards round robin on first use, so up to shard count
+		// threads each get a cache line to themselves.  This is cheaper than
+		// asking which core we are on and does not move when the thread migrates
+		inline size_t thread_index( ) noexcept {
+			static std::atomic<size_t> next_index = 0;
+			thread_local size_t const index =
+			  next_index.fetch_add( 1, std::memory_order_relaxed );
+			return index;
+		}
+
+		inline size_t round_to_shards( size_t count ) noexcept {
+			size_t result = 1;
+			while( result < count ) {
+				result *= 2;
+			}
+			return result;
+		}
+
+		template<typename T>
+		struct alignas( 64 ) padded_t {
+			std::atomic<T> value;
+		};
+
+		// fetch_add on floating point atomics arrives in C++20
+		template<typename T>
+		void atomic_add( std::atomic<T> &a, T v ) noexcept {
+			if constexpr( std::is_integral_v<T> ) {
+				a.fetch_add( v, std::memory_order_relaxed );
+			} else {
+				T cur = a.load( std::memory_order_relaxed );
+				while( not a.compare_exchange_weak( cur, cur + v,
+				                                    std::memory_order_relaxed ) ) {}
+			}
+		}
+
+		struct min_of {
+			template<typename T>
+			static constexpr T identity( ) noexcept {
+				return std::numeric_limits<T>::max( );
+			}
+
+			template<typename T>
+			static constexpr bool better( T const &a, T const &b ) noexcept {
+				return a < b;
+			}
+		};
+
+		struct max_of {
+			template<typename T>
+			static constexpr T identity( ) noexcept {
+				return std::numeric_limits<T>::lowest( );
+			}
+
+			template<typename T>
+			static constexpr bool better( T const &a, T const &b ) noexcept {
+				return b < a;
+			}
+		};
+
+		// Only writes when v improves on the current value, so once the extreme
+		// has settled an update is a load from a line that stays shared
+		template<typename Op, typename T>
+		void atomic_update( std::atomic<T> &a, T v ) noexcept {
+			T cur = a.load( std::memory_order_relaxed );
+			while( Op::better( v, cur ) and
+			       not a.compare_exchange_weak( cur, v,
+			                                    std::memory_order_relaxed ) ) {}
+		}
+	} // namespace sharded_impl
+
+	// An event counter that each thread bumps in its own cache line.  Once a
+	// shard has drifted Batch away from zero it is folded into a central value,
+	// so load_approx( ) is a single load that is off by less than max_error( ).
+	// load( ) adds up every shard and retries while a fold is in flight, giving
+	// a value between the counts at the start and the end of the call
+	template<typename T, size_t Batch = 1024>
+	class basic_sharded_counter {
+		static_assert( std::is_integral_v<T> and not std::is_same_v<T, bool>,
+		               "Sharded counters hold integers" );
+
+		using shard_t = sharded_impl::padded_t<T>;
+		using diff_t = std::make_signed_t<T>;
+
+		static constexpr size_t const max_batch =
+		  static_cast<size_t>( std::numeric_limits<diff_t>::max( ) );
+		static_assert( Batch > 0 and Batch <= max_batch,
+		               "Batch must fit in the signed counter type" );
+
+		size_t m_mask;
+		std::unique_ptr<shard_t[]> m_shards;
+		alignas( 64 ) std::atomic<T> m_central = 0;
+		std::atomic<size_t> m_folds_started = 0;
+		std::atomic<size_t> m_folds_finished = 0;
+
+		shard_t &shard( ) noexcept {
+			return m_shards[sharded_impl::thread_index( ) & m_mask];
+		}
+
+		void fold( shard_t &s ) noexcept {
+			m_folds_started.fetch_add( 1 );
+			m_central.fetch_add( s.value.exchange( 0 ) );
+			m_folds_finished.fetch_add( 1 );
+		}
+
+	public:
+		using value_type = T;
+
+		explicit basic_sharded_counter(
+		  size_t shard_count = sharded_impl::default_shard_count( ) )
+		  : m_mask( sharded_impl::round_to_shards( shard_count ) - 1 )
+		  , m_shards( std::make_unique<shard_t[]>( m_mask + 1 ) ) {
+
+			for( size_t n = 0; n <= m_mask; ++n ) {
+				m_shards[n].value.store( 0, std::memory_order_relaxed );
+			}
+		}
+
+		basic_sharded_counter( basic_sharded_counter const & ) = delete;
+		basic_sharded_counter &operator=( basic_sharded_counter const & ) = delete;
+
+		void add( T v ) noexcept {
+			auto &s = shard( );
+			auto const prev = s.value.fetch_add( v, std::memory_order_relaxed );
+			auto const local = static_cast<diff_t>( static_cast<T>( prev + v ) );
+			if( local >= static_cast<diff_t>( Batch ) or
+			    local <= -static_cast<diff_t>( Batch ) ) {
+				fold( s );
+			}
+		}
+
+		void sub( T v ) noexcept {
+			add( static_cast<T>( T{0} - v ) );
+		}
+
+		basic_sharded_counter &operator+=( T v ) noexcept {
+			add( v );
+			return *this;
+		}
+
+		basic_sharded_counter &operator-=( T v ) noexcept {
+			sub( v );
+			return *this;
+		}
+
+		basic_sharded_counter &operator++( ) noexcept {
+			add( 1 );
+			return *this;
+		}
+
+		basic_sharded_counter &operator--( ) noexcept {
+			sub( 1 );
+			return *this;
+		}
+
+		T load( ) const noexcept {
+			while( true ) {
+				// Reading finished before started means equal counts show no fold
+				// was part way through when we began
+				auto const finished = m_folds_finished.load( );
+				auto const started = m_folds_started.load( );
+				if( started == finished ) {
+					T result = m_central.load( );
+					for( size_t n = 0; n <= m_mask; ++n ) {
+						result = static_cast<T>( result + m_shards[n].value.load( ) );
+					}
+					if( m_folds_started.load( ) == started ) {
+						return result;
+					}
+				}
+				spin_lock_impl::cpu_relax( );
+			}
+		}
+
+		T load_approx( ) const noexcept {
+			return m_central.load( std::memory_order_relaxed );
+		}
+
+		// Bound on | load( ) - load_approx( ) |
+		size_t max_error( ) const noexcept {
+			return ( m_mask + 1 ) * ( Batch - 1 );
+		}
+
+		size_t shard_count( ) const noexcept {
+			return m_mask + 1;
+		}
+
+		// Counts added while resetting are either kept or dropped whole
+		void reset( ) noexcept {
+			m_folds_started.fetch_add( 1 );
+			for( size_t n = 0; n <= m_mask; ++n ) {
+				m_shards[n].value.exchange( 0 );
+			}
+			m_central.store( 0 );
+			m_folds_finished.fetch_add( 1 );
+		}
+	};
+
+	using sharded_counter = basic_sharded_counter<int64_t>;
+
+	// Running minimum or maximum of the values seen by all threads.  Op is
+	// sharded_impl::min_of or sharded_impl::max_of
+	template<typename T, typename Op>
+	class basic_sharded_extremum {
+		static_assert( std::is_arithmetic_v<T>,
+		               "Sharded extrema hold arithmetic values" );
+
+		using shard_t = sharded_impl::padded_t<T>;
+
+		size_t m_mask;
+		std::unique_ptr<shard_t[]> m_shards;
+
+	public:
+		using value_type = T;
+
+		explicit basic_sharded_extremum(
+		  size_t shard_count = sharded_impl::default_shard_count( ) )
+		  : m_mask( sharded_impl::round_to_shards( shard_count ) - 1 )
+		  , m_shards( std::make_unique<shard_t[]>( m_mask + 1 ) ) {
+
+			reset( );
+		}
+
+		basic_sharded_extremum( basic_sharded_extremum const & ) = delete;
+		basic_sharded_extremum &
+		operator=( basic_sharded_extremum const & ) = delete;
+
+		void update( T v ) noexcept {
+			sharded_impl::atomic_update<Op>(
+			  m_shards[sharded_impl::thread_index( ) & m_mask].value, v );
+		}
+
+		// The identity, numeric_limits max for a minimum and lowest for a maximum,
+		// until the first update
+		T load( ) const noexcept {
+			T result = Op::template identity<T>( );
+			for( size_t n = 0; n <= m_mask; ++n ) {
+				auto const v = m_shards[n].value.load( std::memory_order_acquire );
+				if( Op::better( v, result ) ) {
+					result = v;
+				}
+			}
+			return result;
+		}
+
+		void reset( ) noexcept {
+			for( size_t n = 0; n <= m_mask; ++n ) {
+				m_shards[n].value.store( Op::template identity<T>( ),
+				                         std::memory_order_release );
+			}
+		}
+	};
+
+	template<typename T>
+	using sharded_min = basic_sharded_extremum<T, sharded_impl::min_of>;
+
+	template<typename T>
+	using sharded_max = basic_sharded_extremum<T, sharded_impl::max_of>;
+
+	template<typename T>
+	struct accumulator_snapshot {
+		size_t count = 0;
+		T sum{};
+		T min = sharded_impl::min_of::identity<T>( );
+		T max = sharded_impl::max_of::identity<T>( );
+
+		double mean( ) const noexcept {
+			if( count == 0 ) {
+				return 0.0;
+			}
+			return static_cast<double>( sum ) / static_cast<double>( count );
+		}
+	};
+
+	// Count, sum, minimum and maximum of recorded samples such as latencies.
+	// Every field of a shard is only written by the threads mapped to it, so
+	// record costs a few uncontended atomics.  snapshot( ) is exact once the
+	// writers are quiet; taken during updates the fields may disagree by the
+	// samples in flight
+	template<typename T>
+	class sharded_accumulator {
+		static_assert( std::is_arithmetic_v<T>,
+		               "Sharded accumulators hold arithmetic values" );
+
+		struct alignas( 64 ) shard_t {
+			std::atomic<size_t> count;
+			std::atomic<T> sum;
+			std::atomic<T> min;
+			std::atomic<T> max;
+		};
+
+		size_t m_mask;
+		std::unique_ptr<shard_t[]> m_shards;
+
+	public:
+		using value_type = T;
+		using snapshot_type = accumulator_snapshot<T>;
+
+		explicit sharded_accumulator(
+		  size_t shard_count = sharded_impl::default_shard_count( ) )
+		  : m_mask( sharded_impl::round_to_shards( shard_count ) - 1 )
+		  , m_shards( std::make_unique<shard_t[]>( m_mask + 1 ) ) {
+
+			reset( );
+		}
+
+		sharded_accumulator( sharded_accumulator const & ) = delete;
+		sharded_accumulator &operator=( sharded_accumulator const & ) = delete;
+
+		void record( T v ) noexcept {
+			auto &s = m_shards[sharded_impl::thread_index( ) & m_mask];
+			sharded_impl::atomic_add( s.sum, v );
+			sharded_impl::atomic_update<sharded_impl::min_of>( s.min, v );
+			sharded_impl::atomic_update<sharded_impl::max_of>( s.max, v );
+			s.count.fetch_add( 1, std::memory_order_release );
+		}
+
+		size_t count( ) const noexcept {
+			size_t result = 0;
+			for( size_t n = 0; n <= m_mask; ++n ) {
+				result += m_shards[n].count.load( std::memory_order_relaxed );
+			}
+			return result;
+		}
+
+		snapshot_type snapshot( ) const noexcept {
+			snapshot_type result{};
+			for( size_t n = 0; n <= m_mask; ++n ) {
+				auto const &s = m_shards[n];
+				result.count += s.count.load( std::memory_order_acquire );
+				result.sum += s.sum.load( std::memory_order_relaxed );
+				auto const mn = s.min.load( std::memory_order_relaxed );
+				auto const mx = s.max.load( std::memory_order_relaxed );
+				if( mn < result.min ) {
+					result.min = mn;
+				}
+				if( result.max < mx ) {
+					result.max = mx;
+				}
+			}
+			return result;
+		}
+
+		// Not atomic with respect to concurrent record calls
+		void reset( ) noexcept {
+			for( size_t n = 0; n <= m_mask; ++n ) {
+				auto &s = m_shards[n];
+				s.count.store( 0, std::memory_order_relaxed );
+				s.sum.store( T{}, std::memory_order_relaxed );
+				s.min.store( sharded_impl::min_of::identity<T>( ),
+				             std::memory_order_relaxed );
+				s.max.store( sharded_impl::max_of::identity<T>( ),
+				             std::memory_order_release );
+			}
+		}
+	};
+} // namespace daw
@@ -23,6 +23,23 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+#if defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#include <intrin.h>
+#define DAW_HAS_MM_PAUSE
+#elif defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define DAW_HAS_MM_PAUSE
+#endif
+
+#if defined( __linux__ )
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 namespace daw {
 	class spin_lock {
@@ -41,4 +58,160 @@ namespace daw {
 			m_flag.clear( std::memory_order_release );
 		}
 	};
+
+	namespace spin_lock_impl {
+		// Tell the core we are in a spin wait, this frees pipeline resources for
+		// a sibling hyperthread and avoids a memory order mis-speculation on exit
+		inline void cpu_relax( ) noexcept {
+#if defined( DAW_HAS_MM_PAUSE )
+			_mm_pause( );
+#elif defined( __aarch64__ ) || defined( __arm__ )
+			__asm__ __volatile__( "yield" );
+#endif
+		}
+
+		static_assert( sizeof( std::atomic<uint32_t> ) == sizeof( uint32_t ) and
+		                 std::atomic<uint32_t>::is_always_lock_free,
+		               "A futex word must be a plain 32bit integer" );
+
+		// Sleep while *word == expected.  May return spuriously
+		inline void park( std::atomic<uint32_t> &word,
+		                  uint32_t expected ) noexcept {
+#if defined( __linux__ )
+			syscall( SYS_futex, reinterpret_cast<uint32_t *>( &word ),
+			         FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0 );
+#else
+			if( word.load( std::memory_order_relaxed ) == expected ) {
+				std::this_thread::yield( );
+			}
+#endif
+		}
+
+		inline void unpark_one( std::atomic<uint32_t> &word ) noexcept {
+#if defined( __linux__ )
+			syscall( SYS_futex, reinterpret_cast<uint32_t *>( &word ),
+			         FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0 );
+#else
+			static_cast<void>( word );
+#endif
+		}
+
+		inline void unpark_all( std::atomic<uint32_t> &word ) noexcept {
+#if defined( __linux__ )
+			syscall( SYS_futex, reinterpret_cast<uint32_t *>( &word ),
+			         FUTEX_WAKE_PRIVATE, std::numeric_limits<int>::max( ), nullptr,
+			         nullptr, 0 );
+#else
+			static_cast<void>( word );
+#endif
+		}
+	} // namespace spin_lock_impl
+
+	// Snapshot of an adaptive_spin_lock's slow path activity
+	struct spin_lock_stats {
+		// Acquisitions that did not get the lock on the first attempt
+		uint64_t contended = 0;
+		// Pause instructions issued while waiting
+		uint64_t spins = 0;
+		// Times a thread went to sleep in the kernel
+		uint64_t parks = 0;
+	};
+
+	// A test and test-and-set lock that spins with pause and exponential
+	// backoff for a bounded budget, then sleeps on a futex(Linux) until the
+	// holder unlocks.  Short critical sections never leave user space and
+	// long ones do not burn a core.  The uncontended path is one CAS to lock
+	// and one exchange to unlock
+	template<uint32_t SpinBudget = 4096, uint32_t MaxBackoff = 64>
+	class basic_adaptive_spin_lock {
+		static_assert( MaxBackoff > 0 );
+
+		enum : uint32_t { unlocked = 0, locked = 1, locked_waiters = 2 };
+
+		// Waiters spin on m_state while the slow path bumps the counters, keep
+		// them on separate cache lines
+		alignas( 64 ) std::atomic<uint32_t> m_state{unlocked};
+		alignas( 64 ) std::atomic<uint64_t> m_contended{0};
+		std::atomic<uint64_t> m_spins{0};
+		std::atomic<uint64_t> m_parks{0};
+
+		void lock_slow( ) noexcept {
+			m_contended.fetch_add( 1, std::memory_order_relaxed );
+			uint32_t spins = 0;
+			uint32_t backoff = 1;
+			while( spins < SpinBudget ) {
+				// Spin on a load so waiters share the cache line until it changes
+				if( m_state.load( std::memory_order_relaxed ) == unlocked ) {
+					uint32_t expected = unlocked;
+					if( m_state.compare_exchange_weak( expected, locked,
+					                                   std::memory_order_acquire,
+					                                   std::memory_order_relaxed ) ) {
+						m_spins.fetch_add( spins, std::memory_order_relaxed );
+						return;
+					}
+				}
+				for( uint32_t n = 0; n < backoff; ++n ) {
+					spin_lock_impl::cpu_relax( );
+				}
+				spins += backoff;
+				if( backoff < MaxBackoff ) {
+					backoff *= 2;
+				}
+			}
+			m_spins.fetch_add( spins, std::memory_order_relaxed );
+			// Mark the lock as having sleepers so unlock knows to wake one.  The
+			// owner may be another parked thread, so keep locked_waiters set
+			while( m_state.exchange( locked_waiters, std::memory_order_acquire ) !=
+			       unlocked ) {
+				m_parks.fetch_add( 1, std::memory_order_relaxed );
+				spin_lock_impl::park( m_state, locked_waiters );
+			}
+		}
+
+	public:
+		basic_adaptive_spin_lock( ) = default;
+		basic_adaptive_spin_lock( basic_adaptive_spin_lock const & ) = delete;
+		basic_adaptive_spin_lock &
+		operator=( basic_adaptive_spin_lock const & ) = delete;
+
+		bool try_lock( ) noexcept {
+			uint32_t expected = unlocked;
+			return m_state.load( std::memory_order_relaxed ) == unlocked and
+			       m_state.compare_exchange_strong( expected, locked,
+			                                        std::memory_order_acquire,
+			                                        std::memory_order_relaxed );
+		}
+
+		void lock( ) noexcept {
+			uint32_t expected = unlocked;
+			if( not m_state.compare_exchange_strong( expected, locked,
+			                                         std::memory_order_acquire,
+			                                         std::memory_order_relaxed ) ) {
+				lock_slow( );
+			}
+		}
+
+		void unlock( ) noexcept {
+			if( m_state.exchange( unlocked, std::memory_order_release ) ==
+			    locked_waiters ) {
+				spin_lock_impl::unpark_one( m_state );
+			}
+		}
+
+		spin_lock_stats stats( ) const noexcept {
+			spin_lock_stats result{};
+			result.contended = m_contended.load( std::memory_order_relaxed );
+			result.spins = m_spins.load( std::memory_order_relaxed );
+			result.parks = m_parks.load( std::memory_order_relaxed );
+			return result;
+		}
+
+		void reset_stats( ) noexcept {
+			m_contended.store( 0, std::memory_order_relaxed );
+			m_spins.store( 0, std::memory_order_relaxed );
+			m_parks.store( 0, std::memory_order_relaxed );
+		}
+	};
+
+	using adaptive_spin_lock = basic_adaptive_spin_lock<>;
 } // namespace daw
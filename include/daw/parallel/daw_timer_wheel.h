@@ -0,0 +1,374 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "concurrent_queue.h"
+#include "daw_spin_lock.h"
+
+namespace daw {
+	// A hashed hierarchical timing wheel for large numbers of timeouts.  Time is
+	// cut into ticks of a fixed resolution.  Level 0 has a slot per tick for the
+	// next 256 ticks, and each level above covers 256 times the span of the one
+	// below.  Timers in a higher level move down a level when the level below
+	// wraps, so schedule and cancel are O(1).  An advance expires a tick's slot
+	// at once and jumps over stretches where the lower levels are empty.
+	//
+	// Time moves when advance( now ) is called, or on a thread started with
+	// start_ticking( ).  Expired callbacks run on the advancing thread, or are
+	// pushed in one batch to a concurrent_queue given at construction for other
+	// threads to run.  Deadlines are rounded up to a tick, so a timer never
+	// fires early.  One that is already due fires on the next tick
+	template<typename Clock = std::chrono::steady_clock>
+	class basic_timer_wheel {
+	public:
+		using clock_type = Clock;
+		using time_point = typename Clock::time_point;
+		using duration = typename Clock::duration;
+		using callback_t = std::function<void( )>;
+		using queue_t = concurrent_queue<callback_t>;
+
+		struct timer_id {
+			uint32_t index = std::numeric_limits<uint32_t>::max( );
+			uint32_t generation = 0;
+		};
+
+	private:
+		static constexpr uint32_t const npos =
+		  std::numeric_limits<uint32_t>::max( );
+		static constexpr size_t const slot_bits = 8;
+		static constexpr size_t const slot_count = size_t{1} << slot_bits;
+		static constexpr size_t const level_count = 4;
+		// Further out timers wait in the top level and are placed again when it
+		// comes round
+		static constexpr uint64_t const max_delta =
+		  ( uint64_t{1} << ( slot_bits * level_count ) ) - 1;
+
+		struct node_t {
+			callback_t callback{};
+			uint64_t deadline = 0;
+			uint32_t prev = npos;
+			uint32_t next = npos;
+			uint32_t slot = npos;
+			uint32_t generation = 0;
+		};
+
+		duration m_resolution;
+		time_point m_start;
+		queue_t *m_queue;
+
+		mutable adaptive_spin_lock m_lock{};
+		// The next tick to process
+		uint64_t m_tick = 0;
+		size_t m_count = 0;
+		std::array<size_t, level_count> m_level_count{};
+		std::array<uint32_t, slot_count * level_count> m_slots{};
+		std::vector<node_t> m_nodes{};
+		uint32_t m_free = npos;
+
+		std::mutex m_ticker_mutex{};
+		std::condition_variable m_ticker_cv{};
+		bool m_ticker_stop = false;
+		std::thread m_ticker{};
+
+		uint64_t ticks_until( time_point tp, bool round_up ) const noexcept {
+			if( tp <= m_start ) {
+				return 0;
+			}
+			auto const since = tp - m_start;
+			auto ticks = static_cast<uint64_t>( since / m_resolution );
+			if( round_up and since % m_resolution != duration::zero( ) ) {
+				++ticks;
+			}
+			return ticks;
+		}
+
+		static constexpr size_t level_of( uint32_t slot ) noexcept {
+			return slot / slot_count;
+		}
+
+		// Caller holds m_lock
+		void link( uint32_t index ) noexcept {
+			auto &node = m_nodes[index];
+			auto delta = node.deadline > m_tick ? node.deadline - m_tick : 0;
+			auto deadline = m_tick + delta;
+			if( delta > max_delta ) {
+				delta = max_delta;
+				deadline = m_tick + max_delta;
+			}
+			size_t level = 0;
+			while( delta >= ( uint64_t{1} << ( slot_bits * ( level + 1 ) ) ) ) {
+				++level;
+			}
+			auto const slot = static_cast<uint32_t>(
+			  level * slot_count +
+			  ( ( deadline >> ( slot_bits * level ) ) & ( slot_count - 1 ) ) );
+			node.slot = slot;
+			node.prev = npos;
+			node.next = m_slots[slot];
+			if( node.next != npos ) {
+				m_nodes[node.next].prev = index;
+			}
+			m_slots[slot] = index;
+			++m_level_count[level];
+		}
+
+		void unlink( uint32_t index ) noexcept {
+			auto &node = m_nodes[index];
+			if( node.prev != npos ) {
+				m_nodes[node.prev].next = node.next;
+			} else {
+				m_slots[node.slot] = node.next;
+			}
+			if( node.next != npos ) {
+				m_nodes[node.next].prev = node.prev;
+			}
+			--m_level_count[level_of( node.slot )];
+			node.slot = npos;
+		}
+
+		uint32_t take_slot( uint32_t slot ) noexcept {
+			auto const head = m_slots[slot];
+			m_slots[slot] = npos;
+			return head;
+		}
+
+		void free_node( uint32_t index ) noexcept {
+			auto &node = m_nodes[index];
+			node.callback = nullptr;
+			++node.generation;
+			node.next = m_free;
+			m_free = index;
+		}
+
+		// Move the slot of every level above 0 that wraps at m_tick down
+		void cascade( ) noexcept {
+			for( size_t level = 1; level < level_count; ++level ) {
+				auto const low_bits = slot_bits * level;
+				if( ( m_tick & ( ( uint64_t{1} << low_bits ) - 1 ) ) != 0 ) {
+					return;
+				}
+				auto const slot = static_cast<uint32_t>(
+				  level * slot_count +
+				  ( ( m_tick >> low_bits ) & ( slot_count - 1 ) ) );
+				auto cur = take_slot( slot );
+				while( cur != npos ) {
+					auto const next = m_nodes[cur].next;
+					--m_level_count[level];
+					link( cur );
+					cur = next;
+				}
+			}
+		}
+
+		// The first tick after m_tick where anything could happen, given that
+		// the lowest levels are empty
+		uint64_t next_busy_tick( ) const noexcept {
+			size_t level = 0;
+			while( level < level_count and m_level_count[level] == 0 ) {
+				++level;
+			}
+			if( level == 0 ) {
+				return m_tick;
+			}
+			auto const span = uint64_t{1} << ( slot_bits * level );
+			return ( m_tick + span - 1 ) & ~( span - 1 );
+		}
+
+		void dispatch( std::vector<callback_t> &expired ) {
+			if( m_queue != nullptr ) {
+				m_queue->push_range( std::make_move_iterator( expired.begin( ) ),
+				                     std::make_move_iterator( expired.end( ) ) );
+			} else {
+				for( auto &cb : expired ) {
+					cb( );
+				}
+			}
+		}
+
+	public:
+		explicit basic_timer_wheel(
+		  duration resolution = std::chrono::milliseconds( 1 ),
+		  time_point start = Clock::now( ) )
+		  : m_resolution( resolution )
+		  , m_start( start )
+		  , m_queue( nullptr ) {
+
+			m_slots.fill( npos );
+		}
+
+		// Expired callbacks are pushed to queue, which must outlive the wheel
+		explicit basic_timer_wheel(
+		  queue_t &queue, duration resolution = std::chrono::milliseconds( 1 ),
+		  time_point start = Clock::now( ) )
+		  : m_resolution( resolution )
+		  , m_start( start )
+		  , m_queue( &queue ) {
+
+			m_slots.fill( npos );
+		}
+
+		basic_timer_wheel( basic_timer_wheel const & ) = delete;
+		basic_timer_wheel &operator=( basic_timer_wheel const & ) = delete;
+
+		~basic_timer_wheel( ) {
+			stop_ticking( );
+		}
+
+		timer_id schedule_at( time_point deadline, callback_t callback ) {
+			auto const tick = ticks_until( deadline, true );
+			std::lock_guard<adaptive_spin_lock> lock( m_lock );
+			auto index = m_free;
+			if( index != npos ) {
+				m_free = m_nodes[index].next;
+			} else {
+				index = static_cast<uint32_t>( m_nodes.size( ) );
+				m_nodes.emplace_back( );
+			}
+			auto &node = m_nodes[index];
+			node.callback = std::move( callback );
+			node.deadline = tick;
+			link( index );
+			++m_count;
+			return {index, node.generation};
+		}
+
+		timer_id schedule_after( duration delay, callback_t callback ) {
+			return schedule_at( Clock::now( ) + delay, std::move( callback ) );
+		}
+
+		// True when the timer was pending and now will not fire.  False when it
+		// has already expired, was cancelled or id is not from this wheel
+		bool cancel( timer_id id ) noexcept {
+			std::lock_guard<adaptive_spin_lock> lock( m_lock );
+			if( id.index >= m_nodes.size( ) or
+			    m_nodes[id.index].generation != id.generation or
+			    m_nodes[id.index].slot == npos ) {
+				return false;
+			}
+			unlink( id.index );
+			free_node( id.index );
+			--m_count;
+			return true;
+		}
+
+		// Expire every timer due at or before now and returns how many there were
+		size_t advance( time_point now ) {
+			auto const target = ticks_until( now, false );
+			std::vector<callback_t> expired{};
+			{
+				std::lock_guard<adaptive_spin_lock> lock( m_lock );
+				while( m_tick <= target ) {
+					if( m_count == 0 ) {
+						m_tick = target + 1;
+						break;
+					}
+					cascade( );
+					auto cur = take_slot(
+					  static_cast<uint32_t>( m_tick & ( slot_count - 1 ) ) );
+					while( cur != npos ) {
+						auto &node = m_nodes[cur];
+						auto const next = node.next;
+						--m_level_count[0];
+						--m_count;
+						node.slot = npos;
+						expired.push_back( std::move( node.callback ) );
+						free_node( cur );
+						cur = next;
+					}
+					++m_tick;
+					if( m_count != 0 ) {
+						m_tick = std::min( next_busy_tick( ), target + 1 );
+					}
+				}
+			}
+			dispatch( expired );
+			return expired.size( );
+		}
+
+		size_t size( ) const noexcept {
+			std::lock_guard<adaptive_spin_lock> lock( m_lock );
+			return m_count;
+		}
+
+		duration resolution( ) const noexcept {
+			return m_resolution;
+		}
+
+		// Calls advance( Clock::now( ) ) each tick on a new thread until
+		// stop_ticking( ) or destruction
+		void start_ticking( ) {
+			std::lock_guard<std::mutex> lock( m_ticker_mutex );
+			if( m_ticker.joinable( ) ) {
+				return;
+			}
+			m_ticker_stop = false;
+			m_ticker = std::thread( [this]( ) {
+				std::unique_lock<std::mutex> lck( m_ticker_mutex );
+				while( not m_ticker_stop ) {
+					auto const next_tick =
+					  m_start +
+					  m_resolution *
+					    static_cast<typename duration::rep>(
+					      ticks_until( Clock::now( ), false ) + 1 );
+					if( m_ticker_cv.wait_until( lck, next_tick,
+					                            [this] { return m_ticker_stop; } ) ) {
+						break;
+					}
+					lck.unlock( );
+					advance( Clock::now( ) );
+					lck.lock( );
+				}
+			} );
+		}
+
+		void stop_ticking( ) {
+			std::thread ticker{};
+			{
+				std::lock_guard<std::mutex> lock( m_ticker_mutex );
+				m_ticker_stop = true;
+				ticker = std::move( m_ticker );
+			}
+			m_ticker_cv.notify_all( );
+			if( ticker.joinable( ) ) {
+				ticker.join( );
+			}
+		}
+	};
+
+	using timer_wheel = basic_timer_wheel<>;
+} // namespace daw
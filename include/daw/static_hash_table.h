@@ -22,9 +22,13 @@
 
 #pragma once
 
+#include <initializer_list>
 #include <limits>
+#include <type_traits>
+#include <utility>
 
 #include "daw_fnv1a_hash.h"
+#include "daw_hash_stats.h"
 #include "daw_move.h"
 
 namespace daw {
@@ -113,12 +117,11 @@ namespace daw {
 
 	public:
 		constexpr static_hash_t( )
-		  : m_values{} {
-			daw::algorithm::fill_n( m_values.begin( ), Capacity, hash_item{} );
-		}
+		  : m_values{} {}
 
 		constexpr static_hash_t(
-		  std::initializer_list<std::pair<char const *const, value_type>> items ) {
+		  std::initializer_list<std::pair<char const *const, value_type>> items )
+		  : m_values{} {
 			for( auto const &item : items ) {
 				auto const hash = hash_fn( item.first );
 				auto const pos = find_impl( hash );
@@ -129,7 +132,8 @@ namespace daw {
 
 		template<typename K>
 		constexpr static_hash_t(
-		  std::initializer_list<std::pair<K, value_type>> items ) {
+		  std::initializer_list<std::pair<K, value_type>> items )
+		  : m_values{} {
 			for( auto const &item : items ) {
 				auto const hash = hash_fn( item.first );
 				auto const pos = find_impl( hash );
@@ -163,7 +167,6 @@ namespace daw {
 		constexpr const_reference operator[]( K const &key ) const {
 			auto const hash = hash_fn( key );
 			auto const pos = find_impl( hash );
-			m_values[pos].hash_value = hash;
 			return m_values[pos].value;
 		}
 
@@ -173,6 +176,19 @@ namespace daw {
 			return m_values[pos].value;
 		}
 
+		// Probe lengths and occupancy of the table
+		hash_stats_t stats( ) const {
+			hash_stats_t result{};
+			result.capacity = Capacity;
+			for( size_t n = 0; n < Capacity; ++n ) {
+				auto const hash = m_values[n].hash_value;
+				if( hash != static_cast<size_t>( hash_sentinals::empty ) ) {
+					result.add_item(
+					  hash_stats_t::displacement( scale_hash( hash ), n, Capacity ) );
+				}
+			}
+			return result;
+		}
 	}; // static_hash_t
 
 } // namespace daw
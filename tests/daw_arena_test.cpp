@@ -0,0 +1,237 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "daw/daw_arena.h"
+#include "daw/daw_benchmark.h"
+#include "daw/daw_clumpy_sparsy.h"
+#include "daw/daw_graph.h"
+#include "daw/daw_hash_table2.h"
+#include "daw/daw_heap_array.h"
+#include "daw/daw_ordered_map.h"
+
+void daw_arena_allocate_001( ) {
+	daw::arena a( 128 );
+	auto p0 = static_cast<char *>( a.allocate( 10, 1 ) );
+	auto p1 = static_cast<char *>( a.allocate( 10, 1 ) );
+	daw::expecting( p0 + 10, p1 );
+	auto p2 = a.allocate( 8, 64 );
+	daw::expecting( 0U, reinterpret_cast<uintptr_t>( p2 ) % 64U );
+	// Larger than a block gets a block of its own
+	auto p3 = a.allocate_array<int>( 1000 );
+	p3[0] = 5;
+	daw::expecting( 5, p3[0] );
+	daw::expecting( a.bytes_reserved( ) >= 128U + 1000U * sizeof( int ) );
+	daw::expecting_exception<std::invalid_argument>(
+	  [&]( ) { a.allocate( 8, 3 ); } );
+}
+
+void daw_arena_rewind_001( ) {
+	daw::arena a( 256 );
+	auto p0 = a.make<int>( 1 );
+	auto const marker = a.mark( );
+	auto p1 = a.make<int>( 2 );
+	for( int n = 0; n < 100; ++n ) {
+		a.make<int>( n );
+	}
+	auto const reserved = a.bytes_reserved( );
+	a.rewind( marker );
+	daw::expecting( 1, *p0 );
+	// The space after the marker is reused, including the spare blocks
+	daw::expecting( p1, a.make<int>( 3 ) );
+	for( int n = 0; n < 100; ++n ) {
+		a.make<int>( n );
+	}
+	daw::expecting( reserved, a.bytes_reserved( ) );
+}
+
+void daw_arena_reset_001( ) {
+	daw::arena a( 256 );
+	auto p0 = a.allocate( 16 );
+	for( int n = 0; n < 100; ++n ) {
+		a.allocate( 16 );
+	}
+	auto const reserved = a.bytes_reserved( );
+	a.reset( );
+	daw::expecting( reserved, a.bytes_reserved( ) );
+	auto p1 = a.allocate( 16 );
+	daw::expecting( p0 != nullptr and p1 != nullptr );
+	for( int n = 0; n < 100; ++n ) {
+		a.allocate( 16 );
+	}
+	daw::expecting( reserved, a.bytes_reserved( ) );
+	a.release( );
+	daw::expecting( 0U, a.bytes_reserved( ) );
+}
+
+void daw_arena_allocator_containers_001( ) {
+	daw::arena a;
+	{
+		daw::heap_array<int, daw::arena_allocator<int>> ha(
+		  5, 3, daw::arena_allocator<int>( a ) );
+		daw::expecting( 5U, ha.size( ) );
+		daw::expecting( 3, ha[4] );
+		daw::expecting( &a, &ha.get_allocator( ).get_arena( ) );
+		auto ha2 = ha;
+		daw::expecting( 3, ha2[0] );
+	}
+	{
+		using alloc_t = daw::arena_allocator<std::string>;
+		daw::hash_table<std::string, 11, 80,
+		                daw::resize_policies::golden_ratio,
+		                daw::rehash_modes::all_at_once, alloc_t>
+		  ht{alloc_t( a )};
+		for( size_t n = 0; n < 1000; ++n ) {
+			ht[n] = std::to_string( n );
+		}
+		daw::expecting( "999", ht[size_t{999}] );
+		daw::expecting( ht.exists( size_t{500} ) );
+	}
+	{
+		using alloc_t = daw::arena_allocator<int>;
+		daw::graph_t<int, alloc_t> g{alloc_t( a )};
+		auto n0 = g.add_node( 1 );
+		auto n1 = g.add_node( 2 );
+		g.add_directed_edge( n0, n1 );
+		daw::expecting( 2U, g.size( ) );
+		daw::expecting( g.has_node( n1 ) );
+	}
+	{
+		using alloc_t = daw::arena_allocator<std::pair<int, int>>;
+		daw::ordered_map<int, int, std::less<int>, alloc_t> om{alloc_t( a )};
+		for( int n = 0; n < 100; ++n ) {
+			om[n] = n * 2;
+		}
+		daw::expecting( 100U, om.size( ) );
+		daw::expecting( 198, om.at( 99 ) );
+	}
+	{
+		using alloc_t = daw::arena_allocator<int>;
+		daw::clumpy_sparsy<int, alloc_t> cs{alloc_t( a )};
+		daw::expecting( 0U, cs.size( ) );
+	}
+	auto const reserved = a.bytes_reserved( );
+	daw::expecting( reserved > 0U );
+	a.reset( );
+	daw::expecting( reserved, a.bytes_reserved( ) );
+}
+
+void daw_fixed_pool_001( ) {
+	daw::fixed_pool pool( 24, 16, 4 );
+	daw::expecting( 32U, pool.block_size( ) );
+	auto p0 = pool.allocate( );
+	auto p1 = pool.allocate( );
+	daw::expecting( 0U, reinterpret_cast<uintptr_t>( p0 ) % 16U );
+	daw::expecting( static_cast<char *>( p0 ) + 32, p1 );
+	pool.deallocate( p0 );
+	daw::expecting( p0, pool.allocate( ) );
+	for( int n = 0; n < 4; ++n ) {
+		pool.allocate( );
+	}
+	daw::expecting( 2U, pool.chunk_count( ) );
+}
+
+void daw_object_pool_001( ) {
+	daw::object_pool<std::string> pool;
+	auto s0 = pool.make( "hello" );
+	auto s1 = pool.make( 50U, 'a' );
+	daw::expecting( "hello", *s0 );
+	daw::expecting( 50U, s1->size( ) );
+	pool.destroy( s0 );
+	auto s2 = pool.make( "world" );
+	daw::expecting( s0, s2 );
+	pool.destroy( s1 );
+	pool.destroy( s2 );
+}
+
+void daw_pool_allocator_001( ) {
+	daw::fixed_pool pool( 64 );
+	{
+		using alloc_t = daw::pool_allocator<int>;
+		std::list<int, alloc_t> l{alloc_t( pool )};
+		for( int n = 0; n < 1000; ++n ) {
+			l.push_back( n );
+		}
+		daw::expecting( 1000U, l.size( ) );
+		l.clear( );
+	}
+	{
+		using value_t = std::pair<int const, int>;
+		using alloc_t = daw::pool_allocator<value_t>;
+		std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, alloc_t>
+		  m{alloc_t( pool )};
+		for( int n = 0; n < 1000; ++n ) {
+			m[n] = n;
+		}
+		daw::expecting( 999, m[999] );
+	}
+	daw::expecting( pool.chunk_count( ) > 0U );
+}
+
+void daw_arena_bench_001( ) {
+	size_t const count = 10'000;
+	size_t const rounds = 100;
+	daw::arena a;
+	auto const t_arena = daw::benchmark( [&]( ) {
+		for( size_t r = 0; r < rounds; ++r ) {
+			using alloc_t = daw::arena_allocator<std::pair<int const, int>>;
+			std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+			                   alloc_t>
+			  m{alloc_t( a )};
+			for( size_t n = 0; n < count; ++n ) {
+				m[static_cast<int>( n )] = static_cast<int>( n );
+			}
+			daw::do_not_optimize( m );
+			a.reset( );
+		}
+	} );
+	auto const t_new = daw::benchmark( [&]( ) {
+		for( size_t r = 0; r < rounds; ++r ) {
+			std::unordered_map<int, int> m;
+			for( size_t n = 0; n < count; ++n ) {
+				m[static_cast<int>( n )] = static_cast<int>( n );
+			}
+			daw::do_not_optimize( m );
+		}
+	} );
+	std::cout << "unordered_map with arena: " << daw::utility::format_seconds(
+	                                                t_arena, 2 )
+	          << '\n';
+	std::cout << "unordered_map with new: "
+	          << daw::utility::format_seconds( t_new, 2 ) << '\n';
+}
+
+int main( ) {
+	daw_arena_allocate_001( );
+	daw_arena_rewind_001( );
+	daw_arena_reset_001( );
+	daw_arena_allocator_containers_001( );
+	daw_fixed_pool_001( );
+	daw_object_pool_001( );
+	daw_pool_allocator_001( );
+	daw_arena_bench_001( );
+}
@@ -0,0 +1,241 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/daw_bloom_filter.h"
+#include "daw/daw_memory_mapped_file.h"
+#include "daw/daw_traits.h"
+
+template<typename Filter>
+double false_positive_rate( Filter const &filter, uint64_t first,
+                            uint64_t count ) {
+	size_t false_positives = 0;
+	for( uint64_t n = first; n < first + count; ++n ) {
+		if( filter.may_contain( n ) ) {
+			++false_positives;
+		}
+	}
+	return static_cast<double>( false_positives ) / static_cast<double>( count );
+}
+
+void bloom_filter_001( ) {
+	constexpr uint64_t const count = 100'000;
+	daw::bloom_filter<uint64_t> filter( count, 0.01 );
+	for( uint64_t n = 0; n < count; ++n ) {
+		filter.insert( n );
+	}
+	for( uint64_t n = 0; n < count; ++n ) {
+		daw::expecting( filter.may_contain( n ) );
+	}
+	auto const fpr = false_positive_rate( filter, count, count );
+	std::cout << "bloom_filter fpr: " << fpr << '\n';
+	daw::expecting( fpr < 0.02 );
+}
+
+void bloom_filter_002( ) {
+	daw::bloom_filter<std::string> filter( 1000 );
+	filter.insert( "hello" );
+	filter.insert( std::string( "world" ) );
+	daw::expecting( filter.may_contain( "hello" ) );
+	daw::expecting( filter.may_contain( "world" ) );
+	daw::expecting( 2U, filter.item_count( ) );
+	filter.clear( );
+	daw::expecting( !filter.may_contain( "hello" ) );
+}
+
+void blocked_bloom_filter_001( ) {
+	constexpr uint64_t const count = 100'000;
+	daw::blocked_bloom_filter<uint64_t> filter( count, 0.01 );
+	for( uint64_t n = 0; n < count; ++n ) {
+		filter.insert( n );
+	}
+	for( uint64_t n = 0; n < count; ++n ) {
+		daw::expecting( filter.may_contain( n ) );
+	}
+	auto const fpr = false_positive_rate( filter, count, count );
+	std::cout << "blocked_bloom_filter fpr: " << fpr << '\n';
+	daw::expecting( fpr < 0.02 );
+
+	std::vector<uint64_t> keys( 2 * count + 7 );
+	for( uint64_t n = 0; n < keys.size( ); ++n ) {
+		keys[n] = n;
+	}
+	auto results = std::make_unique<bool[]>( keys.size( ) );
+	auto const maybe_count = filter.may_contain(
+	  daw::span<uint64_t const>( keys.data( ), keys.size( ) ),
+	  daw::span<bool>( results.get( ), keys.size( ) ) );
+	size_t result_count = 0;
+	for( uint64_t n = 0; n < keys.size( ); ++n ) {
+		daw::expecting( filter.may_contain( n ), results[n] );
+		result_count += results[n] ? 1U : 0U;
+	}
+	daw::expecting( result_count, maybe_count );
+}
+
+template<typename Filter, typename View>
+void mapped_filter_test( Filter const &filter, std::string const &file_name,
+                         uint64_t count ) {
+	{
+		std::ofstream fs( file_name, std::ios::binary | std::ios::trunc );
+		filter.serialize( fs );
+	}
+	daw::filesystem::memory_mapped_file_t<char> mmf( file_name );
+	daw::expecting( filter.serialized_size( ), mmf.size( ) );
+	auto const view = View::from_bytes( mmf.data( ), mmf.size( ) );
+	daw::expecting( filter.item_count( ), view.item_count( ) );
+	for( uint64_t n = 0; n < 2 * count; ++n ) {
+		daw::expecting( filter.may_contain( n ), view.may_contain( n ) );
+	}
+	daw::expecting_exception<std::invalid_argument>(
+	  [&]( ) { return View::from_bytes( mmf.data( ), mmf.size( ) - 1 ); } );
+}
+
+void mapped_filters_001( ) {
+	constexpr uint64_t const count = 10'000;
+	daw::bloom_filter<uint64_t> bloom( count );
+	daw::blocked_bloom_filter<uint64_t> blocked( count );
+	for( uint64_t n = 0; n < count; ++n ) {
+		bloom.insert( n );
+		blocked.insert( n );
+	}
+	mapped_filter_test<daw::bloom_filter<uint64_t>,
+	                   daw::bloom_filter_view<uint64_t>>(
+	  bloom, "./bloom_filter.bin", count );
+	mapped_filter_test<daw::blocked_bloom_filter<uint64_t>,
+	                   daw::blocked_bloom_filter_view<uint64_t>>(
+	  blocked, "./blocked_bloom_filter.bin", count );
+	auto const view = bloom.view( );
+	daw::expecting( view.may_contain( 5 ) );
+	// The wrong filter type is rejected
+	daw::filesystem::memory_mapped_file_t<char> mmf( "./bloom_filter.bin" );
+	daw::expecting_exception<std::invalid_argument>( [&]( ) {
+		return daw::blocked_bloom_filter_view<uint64_t>::from_bytes(
+		  mmf.data( ), mmf.size( ) );
+	} );
+}
+
+void mapped_filters_002( ) {
+	// Headers that would index outside the data or never match are rejected
+	daw::bloom_filter<uint64_t> bloom( 1000 );
+	daw::blocked_bloom_filter<uint64_t> blocked( 1000 );
+	for( uint64_t n = 0; n < 1000; ++n ) {
+		bloom.insert( n );
+		blocked.insert( n );
+	}
+	auto const serialized = []( auto const &filter ) {
+		std::stringstream ss{};
+		filter.serialize( ss );
+		return ss.str( );
+	};
+	auto const bloom_bytes = serialized( bloom );
+	auto const blocked_bytes = serialized( blocked );
+	using header_t = daw::filter_impl::filter_header_t;
+
+	auto const check = [&]( auto view_type, std::string const &bytes,
+	                        size_t offset, auto value ) {
+		using View = typename decltype( view_type )::type;
+		auto patched = bytes;
+		patched.replace( offset, sizeof( value ),
+		                 reinterpret_cast<char const *>( &value ),
+		                 sizeof( value ) );
+		// Views need their words aligned
+		std::vector<daw::filter_impl::bloom_block_t> buff(
+		  ( patched.size( ) + 63U ) / 64U );
+		auto *const data = reinterpret_cast<char *>( buff.data( ) );
+		std::copy( patched.begin( ), patched.end( ), data );
+		daw::expecting_exception<std::invalid_argument>(
+		  [&]( ) { return View::from_bytes( data, patched.size( ) ); } );
+	};
+	auto const bloom_view =
+	  daw::traits::identity<daw::bloom_filter_view<uint64_t>>{};
+	auto const words = bloom.serialized_size( ) / 8U - sizeof( header_t ) / 8U;
+	check( bloom_view, bloom_bytes, offsetof( header_t, word_count ),
+	       uint64_t{0} );
+	check( bloom_view, bloom_bytes, offsetof( header_t, word_count ),
+	       uint64_t{words - 1U} );
+	check( bloom_view, bloom_bytes, offsetof( header_t, parameter ),
+	       uint32_t{0} );
+	check( bloom_view, bloom_bytes, offsetof( header_t, parameter ),
+	       uint32_t{31} );
+
+	auto const blocked_view =
+	  daw::traits::identity<daw::blocked_bloom_filter_view<uint64_t>>{};
+	check( blocked_view, blocked_bytes, offsetof( header_t, word_count ),
+	       uint64_t{0} );
+	check( blocked_view, blocked_bytes, offsetof( header_t, word_count ),
+	       uint64_t{std::numeric_limits<uint32_t>::max( )} + 1U );
+	// A different number of lanes per block is a different layout
+	check( blocked_view, blocked_bytes, offsetof( header_t, parameter ),
+	       uint32_t{4} );
+	check( blocked_view, blocked_bytes, offsetof( header_t, parameter ),
+	       uint32_t{16} );
+}
+
+void bloom_filter_bench( ) {
+	constexpr uint64_t const count = 1'000'000;
+	daw::bloom_filter<uint64_t> bloom( count );
+	daw::blocked_bloom_filter<uint64_t> blocked( count );
+	std::vector<uint64_t> keys( count );
+	for( uint64_t n = 0; n < count; ++n ) {
+		keys[n] = n * 2U;
+		bloom.insert( keys[n] );
+		blocked.insert( keys[n] );
+	}
+	for( auto &key : keys ) {
+		++key;
+	}
+	auto results = std::make_unique<bool[]>( keys.size( ) );
+	daw::bench_n_test<10>(
+	  "bloom_filter bulk negative lookups",
+	  [&]( ) {
+		  return bloom.may_contain(
+		    daw::span<uint64_t const>( keys.data( ), keys.size( ) ),
+		    daw::span<bool>( results.get( ), keys.size( ) ) );
+	  } );
+	daw::bench_n_test<10>(
+	  "blocked_bloom_filter bulk negative lookups",
+	  [&]( ) {
+		  return blocked.may_contain(
+		    daw::span<uint64_t const>( keys.data( ), keys.size( ) ),
+		    daw::span<bool>( results.get( ), keys.size( ) ) );
+	  } );
+}
+
+int main( ) {
+	bloom_filter_001( );
+	bloom_filter_002( );
+	blocked_bloom_filter_001( );
+	mapped_filters_001( );
+	mapped_filters_002( );
+	bloom_filter_bench( );
+}
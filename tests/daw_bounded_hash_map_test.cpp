@@ -80,4 +80,33 @@ test_const_002( daw::bounded_hash_map<daw::string_view, int, 100> &m,
 	return m[k];
 }
 
-int main( ) {}
+void test_find_many_001( ) {
+	daw::bounded_hash_map<uint16_t, daw::string_view, 13, daw::fnv1a_hash_t>
+	  hm = status_codes;
+	uint16_t const keys[] = {100, 404, 204, 226, 500, 101};
+	daw::string_view const *results[6] = {};
+	auto const count =
+	  hm.find_many( daw::span<uint16_t const>( keys ),
+	                daw::span<daw::string_view const *>( results ) );
+	daw::expecting( 4U, count );
+	daw::expecting( results[0] and *results[0] == "Continue" );
+	daw::expecting( results[1] == nullptr );
+	daw::expecting( results[2] and *results[2] == "No Content" );
+	daw::expecting( results[3] and *results[3] == "IM Used" );
+	daw::expecting( results[4] == nullptr );
+	daw::expecting( results[5] and *results[5] == "Switching Protocols" );
+}
+
+void test_stats_001( ) {
+	auto const stats = status_codes.stats( );
+	daw::expecting( 13U, stats.capacity );
+	daw::expecting( 13U, stats.size );
+	daw::expecting( 1.0, stats.load_factor( ) );
+	daw::expecting( stats.max_displacement + 1, stats.probe_lengths.size( ) );
+	daw::expecting( stats.average_probe_length( ) >= 1.0 );
+}
+
+int main( ) {
+	test_find_many_001( );
+	test_stats_001( );
+}
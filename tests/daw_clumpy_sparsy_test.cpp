@@ -20,16 +20,103 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "daw/daw_benchmark.h"
 #include "daw/daw_clumpy_sparsy.h"
 
 void clumpy_sparsy_test_001( ) {
-#warning Empty Test
-	/*	daw::clumpy_sparsy<int> t;
-	    auto b = t.begin( );
-	    b == b;*/
+	daw::clumpy_sparsy<int> t;
+	daw::expecting( t.empty( ) );
+	t[5] = 1;
+	t[1'000'000] = 2;
+	t.emplace( 6, 3 );
+	daw::expecting( 1'000'001U, t.size( ) );
+	daw::expecting( 3U, t.count( ) );
+	daw::expecting( t.contains( 6 ) );
+	daw::expecting( not t.contains( 7 ) );
+	daw::expecting( t.find( 7 ) == nullptr );
+	daw::expecting( 2, t.at( 1'000'000 ) );
+	daw::expecting_exception<std::out_of_range>( [&]( ) { t.at( 4 ); } );
+	daw::expecting( t.erase( 5 ) );
+	daw::expecting( not t.erase( 5 ) );
+	daw::expecting( 2U, t.count( ) );
+	daw::expecting( 2U, t.memory_usage( ).page_count );
+
+	// Pages added out of order are still visited in position order
+	t[3] = 4;
+	std::vector<size_t> positions{};
+	t.for_each( [&]( size_t pos, int ) { positions.push_back( pos ); } );
+	daw::expecting( positions == std::vector<size_t>{3, 6, 1'000'000} );
+}
+
+void clumpy_sparsy_test_002( ) {
+	daw::clumpy_sparsy<std::string> t;
+	std::vector<std::string> const values = {"a", "b", "c", "d"};
+	t.assign( 62, values.begin( ), values.end( ) );
+	t.assign( 1000, 100, "x" );
+	daw::expecting( 104U, t.count( ) );
+
+	std::vector<std::pair<size_t, size_t>> ranges{};
+	t.for_each_range( [&]( size_t first, std::string *, size_t count ) {
+		ranges.emplace_back( first, count );
+	} );
+	// Runs are split at page boundaries
+	std::vector<std::pair<size_t, size_t>> const expected_ranges = {
+	  {62, 2}, {64, 2}, {1000, 24}, {1024, 64}, {1088, 12}};
+	daw::expecting( ranges == expected_ranges );
+
+	std::string joined{};
+	t.for_each( [&]( size_t pos, std::string const &s ) {
+		if( pos < 1000 ) {
+			joined += s;
+		}
+	} );
+	daw::expecting( "abcd", joined );
+
+	auto copy = t;
+	daw::expecting( 50U, t.erase( 1000, 1050 ) );
+	daw::expecting( 54U, t.count( ) );
+	daw::expecting( 104U, copy.count( ) );
+	daw::expecting( "x", copy.at( 1001 ) );
+	auto moved = std::move( copy );
+	daw::expecting( "c", moved.at( 64 ) );
+	daw::expecting( copy.empty( ) );
+}
+
+void clumpy_sparsy_bench_001( ) {
+	size_t const clumps = 100'000;
+	daw::clumpy_sparsy<double> t;
+	auto const t_fill = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < clumps; ++n ) {
+			t.assign( n * 10'000, 16, 1.0 );
+		}
+	} );
+	double sum = 0.0;
+	auto const t_lookup = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < clumps; ++n ) {
+			auto const pos = ( ( n * 7919U ) % clumps ) * 10'000 + 3;
+			if( auto value = t.find( pos ); value != nullptr ) {
+				sum += *value;
+			}
+		}
+	} );
+	daw::expecting( static_cast<double>( clumps ), sum );
+	auto const mem = t.memory_usage( );
+	std::cout << "fill " << clumps << " clumps: "
+	          << daw::utility::format_seconds( t_fill, 2 ) << '\n';
+	std::cout << "random lookups: "
+	          << daw::utility::format_seconds( t_lookup, 2 ) << '\n';
+	std::cout << "memory: " << mem.total_bytes( ) << " bytes, occupancy "
+	          << mem.occupancy( ) << '\n';
 }
 
 int main( ) {
 	clumpy_sparsy_test_001( );
+	clumpy_sparsy_test_002( );
+	clumpy_sparsy_bench_001( );
 }
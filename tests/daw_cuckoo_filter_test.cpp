@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/daw_cuckoo_filter.h"
+#include "daw/daw_memory_mapped_file.h"
+
+void cuckoo_filter_001( ) {
+	constexpr uint64_t const count = 100'000;
+	daw::cuckoo_filter<uint64_t> filter( count );
+	for( uint64_t n = 0; n < count; ++n ) {
+		daw::expecting( filter.insert( n ) );
+	}
+	daw::expecting( count, filter.item_count( ) );
+	for( uint64_t n = 0; n < count; ++n ) {
+		daw::expecting( filter.may_contain( n ) );
+	}
+	size_t false_positives = 0;
+	for( uint64_t n = count; n < 2 * count; ++n ) {
+		false_positives += filter.may_contain( n ) ? 1U : 0U;
+	}
+	auto const fpr =
+	  static_cast<double>( false_positives ) / static_cast<double>( count );
+	std::cout << "cuckoo_filter fpr: " << fpr << " load: " << filter.load_factor( )
+	          << '\n';
+	daw::expecting( fpr < 0.001 );
+
+	for( uint64_t n = 0; n < count; n += 2 ) {
+		daw::expecting( filter.erase( n ) );
+	}
+	for( uint64_t n = 1; n < count; n += 2 ) {
+		daw::expecting( filter.may_contain( n ) );
+	}
+	daw::expecting( count / 2, filter.item_count( ) );
+}
+
+void cuckoo_filter_002( ) {
+	// A full filter rejects inserts and keeps every key already in it
+	daw::cuckoo_filter<uint64_t, daw::filter_impl::fnv1a_key_hash, uint8_t>
+	  filter( 64 );
+	uint64_t inserted = 0;
+	while( filter.insert( inserted ) ) {
+		++inserted;
+	}
+	daw::expecting( inserted <= filter.capacity( ) );
+	daw::expecting( inserted, filter.item_count( ) );
+	for( uint64_t n = 0; n < inserted; ++n ) {
+		daw::expecting( filter.may_contain( n ) );
+	}
+}
+
+void cuckoo_filter_003( ) {
+	constexpr uint64_t const count = 10'000;
+	daw::cuckoo_filter<uint64_t> filter( count );
+	for( uint64_t n = 0; n < count; ++n ) {
+		filter.insert( n );
+	}
+	{
+		std::ofstream fs( "./cuckoo_filter.bin",
+		                  std::ios::binary | std::ios::trunc );
+		filter.serialize( fs );
+	}
+	daw::filesystem::memory_mapped_file_t<char> mmf( "./cuckoo_filter.bin" );
+	daw::expecting( filter.serialized_size( ), mmf.size( ) );
+	auto const view =
+	  daw::cuckoo_filter_view<uint64_t>::from_bytes( mmf.data( ), mmf.size( ) );
+
+	std::vector<uint64_t> keys( 2 * count );
+	for( uint64_t n = 0; n < keys.size( ); ++n ) {
+		keys[n] = n;
+	}
+	auto results = std::make_unique<bool[]>( keys.size( ) );
+	auto const maybe_count =
+	  view.may_contain( daw::span<uint64_t const>( keys.data( ), keys.size( ) ),
+	                    daw::span<bool>( results.get( ), keys.size( ) ) );
+	daw::expecting( maybe_count >= count );
+	for( uint64_t n = 0; n < keys.size( ); ++n ) {
+		daw::expecting( filter.may_contain( n ), results[n] );
+	}
+	daw::expecting_exception<std::invalid_argument>( [&]( ) {
+		return daw::cuckoo_filter_view<uint64_t, daw::filter_impl::fnv1a_key_hash,
+		                               uint8_t>::from_bytes( mmf.data( ),
+		                                                     mmf.size( ) );
+	} );
+}
+
+int main( ) {
+	cuckoo_filter_001( );
+	cuckoo_filter_002( );
+	cuckoo_filter_003( );
+}
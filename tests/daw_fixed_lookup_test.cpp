@@ -23,6 +23,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <vector>
 
 #include "daw/daw_benchmark.h"
 #include "daw/daw_fixed_lookup.h"
@@ -38,6 +39,43 @@ void daw_fixed_lookup_001( ) {
 	std::cout << blah['a'] << " " << blah["hello"] << '\n';
 }
 
+void daw_fixed_lookup_find_many_001( ) {
+	daw::fixed_lookup<int, 100> blah{};
+	for( int n = 0; n < 40; ++n ) {
+		blah[n] = n * 10;
+	}
+	std::vector<int> keys{};
+	for( int n = 0; n < 80; n += 2 ) {
+		keys.push_back( n );
+	}
+	std::vector<int const *> results( keys.size( ) );
+	auto const count = blah.find_many( daw::span<int const>( keys ),
+	                                   daw::span<int const *>( results ) );
+	daw::expecting( 20U, count );
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		if( keys[n] < 40 ) {
+			daw::expecting( results[n] != nullptr );
+			daw::expecting( keys[n] * 10, *results[n] );
+		} else {
+			daw::expecting( results[n] == nullptr );
+		}
+	}
+}
+
+void daw_fixed_lookup_stats_001( ) {
+	daw::fixed_lookup<int, 100> blah{};
+	for( int n = 0; n < 50; ++n ) {
+		blah[n] = n;
+	}
+	auto const stats = blah.stats( );
+	daw::expecting( 100U, stats.capacity );
+	daw::expecting( 50U, stats.size );
+	daw::expecting( 0U, stats.tombstones );
+	daw::expecting( stats.max_displacement + 1, stats.probe_lengths.size( ) );
+	daw::expecting( 0.5, stats.load_factor( ) );
+	daw::expecting( 0U, stats.resize_count );
+}
+
 constexpr auto get_map( ) {
 	daw::fixed_lookup<int, 10> blah{};
 	blah['a'] = 1;
@@ -144,5 +182,7 @@ void daw_fixed_lookup_bench_001( ) {
 
 int main( ) {
 	daw_fixed_lookup_001( );
+	daw_fixed_lookup_find_many_001( );
+	daw_fixed_lookup_stats_001( );
 	daw_fixed_lookup_bench_001( );
 }
@@ -21,6 +21,7 @@
 // SOFTWARE.
 
 #include <iostream>
+#include <string>
 
 #include "daw/daw_benchmark.h"
 #include "daw/daw_fnv1a_hash.h"
@@ -45,7 +46,86 @@ void test_003( ) {
 	}
 }
 
+void test_004( ) {
+	size_t count = 100'000ULL;
+	daw::hash_set_t<size_t> adapt;
+	for( size_t n = 0; n < count; ++n ) {
+		daw::expecting( adapt.insert( n ) );
+	}
+	daw::expecting( !adapt.insert( 5 ) );
+	daw::expecting( count, adapt.size( ) );
+	daw::expecting( adapt.capacity( ) >= count );
+	for( size_t n = 0; n < count; ++n ) {
+		daw::expecting( adapt.exists( n ) );
+	}
+	daw::expecting( !adapt.exists( count ) );
+}
+
+void test_005( ) {
+	size_t count = 10'000ULL;
+	daw::hash_set_t<size_t> adapt;
+	for( size_t n = 0; n < count; ++n ) {
+		adapt.insert( n );
+	}
+	for( size_t n = 0; n < count; n += 2 ) {
+		daw::expecting( adapt.erase( n ) );
+	}
+	daw::expecting( !adapt.erase( 0 ) );
+	daw::expecting( count / 2, adapt.size( ) );
+	for( size_t n = 0; n < count; ++n ) {
+		daw::expecting( ( n % 2 ) == 1, adapt.exists( n ) );
+	}
+	// Reinserting after erase must not grow the table as there are no
+	// tombstones left behind
+	auto const cap = adapt.capacity( );
+	for( size_t n = 0; n < count; n += 2 ) {
+		adapt.insert( n );
+		adapt.erase( n );
+	}
+	daw::expecting( cap, adapt.capacity( ) );
+}
+
+void test_006( ) {
+	size_t count = 1024ULL;
+	daw::hash_set_t<size_t> adapt( 0, 0.5f );
+	adapt.reserve( count );
+	auto const cap = adapt.capacity( );
+	daw::expecting( cap >= count * 2 );
+	for( size_t n = 0; n < count; ++n ) {
+		adapt.insert( n * 4096ULL );
+	}
+	daw::expecting( cap, adapt.capacity( ) );
+	daw::expecting( !adapt.is_rehashing( ) );
+	size_t sum = 0;
+	adapt.for_each( [&sum]( size_t v ) { sum += v / 4096ULL; } );
+	daw::expecting( ( count * ( count - 1 ) ) / 2, sum );
+}
+
+void test_007( ) {
+	// Erase while a migration is in progress
+	daw::hash_set_t<std::string> adapt;
+	adapt.reserve( 96 );
+	daw::expecting( 128U, adapt.capacity( ) );
+	for( size_t n = 0; n <= 96; ++n ) {
+		adapt.insert( std::to_string( n ) );
+	}
+	daw::expecting( adapt.is_rehashing( ) );
+	for( size_t n = 0; n <= 96; n += 3 ) {
+		daw::expecting( adapt.erase( std::to_string( n ) ) );
+	}
+	auto copy = adapt;
+	for( size_t n = 0; n <= 96; ++n ) {
+		daw::expecting( ( n % 3 ) != 0, adapt.exists( std::to_string( n ) ) );
+		daw::expecting( ( n % 3 ) != 0, copy.exists( std::to_string( n ) ) );
+	}
+	daw::expecting( 64U, adapt.size( ) );
+}
+
 int main( ) {
 	test_001( );
 	test_003( );
+	test_004( );
+	test_005( );
+	test_006( );
+	test_007( );
 }
@@ -20,10 +20,16 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#define DAW_HASH_STATS
+
+#include <algorithm>
 #include <boost/unordered_map.hpp>
+#include <chrono>
 #include <cstdint>
 #include <iostream>
+#include <random>
 #include <string>
+#include <vector>
 
 #include "daw/boost_test.h"
 #include "daw/daw_benchmark.h"
@@ -51,6 +57,181 @@ BOOST_AUTO_TEST_CASE( daw_hash_table_testing ) {
 	          << testing2["hello"].b << std::endl;
 }
 
+BOOST_AUTO_TEST_CASE( daw_hash_table_find_many ) {
+	daw::hash_table<size_t> table;
+	std::vector<size_t> keys{};
+	for( size_t n = 0; n < 1000; ++n ) {
+		table[n] = n * 2;
+		keys.push_back( n * 2 );
+	}
+	std::vector<size_t const *> results( keys.size( ) );
+	auto const count = table.find_many( daw::span<size_t const>( keys ),
+	                                    daw::span<size_t const *>( results ) );
+	BOOST_REQUIRE_EQUAL( count, 500U );
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		if( keys[n] < 1000 ) {
+			BOOST_REQUIRE( results[n] != nullptr );
+			BOOST_REQUIRE_EQUAL( *results[n], keys[n] * 2 );
+			BOOST_REQUIRE_EQUAL( *results[n], table[keys[n]] );
+		} else {
+			BOOST_REQUIRE( results[n] == nullptr );
+			BOOST_REQUIRE( !table.exists( keys[n] ) );
+		}
+	}
+}
+
+// Probe a table far larger than the cache one key at a time and then in
+// prefetched batches
+BOOST_AUTO_TEST_CASE( daw_hash_table_find_many_perf ) {
+	constexpr size_t const item_count = 4'000'000;
+	constexpr size_t const probe_count = 4'000'000;
+	daw::hash_table<size_t> table( item_count * 2 );
+	for( size_t n = 0; n < item_count; ++n ) {
+		table[n] = n;
+	}
+	std::mt19937_64 rng( 0 );
+	std::uniform_int_distribution<size_t> dist( 0, item_count * 2 );
+	std::vector<size_t> keys( probe_count );
+	for( auto &k : keys ) {
+		k = dist( rng );
+	}
+	auto const &ctable = table;
+	std::vector<size_t const *> results( probe_count );
+	size_t sum1 = 0;
+	auto const single = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < keys.size( ); ++n ) {
+			ctable.find_many( daw::span<size_t const>( &keys[n], 1 ),
+			                  daw::span<size_t const *>( &results[n], 1 ) );
+			if( results[n] ) {
+				sum1 += *results[n];
+			}
+		}
+	} );
+	size_t sum2 = 0;
+	auto const batched = daw::benchmark( [&]( ) {
+		ctable.find_many( daw::span<size_t const>( keys ),
+		                  daw::span<size_t const *>( results ) );
+		for( auto p : results ) {
+			if( p ) {
+				sum2 += *p;
+			}
+		}
+	} );
+	BOOST_REQUIRE_EQUAL( sum1, sum2 );
+	std::cout << "hash_table lookup of " << probe_count << " keys\n";
+	std::cout << "-->one at a time " << ( single * 1'000'000'000.0 ) / probe_count
+	          << " ns each\n";
+	std::cout << "-->find_many " << ( batched * 1'000'000'000.0 ) / probe_count
+	          << " ns each\n";
+}
+
+using incremental_table_t =
+  daw::hash_table<size_t, 11, 80, daw::resize_policies::golden_ratio,
+                  daw::rehash_modes::incremental<>>;
+
+BOOST_AUTO_TEST_CASE( daw_hash_table_incremental_001 ) {
+	incremental_table_t table;
+	auto const &ctable = table;
+	bool saw_rehash = false;
+	for( size_t n = 0; n < 100'000; ++n ) {
+		table[n] = n + 1;
+		saw_rehash = saw_rehash or table.is_rehashing( );
+		if( n % 997 == 0 ) {
+			for( size_t m = 0; m <= n; m += 101 ) {
+				BOOST_REQUIRE_EQUAL( ctable[m], m + 1 );
+			}
+			BOOST_REQUIRE( !ctable.exists( n + 1 ) );
+		}
+	}
+	BOOST_REQUIRE( saw_rehash );
+	std::vector<size_t> keys( 100'000 );
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		keys[n] = n;
+	}
+	std::vector<size_t const *> results( keys.size( ) );
+	BOOST_REQUIRE_EQUAL( ctable.find_many( daw::span<size_t const>( keys ),
+	                                       daw::span<size_t const *>( results ) ),
+	                     keys.size( ) );
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		BOOST_REQUIRE_EQUAL( *results[n], n + 1 );
+	}
+	// Updating a key that has not been migrated yet must not duplicate it
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		table[n] += 1;
+	}
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		BOOST_REQUIRE_EQUAL( ctable[n], n + 2 );
+	}
+	table.shrink_to_fit( );
+	BOOST_REQUIRE( !table.is_rehashing( ) );
+	BOOST_REQUIRE_EQUAL( ctable[size_t{99'999}], size_t{100'001} );
+}
+
+BOOST_AUTO_TEST_CASE( daw_hash_table_stats ) {
+	daw::hash_table<size_t> table;
+	for( size_t n = 0; n < 10'000; ++n ) {
+		table[n] = n;
+	}
+	auto const stats = table.stats( );
+	BOOST_REQUIRE_EQUAL( stats.size, 10'000U );
+	BOOST_REQUIRE( stats.resize_count > 0 );
+	BOOST_REQUIRE( stats.resize_time.count( ) > 0 );
+	BOOST_REQUIRE_EQUAL( stats.tombstones, 0U );
+	BOOST_REQUIRE_EQUAL( stats.probe_lengths.size( ),
+	                     stats.max_displacement + 1 );
+	size_t total = 0;
+	for( auto c : stats.probe_lengths ) {
+		total += c;
+	}
+	BOOST_REQUIRE_EQUAL( total, stats.size );
+	BOOST_REQUIRE( stats.load_factor( ) > 0.0 and stats.load_factor( ) <= 1.0 );
+	BOOST_REQUIRE( stats.average_probe_length( ) >= 1.0 );
+
+	// Part way through an incremental resize the old arrays hold tombstones
+	incremental_table_t table2;
+	size_t n = 0;
+	while( n < 1000 or !table2.is_rehashing( ) ) {
+		table2[n++] = 0;
+	}
+	table2[n++] = 0;
+	auto const stats2 = table2.stats( );
+	BOOST_REQUIRE_EQUAL( stats2.size, n );
+	BOOST_REQUIRE( stats2.tombstones > 0 );
+	BOOST_REQUIRE( stats2.resize_count > 1 );
+	std::cout << "hash_table stats: load " << stats.load_factor( )
+	          << " average probe " << stats.average_probe_length( )
+	          << " max displacement " << stats.max_displacement << " resizes "
+	          << stats.resize_count << " in " << stats.resize_time.count( )
+	          << "ns\n";
+}
+
+template<typename HashTable>
+void insert_latency( char const *title, size_t count ) {
+	HashTable table;
+	std::vector<std::chrono::nanoseconds> times( count );
+	for( size_t n = 0; n < count; ++n ) {
+		auto const start = std::chrono::steady_clock::now( );
+		table[n] = n;
+		times[n] = std::chrono::steady_clock::now( ) - start;
+	}
+	std::sort( times.begin( ), times.end( ) );
+	auto const pct = [&]( double p ) {
+		return times[static_cast<size_t>( p * static_cast<double>( count - 1 ) )]
+		  .count( );
+	};
+	std::cout << title << " insert latency over " << count << " inserts\n";
+	std::cout << "-->p50 " << pct( 0.5 ) << "ns p99 " << pct( 0.99 )
+	          << "ns p999 " << pct( 0.999 ) << "ns max " << times.back( ).count( )
+	          << "ns\n";
+}
+
+// Inserts into a growing table.  All at once shows the full rehash cost in the
+// tail, incremental spreads it across the inserts that follow a resize
+BOOST_AUTO_TEST_CASE( daw_hash_table_insert_latency ) {
+	insert_latency<daw::hash_table<size_t>>( "all_at_once", 1'000'000 );
+	insert_latency<incremental_table_t>( "incremental", 1'000'000 );
+}
+
 /*
 auto integerKeys( size_t count = 10000 ) {
     std::mt19937_64 rd( 0 );
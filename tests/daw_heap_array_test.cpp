@@ -20,6 +20,11 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "daw/daw_aligned_allocator.h"
 #include "daw/daw_benchmark.h"
 #include "daw/daw_heap_array.h"
 
@@ -33,6 +38,70 @@ void daw_heap_array_testing( ) {
 	daw::expecting( 4, *pos );
 }
 
+void daw_heap_array_fill_001( ) {
+	daw::heap_array<std::string> t( 5, "hello" );
+	daw::expecting( 5U, t.size( ) );
+	daw::expecting( "hello", t[4] );
+	auto t2 = t;
+	daw::expecting( "hello", t2[0] );
+	t2 = {"a", "b"};
+	daw::expecting( 2U, t2.size( ) );
+	daw::expecting( "b", t2[1] );
+}
+
+void daw_heap_array_default_init_001( ) {
+	daw::heap_array<std::string> t( 5, daw::default_init );
+	daw::expecting( t[0].empty( ) );
+
+	daw::heap_array<int> t2( 100, daw::uninitialized );
+	for( size_t n = 0; n < t2.size( ); ++n ) {
+		t2[n] = static_cast<int>( n );
+	}
+	daw::expecting( 99, t2[99] );
+	daw::expecting( 50, *t2.find_first_of( 50 ) );
+}
+
+void daw_heap_array_aligned_001( ) {
+	daw::heap_array<char, daw::aligned_allocator<char, 64>> t( 10, 'a' );
+	daw::expecting( 0U, reinterpret_cast<uintptr_t>( t.data( ) ) % 64U );
+
+	daw::heap_array<char, daw::huge_page_allocator<char>> t2(
+	  3U * daw::huge_page_size, daw::uninitialized );
+	daw::expecting( 0U, reinterpret_cast<uintptr_t>( t2.data( ) ) %
+	                      daw::huge_page_size );
+	t2[t2.size( ) - 1] = 'b';
+	daw::expecting( 'b', t2[t2.size( ) - 1] );
+}
+
+void daw_heap_array_bench_001( ) {
+	size_t const count = 64U * 1024U * 1024U;
+	auto const t_value = daw::benchmark( [&]( ) {
+		daw::heap_array<uint8_t> t( count, uint8_t{1} );
+		daw::do_not_optimize( t.data( ) );
+	} );
+	auto const t_uninit = daw::benchmark( [&]( ) {
+		daw::heap_array<uint8_t> t( count, daw::uninitialized );
+		std::fill( t.begin( ), t.end( ), uint8_t{1} );
+		daw::do_not_optimize( t.data( ) );
+	} );
+	auto const t_huge = daw::benchmark( [&]( ) {
+		daw::heap_array<uint8_t, daw::huge_page_allocator<uint8_t>> t(
+		  count, daw::uninitialized );
+		std::fill( t.begin( ), t.end( ), uint8_t{1} );
+		daw::do_not_optimize( t.data( ) );
+	} );
+	std::cout << "64MiB fill constructed: "
+	          << daw::utility::format_seconds( t_value, 2 ) << '\n';
+	std::cout << "64MiB uninitialized then filled: "
+	          << daw::utility::format_seconds( t_uninit, 2 ) << '\n';
+	std::cout << "64MiB huge pages then filled: "
+	          << daw::utility::format_seconds( t_huge, 2 ) << '\n';
+}
+
 int main( ) {
 	daw_heap_array_testing( );
+	daw_heap_array_fill_001( );
+	daw_heap_array_default_init_001( );
+	daw_heap_array_aligned_001( );
+	daw_heap_array_bench_001( );
 }
@@ -20,10 +20,12 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <string>
+
 #include "daw/daw_benchmark.h"
 #include "daw/daw_ordered_map.h"
 
-int main( ) {
+void ordered_map_001( ) {
 	daw::ordered_map<std::string, int> dict{};
 
 	dict.insert( {"hello", 5} );
@@ -32,3 +34,64 @@ int main( ) {
 	daw::expecting( dict.size( ), 1U );
 	daw::expecting( dict.front( ), dict.back( ) );
 }
+
+void ordered_map_002( ) {
+	daw::ordered_map<std::string, size_t> dict{};
+	constexpr size_t const count = 20'000;
+	for( size_t n = 0; n < count; ++n ) {
+		dict[std::to_string( n )] = n;
+	}
+	daw::expecting( dict.is_indexed( ) );
+	daw::expecting( count, dict.size( ) );
+	daw::expecting( !dict.insert( {"42", 0} ).second );
+	for( size_t n = 0; n < count; ++n ) {
+		daw::expecting( n, dict.at( std::to_string( n ) ) );
+	}
+	daw::expecting( dict.find( "nothere" ) == dict.end( ) );
+
+	// Insertion order is kept
+	size_t expected = 0;
+	for( auto const &item : dict ) {
+		daw::expecting( expected++, item.second );
+	}
+
+	// Index stays consistent when positions move on erase
+	for( size_t n = 0; n < count; n += 3 ) {
+		daw::expecting( 1U, dict.erase( std::to_string( n ) ) );
+	}
+	daw::expecting( 0U, dict.erase( "0" ) );
+	for( size_t n = 0; n < count; ++n ) {
+		auto pos = dict.find( std::to_string( n ) );
+		if( n % 3 == 0 ) {
+			daw::expecting( pos == dict.end( ) );
+		} else {
+			daw::expecting( pos != dict.end( ) );
+			daw::expecting( n, pos->second );
+		}
+	}
+	dict.erase( dict.begin( ) );
+	daw::expecting( dict.find( "1" ) == dict.end( ) );
+	daw::expecting( 2U, dict.begin( )->second );
+}
+
+void ordered_map_003( ) {
+	// Keys without a std::hash specialization stay on linear searching
+	struct unhashable_t {
+		int value;
+		bool operator<( unhashable_t const &rhs ) const {
+			return value < rhs.value;
+		}
+	};
+	daw::ordered_map<unhashable_t, int> dict{};
+	for( int n = 0; n < 100; ++n ) {
+		dict[unhashable_t{n}] = n;
+	}
+	daw::expecting( !dict.is_indexed( ) );
+	daw::expecting( 42, dict.at( unhashable_t{42} ) );
+}
+
+int main( ) {
+	ordered_map_001( );
+	ordered_map_002( );
+	ordered_map_003( );
+}
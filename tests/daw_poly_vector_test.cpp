@@ -20,6 +20,10 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <iostream>
+#include <memory>
+#include <vector>
+
 #include "daw/daw_benchmark.h"
 #include "daw/daw_poly_vector.h"
 
@@ -50,6 +54,154 @@ void daw_poly_vector_01( ) {
 	test.push_back( B{} );
 }
 
+namespace poly_collection_test {
+	struct shape {
+		shape( ) = default;
+		shape( shape const & ) = default;
+		shape( shape && ) = default;
+		shape &operator=( shape const & ) = default;
+		shape &operator=( shape && ) = default;
+		virtual ~shape( );
+		virtual int area( ) const = 0;
+	};
+	shape::~shape( ) {}
+
+	struct square final : shape {
+		int side = 0;
+		explicit square( int s )
+		  : side( s ) {}
+		int area( ) const override {
+			return side * side;
+		}
+	};
+
+	struct rect : shape {
+		int width = 0;
+		int height = 0;
+		rect( int w, int h )
+		  : width( w )
+		  , height( h ) {}
+		int area( ) const override {
+			return width * height;
+		}
+	};
+
+	struct tall_rect : rect {
+		using rect::rect;
+	};
+
+	struct boxed_square final : shape {
+		std::unique_ptr<int> side;
+		explicit boxed_square( int s )
+		  : side( std::make_unique<int>( s ) ) {}
+		int area( ) const override {
+			return *side * *side;
+		}
+	};
+} // namespace poly_collection_test
+
+void daw_poly_collection_01( ) {
+	using namespace poly_collection_test;
+	daw::poly_collection<shape> shapes;
+	shapes.insert( square( 2 ) );
+	shapes.emplace<rect>( 2, 3 );
+	shapes.insert( square( 3 ) );
+	std::vector<rect> rects( 10, rect( 1, 1 ) );
+	shapes.insert( rects.begin( ), rects.end( ) );
+	daw::expecting( 13U, shapes.size( ) );
+	daw::expecting( 2U, shapes.size<square>( ) );
+	daw::expecting( 2U, shapes.segment_count( ) );
+
+	int total = 0;
+	shapes.for_each( [&]( shape const &s ) { total += s.area( ); } );
+	daw::expecting( 4 + 6 + 9 + 10, total );
+
+	int squares = 0;
+	shapes.for_each<square>( [&]( square &s ) { squares += s.side; } );
+	daw::expecting( 5, squares );
+
+	auto copy = shapes;
+	daw::expecting( 10U, copy.erase_if<rect>(
+	                       []( rect const &r ) { return r.area( ) == 1; } ) );
+	daw::expecting( 3U, copy.size( ) );
+	daw::expecting( 13U, shapes.size( ) );
+	daw::expecting( 1U, copy.erase_if( []( shape const &s ) {
+		return s.area( ) == 4;
+	} ) );
+	auto first = shapes.begin<rect>( );
+	auto pos = shapes.erase<rect>( first + 1, first + 6 );
+	daw::expecting( 6U, shapes.size<rect>( ) );
+	daw::expecting( 1, pos->area( ) );
+
+	daw::expecting_exception<std::invalid_argument>( [&]( ) {
+		tall_rect t( 1, 2 );
+		rect const &r = t;
+		shapes.insert( r );
+	} );
+}
+
+// Move only types can be stored, only copying the collection needs them to
+// be copyable
+void daw_poly_collection_02( ) {
+	using namespace poly_collection_test;
+	daw::poly_collection<shape> shapes;
+	shapes.insert( boxed_square( 2 ) );
+	shapes.emplace<boxed_square>( 3 );
+	shapes.insert( square( 1 ) );
+	int total = 0;
+	shapes.for_each( [&]( shape const &s ) { total += s.area( ); } );
+	daw::expecting( 4 + 9 + 1, total );
+	daw::expecting( 1U, shapes.erase_if<boxed_square>(
+	                      []( boxed_square const &b ) { return *b.side == 2; } ) );
+	auto moved = std::move( shapes );
+	daw::expecting( 2U, moved.size( ) );
+	daw::expecting_exception<std::invalid_argument>(
+	  [&]( ) { auto copy = moved; } );
+}
+
+void daw_poly_collection_bench_01( ) {
+	using namespace poly_collection_test;
+	size_t const count = 1'000'000;
+	daw::poly_collection<shape> shapes;
+	std::vector<std::unique_ptr<shape>> ptrs;
+	for( size_t n = 0; n < count; ++n ) {
+		auto const v = static_cast<int>( n % 7 );
+		if( n % 2 == 0 ) {
+			shapes.insert( square( v ) );
+			ptrs.push_back( std::make_unique<square>( v ) );
+		} else {
+			shapes.insert( rect( v, 2 ) );
+			ptrs.push_back( std::make_unique<rect>( v, 2 ) );
+		}
+	}
+	long long sum_ptrs = 0;
+	auto const t_ptrs = daw::benchmark( [&]( ) {
+		for( auto const &p : ptrs ) {
+			sum_ptrs += p->area( );
+		}
+	} );
+	long long sum_all = 0;
+	auto const t_all = daw::benchmark( [&]( ) {
+		shapes.for_each( [&]( shape const &s ) { sum_all += s.area( ); } );
+	} );
+	long long sum_typed = 0;
+	auto const t_typed = daw::benchmark( [&]( ) {
+		shapes.for_each<square, rect>(
+		  [&]( auto const &s ) { sum_typed += s.area( ); } );
+	} );
+	daw::expecting( sum_ptrs, sum_all );
+	daw::expecting( sum_ptrs, sum_typed );
+	std::cout << "vector<unique_ptr<shape>>: "
+	          << daw::utility::format_seconds( t_ptrs, 2 ) << '\n';
+	std::cout << "poly_collection: "
+	          << daw::utility::format_seconds( t_all, 2 ) << '\n';
+	std::cout << "poly_collection, by type: "
+	          << daw::utility::format_seconds( t_typed, 2 ) << '\n';
+}
+
 int main( ) {
 	daw_poly_vector_01( );
+	daw_poly_collection_01( );
+	daw_poly_collection_02( );
+	daw_poly_collection_bench_01( );
 }
@@ -0,0 +1,194 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/daw_small_vector.h"
+#include "daw/daw_swap.h"
+
+void daw_small_vector_test_001( ) {
+	daw::small_vector<int, 4> a{};
+	a.push_back( 1 );
+	a.push_back( 2 );
+	a.push_back( 4 );
+	a.push_back( 8 );
+	daw::expecting( a.is_inline( ) );
+	daw::expecting( a.full( ) );
+	a.push_back( 16 );
+	a.emplace_back( 5 );
+	daw::expecting( not a.is_inline( ) );
+	int sum = 0;
+	for( auto c : a ) {
+		sum += c;
+	}
+	daw::expecting( 36, sum );
+	daw::expecting( 5, a.pop_back( ) );
+	daw::expecting( 1, a.pop_front( ) );
+	daw::expecting( 4U, a.size( ) );
+	a.shrink_to_fit( );
+	daw::expecting( a.is_inline( ) );
+	daw::expecting( 16, a.back( ) );
+	daw::expecting_exception<std::out_of_range>( [&]( ) { a.at( 4 ); } );
+}
+
+void daw_small_vector_test_002( ) {
+	using vec_t = daw::small_vector<std::string, 2>;
+	vec_t a{};
+	for( int n = 0; n < 100; ++n ) {
+		a.push_back( std::to_string( n ) + " is a long enough string to allocate" );
+	}
+	// Self referencing growth
+	a.push_back( a[0] );
+	daw::expecting( a[0], a.back( ) );
+	vec_t b = a;
+	daw::expecting( a == b );
+	vec_t c = std::move( a );
+	daw::expecting( b == c );
+	daw::expecting( a.empty( ) );
+
+	vec_t d{"a", "b"};
+	vec_t e = std::move( d );
+	daw::expecting( e.is_inline( ) );
+	daw::expecting( "b", e[1] );
+	daw::cswap( c, e );
+	daw::expecting( 2U, c.size( ) );
+	daw::expecting( 101U, e.size( ) );
+
+	auto pos = e.erase( e.begin( ) + 1, e.begin( ) + 51 );
+	daw::expecting( 51U, e.size( ) );
+	daw::expecting( "51 is a long enough string to allocate", *pos );
+	e.resize( 3, "x" );
+	daw::expecting( 3U, e.size( ) );
+	e.resize( 5, "x" );
+	daw::expecting( "x", e[4] );
+	e.assign( 2, "y" );
+	daw::expecting( "y", e[1] );
+}
+
+void daw_small_vector_test_003( ) {
+	static_assert( daw::is_trivially_relocatable_v<std::unique_ptr<int>> );
+	daw::small_vector<std::unique_ptr<int>, 2> a{};
+	for( int n = 0; n < 10; ++n ) {
+		a.emplace_back( std::make_unique<int>( n ) );
+	}
+	daw::expecting( 9, *a.back( ) );
+	auto b = std::move( a );
+	daw::expecting( 0, *b.front( ) );
+	b.erase( b.begin( ) );
+	daw::expecting( 1, *b.front( ) );
+}
+
+namespace {
+	// A stateful allocator that stays with its container on move assignment
+	template<typename T>
+	struct tagged_allocator_t {
+		using value_type = T;
+		using propagate_on_container_move_assignment = std::false_type;
+		using is_always_equal = std::false_type;
+
+		int tag = 0;
+
+		tagged_allocator_t( ) = default;
+		explicit tagged_allocator_t( int t ) noexcept
+		  : tag( t ) {}
+
+		template<typename U>
+		tagged_allocator_t( tagged_allocator_t<U> const &other ) noexcept
+		  : tag( other.tag ) {}
+
+		T *allocate( size_t count ) {
+			return std::allocator<T>( ).allocate( count );
+		}
+
+		void deallocate( T *ptr, size_t count ) noexcept {
+			std::allocator<T>( ).deallocate( ptr, count );
+		}
+
+		template<typename U>
+		bool operator==( tagged_allocator_t<U> const &rhs ) const noexcept {
+			return tag == rhs.tag;
+		}
+
+		template<typename U>
+		bool operator!=( tagged_allocator_t<U> const &rhs ) const noexcept {
+			return tag != rhs.tag;
+		}
+	};
+} // namespace
+
+// Move assignment between unequal allocators has to allocate, so it cannot
+// be noexcept
+void daw_small_vector_test_004( ) {
+	using vec_t = daw::small_vector<int, 2, tagged_allocator_t<int>>;
+	static_assert( not std::is_nothrow_move_assignable_v<vec_t> );
+	static_assert( std::is_nothrow_move_assignable_v<daw::small_vector<int, 2>> );
+	vec_t a( tagged_allocator_t<int>( 1 ) );
+	vec_t b( tagged_allocator_t<int>( 2 ) );
+	for( int n = 0; n < 10; ++n ) {
+		a.push_back( n );
+	}
+	b = std::move( a );
+	daw::expecting( 2, b.get_allocator( ).tag );
+	daw::expecting( 10U, b.size( ) );
+	daw::expecting( 9, b.back( ) );
+	daw::expecting( a.empty( ) );
+}
+
+void daw_small_vector_bench_001( ) {
+	size_t const count = 100'000;
+	auto const fill = []( auto &v, size_t n ) {
+		for( size_t i = 0; i < n; ++i ) {
+			v.push_back( static_cast<int>( i ) );
+		}
+	};
+	auto const t_small = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			daw::small_vector<int, 8> v{};
+			fill( v, n % 8 );
+			daw::do_not_optimize( v.data( ) );
+		}
+	} );
+	auto const t_vector = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			std::vector<int> v{};
+			fill( v, n % 8 );
+			daw::do_not_optimize( v.data( ) );
+		}
+	} );
+	std::cout << "small_vector<int, 8>: "
+	          << daw::utility::format_seconds( t_small, 2 ) << '\n';
+	std::cout << "std::vector<int>: "
+	          << daw::utility::format_seconds( t_vector, 2 ) << '\n';
+}
+
+int main( ) {
+	daw_small_vector_test_001( );
+	daw_small_vector_test_002( );
+	daw_small_vector_test_003( );
+	daw_small_vector_test_004( );
+	daw_small_vector_bench_001( );
+}
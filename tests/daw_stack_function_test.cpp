@@ -96,8 +96,79 @@ void stack_function_test_002( ) {
 	fcvf1( );
 }
 
+void stack_function_test_003( ) {
+	std::string const str = "a string long enough to need an allocation";
+	daw::function<64, size_t( )> f = [str]( ) { return str.size( ); };
+	auto f2 = f;
+	daw::function<64, size_t( )> f3{};
+	f3 = f2;
+	f = f;
+	daw::expecting( str.size( ), f( ) );
+	daw::expecting( str.size( ), f2( ) );
+	daw::expecting( str.size( ), f3( ) );
+	daw::function<128, size_t( )> f4 = std::move( f3 );
+	daw::expecting( f3.empty( ) );
+	daw::expecting( str.size( ), f4( ) );
+
+	int count = 0;
+	daw::function<16, void( )> counter = [&count]( ) { ++count; };
+	auto counter2 = counter;
+	counter( );
+	counter2( );
+	daw::expecting( 2, count );
+
+	daw::function<16, int( )> mut = [n = 0]( ) mutable { return ++n; };
+	mut( );
+	daw::expecting( 2, mut( ) );
+}
+
+int call_with( daw::function_ref<int( int )> f, int x ) {
+	return f( x );
+}
+
+int twice( int x ) {
+	return 2 * x;
+}
+
+void function_ref_test_001( ) {
+	int offset = 3;
+	auto add = [&offset]( int x ) { return x + offset; };
+	daw::expecting( 8, call_with( add, 5 ) );
+	daw::expecting( 10, call_with( twice, 5 ) );
+	daw::expecting( 10, call_with( &twice, 5 ) );
+	daw::function<32, int( int )> const f = add;
+	daw::expecting( 9, call_with( f, 6 ) );
+	std::function<int( int )> sf = twice;
+	daw::expecting( 12, call_with( sf, 6 ) );
+}
+
+void stack_function_bench_001( ) {
+	size_t const count = 10'000'000;
+	int total = 0;
+	daw::function<32, void( int )> df = [&total]( int x ) { total += x; };
+	std::function<void( int )> sf = [&total]( int x ) { total += x; };
+	auto const t_daw = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			df( static_cast<int>( n & 1U ) );
+		}
+	} );
+	auto const t_std = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			sf( static_cast<int>( n & 1U ) );
+		}
+	} );
+	daw::do_not_optimize( total );
+	std::cout << "daw::function calls: "
+	          << daw::utility::format_seconds( t_daw, 2 ) << '\n';
+	std::cout << "std::function calls: "
+	          << daw::utility::format_seconds( t_std, 2 ) << '\n';
+}
+
 int main( ) {
 	stack_function_test_001( );
 	stack_function_test_002( );
+	stack_function_test_003( );
+	function_ref_test_001( );
+	stack_function_bench_001( );
 }
 
@@ -0,0 +1,194 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/daw_string_map.h"
+
+void daw_string_map_001( ) {
+	daw::string_map<int> m{};
+	daw::expecting( m.empty( ) );
+	daw::expecting( m.insert( "short", 1 ) );
+	daw::expecting( m.insert( "exactly12chr", 2 ) );
+	daw::expecting( m.insert( "this key is longer than the inline storage", 3 ) );
+	daw::expecting( !m.insert( "short", 4 ) );
+	daw::expecting( 3U, m.size( ) );
+	daw::expecting( 1, m.at( "short" ) );
+	daw::expecting( 2, m.at( "exactly12chr" ) );
+	daw::expecting( 3, m.at( "this key is longer than the inline storage" ) );
+	// Only the long key needs the arena
+	daw::expecting( 42U, m.arena_size( ) );
+	daw::expecting( m.find( "this key is longer than the inline storagE" ) ==
+	                nullptr );
+	daw::expecting( m.find( "exactly12chR" ) == nullptr );
+	daw::expecting( !m.exists( "" ) );
+	m[""] = 5;
+	daw::expecting( 5, m.at( "" ) );
+	daw::expecting_exception<std::out_of_range>(
+	  [&]( ) { static_cast<void>( m.at( "missing" ) ); } );
+}
+
+// Keys that share a prefix and size must still be told apart by the rest
+void daw_string_map_002( ) {
+	daw::string_map<size_t> m{};
+	std::vector<std::string> keys{};
+	for( size_t n = 0; n < 2000; ++n ) {
+		keys.push_back( "prefix_" + std::to_string( n ) );
+		keys.push_back( "pref" + std::string( 20, 'x' ) + std::to_string( n ) );
+	}
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		m[keys[n]] = n;
+	}
+	daw::expecting( keys.size( ), m.size( ) );
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		daw::expecting( n, m.at( keys[n] ) );
+	}
+	size_t visited = 0;
+	m.for_each( [&]( daw::string_view key, size_t const &value ) {
+		daw::expecting( daw::string_view( keys[value] ) == key );
+		++visited;
+	} );
+	daw::expecting( keys.size( ), visited );
+}
+
+// Erase uses backward shifting, everything not erased must stay reachable and
+// the arena is compacted on the next rehash
+void daw_string_map_003( ) {
+	daw::string_map<size_t> m{};
+	std::vector<std::string> keys{};
+	for( size_t n = 0; n < 1000; ++n ) {
+		keys.push_back( "a somewhat long key number " + std::to_string( n ) );
+	}
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		m[keys[n]] = n;
+	}
+	for( size_t n = 0; n < keys.size( ); n += 2 ) {
+		daw::expecting( m.erase( keys[n] ) );
+	}
+	daw::expecting( !m.erase( keys[0] ) );
+	daw::expecting( 500U, m.size( ) );
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		daw::expecting( n % 2 == 1, m.exists( keys[n] ) );
+	}
+	auto const arena_before = m.arena_size( );
+	m.reserve( m.capacity( ) * 2 );
+	daw::expecting( m.arena_size( ) < arena_before );
+	for( size_t n = 1; n < keys.size( ); n += 2 ) {
+		daw::expecting( n, m.at( keys[n] ) );
+	}
+	m.clear( );
+	daw::expecting( m.empty( ) );
+	daw::expecting( 0U, m.arena_size( ) );
+	daw::expecting( !m.exists( keys[1] ) );
+}
+
+// A map of steady size that keeps replacing long keys must not grow its arena
+// without limit, the bytes of erased keys are compacted away
+void daw_string_map_004( ) {
+	daw::string_map<size_t> m{};
+	auto const key_for = []( size_t n ) {
+		return "a somewhat long key number " + std::to_string( n );
+	};
+	for( size_t n = 0; n < 100; ++n ) {
+		auto const key = key_for( n );
+		m[key] = n;
+	}
+	auto const capacity = m.capacity( );
+	size_t max_arena = 0;
+	for( size_t n = 100; n < 100'000; ++n ) {
+		auto const old_key = key_for( n - 100 );
+		auto const key = key_for( n );
+		daw::expecting( m.erase( old_key ) );
+		m[key] = n;
+		max_arena = std::max( max_arena, m.arena_size( ) );
+	}
+	daw::expecting( 100U, m.size( ) );
+	daw::expecting( capacity, m.capacity( ) );
+	// 100 live keys of at most 32 bytes, plus as much again of erased keys
+	daw::expecting( max_arena <= 2U * 100U * 32U );
+	for( size_t n = 99'900; n < 100'000; ++n ) {
+		auto const key = key_for( n );
+		daw::expecting( n, m.at( key ) );
+	}
+}
+
+// Symbol style lookups, short identifiers looked up through string_view.  The
+// std::unordered_map needs a std::string temporary for each lookup
+void daw_string_map_bench_001( ) {
+	std::mt19937_64 rng( 1 );
+	std::vector<std::string> keys{};
+	for( size_t n = 0; n < 100'000; ++n ) {
+		auto const len = 4 + rng( ) % 16;
+		std::string key( len, ' ' );
+		for( auto &c : key ) {
+			c = static_cast<char>( 'a' + rng( ) % 26 );
+		}
+		keys.push_back( std::move( key ) );
+	}
+	std::vector<daw::string_view> lookups{};
+	for( size_t n = 0; n < 1'000'000; ++n ) {
+		lookups.emplace_back( keys[rng( ) % keys.size( )] );
+	}
+	daw::string_map<size_t> sm( keys.size( ) );
+	std::unordered_map<std::string, size_t> um{};
+	um.reserve( keys.size( ) );
+	for( size_t n = 0; n < keys.size( ); ++n ) {
+		sm[keys[n]] = n;
+		um[keys[n]] = n;
+	}
+	size_t sum1 = 0;
+	auto const t1 = daw::benchmark( [&]( ) {
+		for( auto key : lookups ) {
+			if( auto p = sm.find( key ); p ) {
+				sum1 += *p;
+			}
+		}
+	} );
+	size_t sum2 = 0;
+	auto const t2 = daw::benchmark( [&]( ) {
+		for( auto key : lookups ) {
+			if( auto it = um.find( key.to_string( ) ); it != um.end( ) ) {
+				sum2 += it->second;
+			}
+		}
+	} );
+	daw::expecting( sum1, sum2 );
+	std::cout << "string_map lookups: "
+	          << ( t1 * 1'000'000'000.0 ) / static_cast<double>( lookups.size( ) )
+	          << "ns each\n";
+	std::cout << "unordered_map<std::string> lookups: "
+	          << ( t2 * 1'000'000'000.0 ) / static_cast<double>( lookups.size( ) )
+	          << "ns each\n";
+}
+
+int main( ) {
+	daw_string_map_001( );
+	daw_string_map_002( );
+	daw_string_map_003( );
+	daw_string_map_004( );
+	daw_string_map_bench_001( );
+}
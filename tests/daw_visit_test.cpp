@@ -0,0 +1,120 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/daw_visit.h"
+
+constexpr bool visit_nt_001( ) {
+	std::variant<int, double, char> a = 'a';
+	auto result = daw::visit_nt(
+	  a, []( int ) { return 1; }, []( double ) { return 2; },
+	  []( char ) { return 3; } );
+	daw::expecting( 3, result );
+	return true;
+}
+static_assert( visit_nt_001( ) );
+
+constexpr bool multi_visit_nt_001( ) {
+	std::variant<int, double> a = 5.5;
+	std::variant<char, int, bool> b = true;
+	auto result = daw::multi_visit_nt(
+	  []( auto x, auto y ) {
+		  return sizeof( x ) * 10 + sizeof( y );
+	  },
+	  a, b );
+	daw::expecting( sizeof( double ) * 10 + sizeof( bool ), result );
+	return true;
+}
+static_assert( multi_visit_nt_001( ) );
+
+void visit_nt_002( ) {
+	std::variant<int, std::string> a = std::string( "hello" );
+	std::string moved = daw::visit_nt(
+	  std::move( a ), []( int ) { return std::string( ); },
+	  []( std::string &&s ) { return std::move( s ); } );
+	daw::expecting( "hello", moved );
+
+	std::variant<int, std::string> b = 5;
+	std::variant<int, std::string> c = std::string( "x" );
+	int calls = 0;
+	daw::multi_visit_nt(
+	  [&]( auto const &... ) { ++calls; }, b, c, std::as_const( b ) );
+	daw::expecting( 1, calls );
+}
+
+namespace visit_nt_bench {
+	template<size_t N>
+	struct alt_t {
+		size_t value = N;
+	};
+
+	template<size_t... Is>
+	auto make_variant( std::index_sequence<Is...> ) -> std::variant<alt_t<Is>...>;
+
+	using var_t = decltype( make_variant( std::make_index_sequence<32>{} ) );
+
+	template<size_t... Is>
+	std::vector<var_t> make_values( size_t count, std::index_sequence<Is...> ) {
+		var_t const alts[] = {var_t( alt_t<Is>{} )...};
+		std::vector<var_t> result{};
+		result.reserve( count );
+		for( size_t n = 0; n < count; ++n ) {
+			result.push_back( alts[( n * 7U ) % sizeof...( Is )] );
+		}
+		return result;
+	}
+
+	void visit_nt_bench_001( ) {
+		auto const values =
+		  make_values( 1'000'000, std::make_index_sequence<32>{} );
+		auto const get_value = []( auto const &v ) { return v.value; };
+		size_t sum_nt = 0;
+		auto const t_nt = daw::benchmark( [&]( ) {
+			for( auto const &v : values ) {
+				sum_nt += daw::visit_nt( v, get_value );
+			}
+		} );
+		size_t sum_std = 0;
+		auto const t_std = daw::benchmark( [&]( ) {
+			for( auto const &v : values ) {
+				sum_std += std::visit( get_value, v );
+			}
+		} );
+		daw::expecting( sum_std, sum_nt );
+		std::cout << "visit_nt 32 alternatives: "
+		          << daw::utility::format_seconds( t_nt, 2 ) << '\n';
+		std::cout << "std::visit 32 alternatives: "
+		          << daw::utility::format_seconds( t_std, 2 ) << '\n';
+	}
+} // namespace visit_nt_bench
+
+int main( ) {
+	visit_nt_002( );
+	visit_nt_bench::visit_nt_bench_001( );
+}
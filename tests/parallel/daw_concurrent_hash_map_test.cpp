@@ -0,0 +1,204 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/parallel/daw_concurrent_hash_map.h"
+#include "daw/parallel/daw_locked_value.h"
+
+void concurrent_hash_map_001( ) {
+	daw::concurrent_hash_map<std::string, int> map;
+	daw::expecting( map.empty( ) );
+	daw::expecting( map.insert_or_assign( "hello", 1 ) );
+	daw::expecting( map.insert_or_assign( std::string( "world" ), 2 ) );
+	daw::expecting( !map.insert_or_assign( "hello", 3 ) );
+	daw::expecting( 2U, map.size( ) );
+	daw::expecting( 3, *map.find( "hello" ) );
+	daw::expecting( !map.find( "nothere" ) );
+	bool const found =
+	  map.visit( "world", []( std::string const &k, int v ) {
+		  daw::expecting( 5U, k.size( ) );
+		  daw::expecting( 2, v );
+	  } );
+	daw::expecting( found );
+	daw::expecting( map.erase( "hello" ) );
+	daw::expecting( !map.erase( "hello" ) );
+	daw::expecting( !map.contains( "hello" ) );
+	daw::expecting( 1U, map.size( ) );
+}
+
+void concurrent_hash_map_002( ) {
+	// Grow from the minimum bucket count
+	daw::concurrent_hash_map<uint64_t, uint64_t> map( 1 );
+	auto const start_buckets = map.bucket_count( );
+	for( uint64_t n = 0; n < 100'000; ++n ) {
+		map.insert_or_assign( n, n * 2 );
+	}
+	daw::expecting( map.bucket_count( ) > start_buckets );
+	daw::expecting( 100'000U, map.size( ) );
+	uint64_t sum = 0;
+	map.for_each( [&sum]( uint64_t k, uint64_t v ) {
+		daw::expecting( k * 2, v );
+		++sum;
+	} );
+	daw::expecting( 100'000U, sum );
+}
+
+void concurrent_hash_map_003( ) {
+	// Readers always see a consistent value while writers replace, erase and
+	// grow the table
+	daw::concurrent_hash_map<uint64_t, std::string> map( 64 );
+	constexpr uint64_t key_count = 4096;
+	for( uint64_t n = 0; n < key_count; n += 2 ) {
+		map.insert_or_assign( n, std::to_string( n ) );
+	}
+	std::atomic<bool> done = false;
+	std::atomic<size_t> bad_reads = 0;
+	std::vector<std::thread> threads{};
+	for( size_t t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&, t]( ) {
+			std::mt19937_64 rng( t );
+			while( !done ) {
+				auto const key = rng( ) % key_count;
+				map.visit( key, [&]( uint64_t k, std::string const &v ) {
+					if( v != std::to_string( k ) ) {
+						++bad_reads;
+					}
+				} );
+				map.for_each( [&]( uint64_t k, std::string const &v ) {
+					if( k == key and v != std::to_string( k ) ) {
+						++bad_reads;
+					}
+				} );
+			}
+		} );
+	}
+	for( size_t t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&, t]( ) {
+			std::mt19937_64 rng( t + 100 );
+			for( size_t n = 0; n < 20'000; ++n ) {
+				auto const key = rng( ) % key_count;
+				if( rng( ) % 2 == 0 ) {
+					map.insert_or_assign( key, std::to_string( key ) );
+				} else {
+					map.erase( key );
+				}
+			}
+		} );
+	}
+	for( size_t t = 4; t < threads.size( ); ++t ) {
+		threads[t].join( );
+	}
+	done = true;
+	for( size_t t = 0; t < 4; ++t ) {
+		threads[t].join( );
+	}
+	daw::expecting( 0U, bad_reads.load( ) );
+	size_t count = 0;
+	map.for_each( [&count]( auto const &, auto const & ) { ++count; } );
+	daw::expecting( count, map.size( ) );
+}
+
+// The single mutex design the concurrent map replaces
+struct locked_map_t {
+	daw::lockable_value_t<std::unordered_map<size_t, size_t>> m_map{};
+
+	explicit locked_map_t( size_t ) {}
+
+	bool insert_or_assign( size_t key, size_t value ) {
+		return m_map.get( )->insert_or_assign( key, value ).second;
+	}
+
+	bool erase( size_t key ) {
+		return m_map.get( )->erase( key ) == 1;
+	}
+
+	bool contains( size_t key ) const {
+		return m_map.get( )->count( key ) == 1;
+	}
+};
+
+template<typename Map>
+void bench_mix( std::string const &title, size_t thread_count,
+                size_t read_percent ) {
+	constexpr size_t const key_count = 1U << 16U;
+	constexpr size_t const total_ops = 1U << 20U;
+	Map map( key_count );
+	for( size_t n = 0; n < key_count; n += 2 ) {
+		map.insert_or_assign( n, n );
+	}
+	size_t const ops_per_thread = total_ops / thread_count;
+	auto const elapsed = daw::benchmark( [&]( ) {
+		std::vector<std::thread> threads{};
+		for( size_t t = 0; t < thread_count; ++t ) {
+			threads.emplace_back( [&, t]( ) {
+				std::mt19937_64 rng( t );
+				size_t found = 0;
+				for( size_t n = 0; n < ops_per_thread; ++n ) {
+					auto const r = rng( );
+					auto const key = r % key_count;
+					if( ( r >> 32U ) % 100 < read_percent ) {
+						found += map.contains( key ) ? 1U : 0U;
+					} else if( ( r >> 40U ) % 2 == 0 ) {
+						map.insert_or_assign( key, n );
+					} else {
+						map.erase( key );
+					}
+				}
+				daw::do_not_optimize( found );
+			} );
+		}
+		for( auto &th : threads ) {
+			th.join( );
+		}
+	} );
+	std::cout << title << " threads: " << thread_count << " reads: " << read_percent
+	          << "% -> "
+	          << static_cast<size_t>( static_cast<double>( total_ops ) / elapsed )
+	          << " ops/s\n";
+}
+
+void concurrent_hash_map_bench( ) {
+	for( size_t read_percent : {90U, 10U} ) {
+		for( size_t thread_count = 1; thread_count <= 64; thread_count *= 2 ) {
+			bench_mix<daw::concurrent_hash_map<size_t, size_t>>(
+			  "concurrent_hash_map", thread_count, read_percent );
+			bench_mix<locked_map_t>( "locked unordered_map", thread_count,
+			                         read_percent );
+		}
+	}
+}
+
+int main( ) {
+	concurrent_hash_map_001( );
+	concurrent_hash_map_002( );
+	concurrent_hash_map_003( );
+	concurrent_hash_map_bench( );
+}
@@ -0,0 +1,204 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/parallel/daw_epoch.h"
+
+namespace {
+	std::atomic<int> alive = 0;
+
+	struct node_t {
+		static constexpr uint64_t const magic = 0xC0FF'EE00'C0FF'EE00ULL;
+		uint64_t check = magic;
+		size_t value;
+
+		explicit node_t( size_t v )
+		  : value( v ) {
+			++alive;
+		}
+
+		~node_t( ) {
+			check = 0;
+			--alive;
+		}
+	};
+} // namespace
+
+void epoch_001( ) {
+	{
+		daw::epoch_domain domain{};
+		for( size_t n = 0; n < 10; ++n ) {
+			domain.retire( new node_t( n ) );
+		}
+		daw::expecting( 10, alive.load( ) );
+		domain.collect( );
+		daw::expecting( 0, alive.load( ) );
+		daw::expecting( 0U, domain.pending( ) );
+		// Destroying the domain frees what is still retired
+		domain.retire( new node_t( 1 ) );
+	}
+	daw::expecting( 0, alive.load( ) );
+}
+
+// Nothing retired while another thread is pinned is freed until it unpins
+void epoch_002( ) {
+	daw::epoch_domain domain{};
+	std::atomic<int> stage = 0;
+	auto reader = std::thread( [&]( ) {
+		auto const guard = domain.pin( );
+		stage = 1;
+		while( stage != 2 ) {
+			std::this_thread::yield( );
+		}
+	} );
+	while( stage != 1 ) {
+		std::this_thread::yield( );
+	}
+	domain.retire( new node_t( 1 ) );
+	domain.collect( );
+	daw::expecting( 1, alive.load( ) );
+	stage = 2;
+	reader.join( );
+	domain.collect( );
+	daw::expecting( 0, alive.load( ) );
+}
+
+void epoch_003( ) {
+	daw::epoch_domain domain{};
+	std::atomic<node_t *> shared = new node_t( 42 );
+	{
+		auto hp = domain.make_hazard_pointer( );
+		node_t *p = hp.protect( shared );
+		domain.retire( shared.exchange( nullptr ) );
+		domain.collect( );
+		domain.collect( );
+		// Epochs moved on but the hazard pointer still holds it
+		daw::expecting( 1, alive.load( ) );
+		daw::expecting( 42U, p->value );
+	}
+	domain.collect( );
+	daw::expecting( 0, alive.load( ) );
+}
+
+// What a thread retired before exiting is freed by the others
+void epoch_004( ) {
+	daw::epoch_domain domain{};
+	std::thread( [&]( ) { domain.retire( new node_t( 1 ) ); } ).join( );
+	daw::expecting( 1, alive.load( ) );
+	domain.collect( );
+	daw::expecting( 0, alive.load( ) );
+}
+
+// Readers follow a pointer that writers keep replacing and retiring.  A freed
+// node would fail the magic check, ThreadSanitizer/ASan see the rest
+void epoch_stress_001( ) {
+	constexpr size_t const reader_count = 4;
+	constexpr size_t const writer_count = 2;
+	constexpr size_t const writes = 20'000;
+	{
+		daw::epoch_domain domain{};
+		std::atomic<node_t *> shared = new node_t( 0 );
+		std::atomic<bool> done = false;
+		std::atomic<size_t> bad = 0;
+		std::vector<std::thread> threads{};
+		for( size_t t = 0; t < reader_count; ++t ) {
+			threads.emplace_back( [&]( ) {
+				while( not done ) {
+					auto const guard = domain.pin( );
+					node_t const *p = shared.load( std::memory_order_acquire );
+					if( p->check != node_t::magic ) {
+						++bad;
+					}
+				}
+			} );
+		}
+		std::vector<std::thread> writers{};
+		for( size_t t = 0; t < writer_count; ++t ) {
+			writers.emplace_back( [&]( ) {
+				for( size_t n = 0; n < writes; ++n ) {
+					auto const guard = domain.pin( );
+					domain.retire( shared.exchange( new node_t( n ) ) );
+				}
+			} );
+		}
+		for( auto &th : writers ) {
+			th.join( );
+		}
+		done = true;
+		for( auto &th : threads ) {
+			th.join( );
+		}
+		daw::expecting( 0U, bad.load( ) );
+		delete shared.load( );
+	}
+	daw::expecting( 0, alive.load( ) );
+}
+
+void epoch_bench( ) {
+	constexpr size_t const count = 1U << 20U;
+	daw::epoch_domain domain{};
+	auto const t_pin = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			auto const guard = domain.pin( );
+		}
+	} );
+	std::vector<node_t *> nodes( count );
+	for( auto &p : nodes ) {
+		p = new node_t( 1 );
+	}
+	auto const t_retire = daw::benchmark( [&]( ) {
+		for( auto *p : nodes ) {
+			domain.retire( p );
+		}
+		domain.collect( );
+	} );
+	for( auto &p : nodes ) {
+		p = new node_t( 1 );
+	}
+	auto const t_delete = daw::benchmark( [&]( ) {
+		for( auto *p : nodes ) {
+			delete p;
+		}
+	} );
+	std::cout << "pin/unpin: " << daw::utility::format_seconds( t_pin / count, 2 )
+	          << '\n';
+	std::cout << "retire and free: "
+	          << daw::utility::format_seconds( t_retire / count, 2 ) << '\n';
+	std::cout << "delete: " << daw::utility::format_seconds( t_delete / count, 2 )
+	          << '\n';
+}
+
+int main( ) {
+	epoch_001( );
+	epoch_002( );
+	epoch_003( );
+	epoch_004( );
+	epoch_stress_001( );
+	epoch_bench( );
+}
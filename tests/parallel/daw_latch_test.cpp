@@ -21,7 +21,13 @@
 // SOFTWARE.
 
 #include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "daw/daw_benchmark.h"
 #include "daw/parallel/daw_latch.h"
@@ -51,8 +57,111 @@ void try_wait_001( ) {
 	daw::expecting( sem.try_wait( ) );
 }
 
+void phased_barrier_001( ) {
+	constexpr size_t const thread_count = 4;
+	constexpr size_t const phases = 1000;
+	size_t completions = 0;
+	std::vector<size_t> progress( thread_count, 0 );
+	bool in_step = true;
+	auto bar = daw::basic_barrier( thread_count, [&]( ) {
+		// Every thread finished the same step before the phase ends
+		for( auto p : progress ) {
+			in_step = in_step and p == completions + 1;
+		}
+		++completions;
+	} );
+	std::vector<std::thread> threads{};
+	for( size_t t = 0; t < thread_count; ++t ) {
+		threads.emplace_back( [&, t]( ) {
+			for( size_t n = 0; n < phases; ++n ) {
+				++progress[t];
+				bar.arrive_and_wait( );
+			}
+		} );
+	}
+	for( auto &th : threads ) {
+		th.join( );
+	}
+	daw::expecting( phases, completions );
+	daw::expecting( in_step );
+	daw::expecting( static_cast<uint32_t>( phases ), bar.phase( ) );
+}
+
+void phased_barrier_002( ) {
+	daw::barrier bar( 3 );
+	auto const token = bar.arrive( 2 );
+	auto th = std::thread( [&]( ) { bar.arrive_and_drop( ); } );
+	bar.wait( token );
+	th.join( );
+	daw::expecting( 1U, bar.phase( ) );
+	// The dropped thread no longer counts
+	static_cast<void>( bar.arrive( 2 ) );
+	daw::expecting( 2U, bar.phase( ) );
+}
+
+namespace {
+	// Generation counting barrier on a condition variable
+	class cv_barrier_t {
+		std::mutex m_mutex{};
+		std::condition_variable m_condition{};
+		size_t const m_expected;
+		size_t m_remaining;
+		size_t m_generation = 0;
+
+	public:
+		explicit cv_barrier_t( size_t count )
+		  : m_expected( count )
+		  , m_remaining( count ) {}
+
+		void arrive_and_wait( ) {
+			auto lock = std::unique_lock<std::mutex>( m_mutex );
+			auto const generation = m_generation;
+			if( --m_remaining == 0 ) {
+				m_remaining = m_expected;
+				++m_generation;
+				m_condition.notify_all( );
+				return;
+			}
+			m_condition.wait( lock,
+			                  [&]( ) { return generation != m_generation; } );
+		}
+	};
+
+	template<typename Barrier>
+	void bench_barrier( std::string const &title, size_t thread_count ) {
+		constexpr size_t const phases = 2000;
+		Barrier bar( thread_count );
+		auto const elapsed = daw::benchmark( [&]( ) {
+			std::vector<std::thread> threads{};
+			for( size_t t = 0; t < thread_count; ++t ) {
+				threads.emplace_back( [&]( ) {
+					for( size_t n = 0; n < phases; ++n ) {
+						bar.arrive_and_wait( );
+					}
+				} );
+			}
+			for( auto &th : threads ) {
+				th.join( );
+			}
+		} );
+		std::cout << title << " threads: " << thread_count << " -> "
+		          << static_cast<size_t>( static_cast<double>( phases ) / elapsed )
+		          << " phases/s\n";
+	}
+} // namespace
+
+void barrier_bench( ) {
+	for( size_t thread_count = 2; thread_count <= 8; thread_count *= 2 ) {
+		bench_barrier<daw::barrier>( "barrier", thread_count );
+		bench_barrier<cv_barrier_t>( "condition_variable barrier", thread_count );
+	}
+}
+
 int main( ) {
 	construction_001( );
 	barrier_001( );
 	try_wait_001( );
+	phased_barrier_001( );
+	phased_barrier_002( );
+	barrier_bench( );
 }
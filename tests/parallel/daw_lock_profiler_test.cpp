@@ -0,0 +1,171 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#define DAW_LOCK_PROFILING
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/parallel/daw_copy_mutex.h"
+#include "daw/parallel/daw_lock_profiler.h"
+#include "daw/parallel/daw_scoped_multilock.h"
+#include "daw/parallel/daw_spin_lock.h"
+
+namespace {
+	daw::lock_site_stats stats_for( std::string const &name ) {
+		for( auto const &s : daw::lock_profile( ) ) {
+			if( s.name == name ) {
+				return s;
+			}
+		}
+		return {};
+	}
+} // namespace
+
+void lock_profiler_001( ) {
+	daw::profiled_lock<std::mutex, 1> mut( "profiler_001" );
+	for( size_t n = 0; n < 10; ++n ) {
+		std::lock_guard<decltype( mut )> lock( mut );
+	}
+	daw::expecting( true, mut.try_lock( ) );
+	std::thread th( [&]( ) { daw::expecting( false, mut.try_lock( ) ); } );
+	th.join( );
+	mut.unlock( );
+
+	auto const s = stats_for( "profiler_001" );
+	daw::expecting( 11U, s.acquisitions );
+	daw::expecting( 0U, s.contended );
+	daw::expecting( 1U, s.failed_try_locks );
+	uint64_t holds = 0;
+	for( auto c : s.hold_histogram ) {
+		holds += c;
+	}
+	daw::expecting( 11U, holds );
+	daw::expecting( 11U, s.hold_samples );
+}
+
+void lock_profiler_002( ) {
+	// Two locks with one name share a site
+	daw::profiled_lock<daw::spin_lock> a( "profiler_002" );
+	daw::profiled_lock<daw::spin_lock> b( "profiler_002" );
+	a.lock( );
+	std::thread th( [&]( ) {
+		std::lock_guard<daw::profiled_lock<daw::spin_lock>> lock( a );
+	} );
+	std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+	a.unlock( );
+	th.join( );
+	b.lock( );
+	b.unlock( );
+
+	auto const s = stats_for( "profiler_002" );
+	daw::expecting( 3U, s.acquisitions );
+	daw::expecting( 1U, s.contended );
+	daw::expecting( true, s.total_wait >= std::chrono::milliseconds( 10 ) );
+	daw::expecting( true, s.wait_percentile( 0.99 ) >= s.total_wait );
+	daw::expecting( true,
+	                s.hold_percentile( 0.5 ) > std::chrono::nanoseconds( 0 ) );
+}
+
+void lock_profiler_003( ) {
+	daw::profiled_lock<std::mutex> m1( "profiler_003_a" );
+	daw::profiled_lock<daw::copiable_mutex<std::mutex>> m2( "profiler_003_b" );
+	auto m3 = m2;
+	{
+		auto lck = daw::make_scoped_multilock( m1, m2 );
+	}
+	{
+		std::lock_guard<decltype( m3 )> lock( m3 );
+	}
+	daw::expecting( 1U, stats_for( "profiler_003_a" ).acquisitions );
+	daw::expecting( 2U, stats_for( "profiler_003_b" ).acquisitions );
+
+	daw::reset_lock_profile( );
+	daw::expecting( 0U, stats_for( "profiler_003_b" ).acquisitions );
+}
+
+void lock_profiler_004( ) {
+	daw::reset_lock_profile( );
+	daw::profiled_lock<std::mutex> hot( "profiler_004_hot" );
+	daw::profiled_lock<std::mutex> cold( "profiler_004_cold" );
+	std::vector<std::thread> threads{};
+	for( size_t t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&]( ) {
+			for( size_t n = 0; n < 200; ++n ) {
+				std::lock_guard<daw::profiled_lock<std::mutex>> lock( hot );
+				std::this_thread::sleep_for( std::chrono::microseconds( 10 ) );
+			}
+		} );
+	}
+	for( auto &t : threads ) {
+		t.join( );
+	}
+	cold.lock( );
+	cold.unlock( );
+
+	auto const profile = daw::lock_profile( );
+	daw::expecting( "profiler_004_hot", profile.front( ).name );
+	daw::expecting( 800U, profile.front( ).acquisitions );
+	daw::expecting( true, profile.front( ).contention_ratio( ) > 0.0 );
+
+	std::stringstream ss{};
+	daw::dump_lock_profile( ss, 1 );
+	auto const out = ss.str( );
+	daw::expecting( true, out.find( "profiler_004_hot" ) != std::string::npos );
+	daw::expecting( true, out.find( "profiler_004_cold" ) == std::string::npos );
+	daw::dump_lock_profile( std::cout, 3 );
+}
+
+void lock_profiler_bench( ) {
+	constexpr size_t const count = 1U << 20U;
+	std::mutex plain{};
+	daw::profiled_lock<std::mutex> profiled( "profiler_bench" );
+	auto const t_plain = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			std::lock_guard<std::mutex> lock( plain );
+		}
+	} );
+	auto const t_profiled = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			std::lock_guard<daw::profiled_lock<std::mutex>> lock( profiled );
+		}
+	} );
+	std::cout << "uncontended lock/unlock std::mutex: "
+	          << daw::utility::format_seconds( t_plain / count, 2 )
+	          << ", profiled: "
+	          << daw::utility::format_seconds( t_profiled / count, 2 ) << '\n';
+}
+
+int main( ) {
+	lock_profiler_001( );
+	lock_profiler_002( );
+	lock_profiler_003( );
+	lock_profiler_004( );
+	lock_profiler_bench( );
+}
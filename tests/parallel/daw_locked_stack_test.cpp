@@ -0,0 +1,136 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/parallel/daw_locked_stack.h"
+
+void lock_free_stack_001( ) {
+	daw::lock_free_stack<std::string> st{};
+	daw::expecting( st.empty( ) );
+	daw::expecting( not st.try_pop_back( ) );
+	st.push_back( "a" );
+	st.emplace_back( 2, 'b' );
+	daw::expecting( not st.empty( ) );
+	daw::expecting( "bb", *st.try_pop_back( ) );
+	daw::expecting( "a", st.pop_back( ) );
+	daw::expecting( st.empty( ) );
+	// Values left behind are destroyed with the stack
+	st.push_back( "c" );
+}
+
+// Every value pushed is popped exactly once, with pushers and poppers
+// racing on the head and meeting in the elimination array
+void lock_free_stack_002( ) {
+	constexpr size_t const thread_count = 8;
+	constexpr size_t const per_thread = 20'000;
+	daw::lock_free_stack<size_t> st{};
+	std::vector<std::atomic<int>> seen( thread_count * per_thread );
+	std::vector<std::thread> threads{};
+	for( size_t t = 0; t < thread_count; ++t ) {
+		threads.emplace_back( [&, t]( ) {
+			for( size_t n = 0; n < per_thread; ++n ) {
+				st.push_back( t * per_thread + n );
+				++seen[st.pop_back( )];
+			}
+		} );
+	}
+	for( auto &th : threads ) {
+		th.join( );
+	}
+	bool all_once = true;
+	for( auto const &s : seen ) {
+		all_once = all_once and s.load( ) == 1;
+	}
+	daw::expecting( all_once );
+	daw::expecting( st.empty( ) );
+}
+
+void lock_free_stack_003( ) {
+	daw::lock_free_stack<int> st{};
+	auto consumer = std::thread( [&]( ) {
+		int sum = 0;
+		for( int n = 0; n < 100; ++n ) {
+			sum += st.pop_back( );
+		}
+		daw::expecting( 4950, sum );
+	} );
+	for( int n = 0; n < 100; ++n ) {
+		st.push_back( n );
+	}
+	consumer.join( );
+}
+
+namespace {
+	// A free list of reusable buffers, each worker takes one and returns it
+	template<typename Stack>
+	void bench_free_list( std::string const &title, size_t thread_count ) {
+		constexpr size_t const total_ops = 1U << 20U;
+		size_t const ops_per_thread = total_ops / thread_count;
+		Stack st{};
+		for( size_t n = 0; n < thread_count; ++n ) {
+			st.push_back( std::make_shared<std::vector<char>>( 4096 ) );
+		}
+		auto const elapsed = daw::benchmark( [&]( ) {
+			std::vector<std::thread> threads{};
+			for( size_t t = 0; t < thread_count; ++t ) {
+				threads.emplace_back( [&]( ) {
+					for( size_t n = 0; n < ops_per_thread; ++n ) {
+						auto buff = st.pop_back( );
+						( *buff )[n % 4096] = 1;
+						st.push_back( std::move( buff ) );
+					}
+				} );
+			}
+			for( auto &th : threads ) {
+				th.join( );
+			}
+		} );
+		auto const rate = static_cast<double>( total_ops ) / elapsed;
+		std::cout << title << " threads: " << thread_count << " -> "
+		          << static_cast<size_t>( rate ) << " pop/push pairs/s\n";
+	}
+} // namespace
+
+void lock_free_stack_bench( ) {
+	using buffer_t = std::shared_ptr<std::vector<char>>;
+	for( size_t thread_count = 1; thread_count <= 32; thread_count *= 2 ) {
+		bench_free_list<daw::lock_free_stack<buffer_t>>( "lock_free_stack",
+		                                                 thread_count );
+		bench_free_list<daw::locked_stack_t<buffer_t>>( "locked_stack_t",
+		                                                thread_count );
+	}
+}
+
+int main( ) {
+	lock_free_stack_001( );
+	lock_free_stack_002( );
+	lock_free_stack_003( );
+	lock_free_stack_bench( );
+}
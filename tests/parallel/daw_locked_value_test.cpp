@@ -20,9 +20,14 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <iostream>
+#include <map>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "daw/daw_benchmark.h"
 #include "daw/parallel/daw_locked_value.h"
@@ -118,8 +123,220 @@ void const_lock_value_01( ) {
 	}
 }
 
+namespace {
+	struct pair_t {
+		size_t a;
+		size_t b;
+	};
+} // namespace
+
+// Readers never see a half written value
+void seqlock_cell_001( ) {
+	daw::seqlock_cell<pair_t> cell{};
+	std::atomic<bool> done = false;
+	std::atomic<size_t> torn = 0;
+	std::vector<std::thread> readers{};
+	for( size_t t = 0; t < 3; ++t ) {
+		readers.emplace_back( [&]( ) {
+			while( not done ) {
+				auto const p = cell.load( );
+				if( p.b != p.a * 2 ) {
+					++torn;
+				}
+			}
+		} );
+	}
+	for( size_t n = 1; n <= 100'000; ++n ) {
+		if( n % 2 == 0 ) {
+			cell.store( pair_t{n, n * 2} );
+		} else {
+			cell.update( [&]( pair_t &p ) {
+				p.a = n;
+				p.b = n * 2;
+			} );
+		}
+	}
+	done = true;
+	for( auto &th : readers ) {
+		th.join( );
+	}
+	daw::expecting( 0U, torn.load( ) );
+	daw::expecting( 100'000U, cell.load( ).a );
+}
+
+namespace {
+	struct tracked_t {
+		static inline std::atomic<int> alive = 0;
+		std::vector<size_t> values;
+
+		explicit tracked_t( std::vector<size_t> v )
+		  : values( std::move( v ) ) {
+			++alive;
+		}
+
+		tracked_t( tracked_t const &other )
+		  : values( other.values ) {
+			++alive;
+		}
+
+		~tracked_t( ) {
+			--alive;
+		}
+	};
+} // namespace
+
+void snapshot_cell_001( ) {
+	{
+		daw::snapshot_cell<tracked_t> cell( std::vector<size_t>{1, 2, 3} );
+		auto first = cell.load( );
+		cell.store( std::vector<size_t>{4} );
+		// The replaced version lives as long as a snapshot of it does
+		daw::expecting( 2, tracked_t::alive.load( ) );
+		daw::expecting( 3U, first->values.size( ) );
+		first.reset( );
+		daw::expecting( 1, tracked_t::alive.load( ) );
+		cell.update( []( tracked_t const &cur ) {
+			auto result = cur;
+			result.values.push_back( 5 );
+			return result;
+		} );
+		daw::expecting( 2U, cell.load( )->values.size( ) );
+	}
+	daw::expecting( 0, tracked_t::alive.load( ) );
+}
+
+// Versions published while readers hold older ones are all reclaimed
+void snapshot_cell_002( ) {
+	{
+		daw::snapshot_cell<tracked_t> cell( std::vector<size_t>{0} );
+		std::atomic<bool> done = false;
+		std::atomic<size_t> bad = 0;
+		std::vector<std::thread> readers{};
+		for( size_t t = 0; t < 3; ++t ) {
+			readers.emplace_back( [&]( ) {
+				while( not done ) {
+					auto snap = cell.load( );
+					auto const &v = snap->values;
+					if( v.size( ) != v.back( ) + 1 ) {
+						++bad;
+					}
+				}
+			} );
+		}
+		for( size_t n = 1; n < 2000; ++n ) {
+			cell.update( []( tracked_t const &cur ) {
+				auto result = cur;
+				result.values.push_back( result.values.size( ) );
+				return result;
+			} );
+		}
+		done = true;
+		for( auto &th : readers ) {
+			th.join( );
+		}
+		daw::expecting( 0U, bad.load( ) );
+		daw::expecting( 1, tracked_t::alive.load( ) );
+	}
+	daw::expecting( 0, tracked_t::alive.load( ) );
+}
+
+// More snapshots than the 16 bit count holds, the cell republishes copies so
+// none of the versions is freed while held
+void snapshot_cell_003( ) {
+	{
+		daw::snapshot_cell<tracked_t> cell( std::vector<size_t>{1, 2, 3} );
+		std::vector<daw::snapshot_cell<tracked_t>::snapshot> snaps{};
+		for( size_t n = 0; n < 200'000; ++n ) {
+			snaps.push_back( cell.load( ) );
+		}
+		daw::expecting( tracked_t::alive.load( ) > 1 );
+		for( auto const &snap : snaps ) {
+			daw::expecting( 3U, snap->values.size( ) );
+		}
+		snaps.clear( );
+		daw::expecting( 1, tracked_t::alive.load( ) );
+	}
+	daw::expecting( 0, tracked_t::alive.load( ) );
+}
+
+// A store racing an update is never overwritten by the update's result,
+// updates only change the second element so the first is always the last
+// stored id
+void snapshot_cell_004( ) {
+	daw::snapshot_cell<std::vector<size_t>> cell( std::vector<size_t>{0, 0} );
+	std::atomic<bool> done = false;
+	std::thread updater( [&]( ) {
+		while( not done ) {
+			cell.update( []( std::vector<size_t> const &cur ) {
+				auto result = cur;
+				++result[1];
+				std::this_thread::sleep_for( std::chrono::microseconds( 10 ) );
+				return result;
+			} );
+		}
+	} );
+	size_t lost = 0;
+	for( size_t id = 1; id <= 2000; ++id ) {
+		cell.store( std::vector<size_t>{id, 0} );
+		if( cell.load( )->front( ) != id ) {
+			++lost;
+		}
+	}
+	done = true;
+	updater.join( );
+	daw::expecting( 0U, lost );
+}
+
+namespace {
+	template<typename Read>
+	void bench_reads( std::string const &title, size_t thread_count,
+	                  Read read ) {
+		constexpr size_t const total_reads = 1U << 21U;
+		size_t const reads_per_thread = total_reads / thread_count;
+		auto const elapsed = daw::benchmark( [&]( ) {
+			std::vector<std::thread> threads{};
+			for( size_t t = 0; t < thread_count; ++t ) {
+				threads.emplace_back( [&]( ) {
+					size_t sum = 0;
+					for( size_t n = 0; n < reads_per_thread; ++n ) {
+						sum += read( );
+					}
+					daw::do_not_optimize( sum );
+				} );
+			}
+			for( auto &th : threads ) {
+				th.join( );
+			}
+		} );
+		auto const rate = static_cast<double>( total_reads ) / elapsed;
+		std::cout << title << " readers: " << thread_count << " -> "
+		          << static_cast<size_t>( rate ) << " reads/s\n";
+	}
+} // namespace
+
+void read_mostly_bench( ) {
+	daw::lockable_value_t<pair_t> locked( pair_t{1, 2} );
+	daw::seqlock_cell<pair_t> seq( pair_t{1, 2} );
+	daw::snapshot_cell<std::map<size_t, size_t>> routes(
+	  std::map<size_t, size_t>{{1, 2}} );
+	for( size_t thread_count = 1; thread_count <= 8; thread_count *= 2 ) {
+		bench_reads( "lockable_value_t", thread_count,
+		             [&]( ) { return ( *locked )->b; } );
+		bench_reads( "seqlock_cell", thread_count,
+		             [&]( ) { return seq.load( ).b; } );
+		bench_reads( "snapshot_cell", thread_count,
+		             [&]( ) { return routes.load( )->at( 1 ); } );
+	}
+}
+
 int main( ) {
 	test_locked_value01( );
 	test_lockable_value01( );
 	const_lock_value_01( );
+	seqlock_cell_001( );
+	snapshot_cell_001( );
+	snapshot_cell_002( );
+	snapshot_cell_003( );
+	snapshot_cell_004( );
+	read_mostly_bench( );
 }
@@ -20,7 +20,14 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "daw/daw_benchmark.h"
 #include "daw/parallel/daw_observable_ptr.h"
@@ -85,10 +92,168 @@ void test_005( ) {
 	daw::expecting( 0, v );
 }
 
+namespace {
+	struct destruct_counter_t {
+		int *count;
+
+		explicit destruct_counter_t( int *c )
+		  : count( c ) {}
+
+		~destruct_counter_t( ) {
+			++*count;
+		}
+	};
+} // namespace
+
+void test_006( ) {
+	int destructed = 0;
+	daw::observer_ptr<destruct_counter_t> obs{};
+	{
+		auto t = daw::make_observable_ptr<destruct_counter_t>( &destructed );
+		obs = t.get_observer( );
+		auto copy = obs;
+		auto lck1 = obs.borrow_shared( );
+		auto lck2 = copy.try_borrow_shared( );
+		daw::expecting( static_cast<bool>( lck1 ) and static_cast<bool>( lck2 ) );
+		// Destruction waits for the last borrow
+		t = daw::observable_ptr<destruct_counter_t>( );
+		daw::expecting( 0, destructed );
+		daw::expecting( not obs );
+	}
+	daw::expecting( 1, destructed );
+	daw::expecting( not obs.borrow( ) );
+	daw::expecting( obs.get( ) == nullptr );
+}
+
+void test_007( ) {
+	auto t = daw::make_observable_ptr<int>( 1 );
+	auto obs = t.get_observer( );
+	{
+		auto reader = obs.borrow_shared( );
+		daw::expecting( static_cast<bool>( obs.try_borrow_shared( ) ) );
+		daw::expecting( not obs.try_borrow( ) );
+	}
+	{
+		auto writer = obs.borrow( );
+		daw::expecting( static_cast<bool>( writer ) );
+		if( writer ) {
+			*writer = 2;
+		}
+		daw::expecting( not obs.try_borrow( ) );
+		daw::expecting( not t.try_borrow_shared( ) );
+	}
+	auto const value = obs.lock( []( int const &v ) { return v; } ).get( );
+	daw::expecting( 2, value );
+}
+
+void test_008( ) {
+	// lock with a mutable callable is exclusive, so plain ints can be updated
+	// from several threads while others read
+	constexpr int const per_thread = 20'000;
+	auto t = daw::make_observable_ptr<std::pair<int, int>>( 0, 0 );
+	auto obs = t.get_observer( );
+	std::atomic<bool> torn = false;
+	std::vector<std::thread> threads{};
+	for( size_t n = 0; n < 4; ++n ) {
+		threads.emplace_back( [&, n]( ) {
+			for( int i = 0; i < per_thread; ++i ) {
+				auto const inc = []( std::pair<int, int> &p ) {
+					++p.first;
+					++p.second;
+				};
+				if( n % 2 == 0 ) {
+					t.lock( inc );
+				} else {
+					obs.lock( inc );
+				}
+			}
+		} );
+	}
+	auto const &cobs = obs;
+	threads.emplace_back( [&]( ) {
+		for( int i = 0; i < per_thread; ++i ) {
+			cobs.lock( [&]( std::pair<int, int> const &p ) {
+				if( p.first != p.second ) {
+					torn = true;
+				}
+			} );
+		}
+	} );
+	for( auto &th : threads ) {
+		th.join( );
+	}
+	daw::expecting( not torn.load( ) );
+	auto const *result = t.get( );
+	daw::expecting( result != nullptr );
+	if( result ) {
+		daw::expecting( 4 * per_thread, result->first );
+		daw::expecting( 4 * per_thread, result->second );
+	}
+}
+
+namespace {
+	// The previous design, every borrow takes the same mutex
+	struct mutex_borrow_t {
+		std::unique_ptr<int> value;
+		mutable std::mutex mut{};
+
+		int read( ) const {
+			std::lock_guard<std::mutex> lck( mut );
+			return *value;
+		}
+	};
+
+	template<typename Read>
+	void bench_readers( std::string const &title, size_t thread_count,
+	                    Read read ) {
+		constexpr size_t const total_borrows = 1U << 22U;
+		size_t const borrows_per_thread = total_borrows / thread_count;
+		std::atomic<size_t> total{0};
+		auto const elapsed = daw::benchmark( [&]( ) {
+			std::vector<std::thread> threads{};
+			for( size_t t = 0; t < thread_count; ++t ) {
+				threads.emplace_back( [&]( ) {
+					size_t sum = 0;
+					for( size_t n = 0; n < borrows_per_thread; ++n ) {
+						sum += static_cast<size_t>( read( ) );
+					}
+					total += sum;
+				} );
+			}
+			for( auto &th : threads ) {
+				th.join( );
+			}
+		} );
+		daw::expecting( borrows_per_thread * thread_count, total.load( ) );
+		std::cout << title << " readers: " << thread_count << " -> "
+		          << static_cast<size_t>( static_cast<double>( total_borrows ) /
+		                                  elapsed )
+		          << " borrows/s\n";
+	}
+} // namespace
+
+void observable_ptr_bench( ) {
+	auto const owner = daw::make_observable_ptr<int>( 1 );
+	auto const obs = owner.get_observer( );
+	mutex_borrow_t const locked{std::make_unique<int>( 1 ), {}};
+	for( size_t thread_count = 1; thread_count <= 16; thread_count *= 2 ) {
+		bench_readers( "observable_ptr", thread_count, [&]( ) {
+			auto lck = obs.borrow_shared( );
+			return lck ? *lck : 0;
+		} );
+		bench_readers( "mutex borrow", thread_count,
+		               [&]( ) { return locked.read( ); } );
+	}
+}
+
 int main( ) {
 	test_001( );
 	test_002( );
 	test_003( );
 	test_004( );
 	test_005( );
+	test_006( );
+	test_007( );
+	test_008( );
+	observable_ptr_bench( );
 }
@@ -47,6 +47,25 @@ void daw_scoped_multilock_001( ) {
 	daw::expecting_message( result2, "m2 wasn't locked" );
 }
 
+void daw_scoped_multilock_002( ) {
+	std::mutex m1;
+	bool result = false;
+	{
+		auto lck = daw::make_scoped_multilock( m1 );
+		std::thread th{[&]( ) {
+			result = !m1.try_lock( );
+			if( !result ) {
+				m1.unlock( );
+			}
+		}};
+		th.join( );
+	}
+	daw::expecting_message( result, "m1 wasn't locked" );
+	daw::expecting_message( m1.try_lock( ), "m1 wasn't unlocked" );
+	m1.unlock( );
+}
+
 int main( ) {
 	daw_scoped_multilock_001( );
+	daw_scoped_multilock_002( );
 }
@@ -20,6 +20,12 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+#include <vector>
+
 #include "daw/daw_benchmark.h"
 #include "daw/parallel/daw_semaphore.h"
 
@@ -28,6 +34,66 @@ void test_01( ) {
 	daw::shared_semaphore sem2{std::move( sem1 )};
 }
 
+void test_02( ) {
+	daw::semaphore sem{1};
+	daw::expecting( sem.try_wait( ) );
+	daw::expecting( not sem.try_wait( ) );
+	sem.add_notifier( );
+	sem.notify( );
+	daw::expecting( not sem.try_wait( ) );
+	sem.notify( );
+	daw::expecting( sem.try_wait( ) );
+	using namespace std::chrono_literals;
+	daw::expecting( not sem.wait_for( 1ms ) );
+}
+
+// Nothing gets through an unlatched semaphore until set_latch
+void test_03( ) {
+	daw::shared_semaphore sem{2, false};
+	daw::expecting( not sem.try_wait( ) );
+	std::vector<std::thread> threads{};
+	for( size_t n = 0; n < 2; ++n ) {
+		threads.emplace_back( [sem]( ) mutable { sem.wait( ); } );
+	}
+	sem.set_latch( );
+	for( auto &th : threads ) {
+		th.join( );
+	}
+	daw::expecting( not sem.try_wait( ) );
+}
+
+void test_04( ) {
+	constexpr size_t const items = 100'000;
+	daw::shared_semaphore sem{};
+	auto consumer = std::thread( [sem]( ) mutable {
+		for( size_t n = 0; n < items; ++n ) {
+			sem.wait( );
+		}
+	} );
+	for( size_t n = 0; n < items; ++n ) {
+		sem.notify( );
+	}
+	consumer.join( );
+	daw::expecting( not sem.try_wait( ) );
+}
+
+void semaphore_bench( ) {
+	constexpr size_t const count = 1U << 20U;
+	daw::semaphore sem{};
+	auto const elapsed = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			sem.notify( );
+			daw::do_not_optimize( sem.try_wait( ) );
+		}
+	} );
+	std::cout << "uncontended notify/try_wait: "
+	          << daw::utility::format_seconds( elapsed / count, 2 ) << '\n';
+}
+
 int main( ) {
 	test_01( );
+	test_02( );
+	test_03( );
+	test_04( );
+	semaphore_bench( );
 }
@@ -0,0 +1,224 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/parallel/daw_sharded_counter.h"
+
+void sharded_counter_001( ) {
+	daw::basic_sharded_counter<int64_t, 8> counter( 4 );
+	daw::expecting( 4U, counter.shard_count( ) );
+	for( size_t n = 0; n < 100; ++n ) {
+		++counter;
+	}
+	counter -= 30;
+	daw::expecting( 70, counter.load( ) );
+	auto const approx = counter.load_approx( );
+	daw::expecting( true, approx <= 70 and
+	                        70 - approx <=
+	                          static_cast<int64_t>( counter.max_error( ) ) );
+	counter.reset( );
+	daw::expecting( 0, counter.load( ) );
+	daw::expecting( 0, counter.load_approx( ) );
+}
+
+void sharded_counter_002( ) {
+	// Unsigned counters wrap in the shards but not in the total
+	daw::basic_sharded_counter<size_t, 16> counter( 3 );
+	daw::expecting( 4U, counter.shard_count( ) );
+	counter += 5;
+	counter.sub( 3 );
+	--counter;
+	daw::expecting( 1U, counter.load( ) );
+}
+
+void sharded_counter_003( ) {
+	constexpr size_t const thread_count = 8;
+	constexpr int64_t const per_thread = 100'000;
+	daw::basic_sharded_counter<int64_t, 64> counter( 4 );
+	std::atomic<bool> done = false;
+	std::atomic<size_t> went_back = 0;
+	std::thread reader( [&]( ) {
+		int64_t last = 0;
+		while( not done.load( ) ) {
+			auto const cur = counter.load( );
+			if( cur < last ) {
+				++went_back;
+			}
+			last = cur;
+		}
+	} );
+	std::vector<std::thread> threads{};
+	for( size_t t = 0; t < thread_count; ++t ) {
+		threads.emplace_back( [&]( ) {
+			for( int64_t n = 0; n < per_thread; ++n ) {
+				++counter;
+			}
+		} );
+	}
+	for( auto &t : threads ) {
+		t.join( );
+	}
+	done = true;
+	reader.join( );
+	daw::expecting( 0U, went_back.load( ) );
+	daw::expecting( static_cast<int64_t>( thread_count ) * per_thread,
+	                counter.load( ) );
+	auto const approx = counter.load_approx( );
+	daw::expecting( true, counter.load( ) - approx <=
+	                        static_cast<int64_t>( counter.max_error( ) ) );
+}
+
+void sharded_extremum_001( ) {
+	daw::sharded_min<int> mn( 4 );
+	daw::sharded_max<double> mx( 4 );
+	daw::expecting( std::numeric_limits<int>::max( ), mn.load( ) );
+	daw::expecting( std::numeric_limits<double>::lowest( ), mx.load( ) );
+
+	std::vector<std::thread> threads{};
+	for( int t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&, t]( ) {
+			for( int n = 0; n < 10'000; ++n ) {
+				auto const v = ( n * 7919 + t * 104729 ) % 20'000 - 10'000;
+				mn.update( v );
+				mx.update( static_cast<double>( v ) / 2.0 );
+			}
+		} );
+	}
+	for( auto &t : threads ) {
+		t.join( );
+	}
+	int expected_min = std::numeric_limits<int>::max( );
+	int expected_max = std::numeric_limits<int>::lowest( );
+	for( int t = 0; t < 4; ++t ) {
+		for( int n = 0; n < 10'000; ++n ) {
+			auto const v = ( n * 7919 + t * 104729 ) % 20'000 - 10'000;
+			expected_min = std::min( expected_min, v );
+			expected_max = std::max( expected_max, v );
+		}
+	}
+	daw::expecting( expected_min, mn.load( ) );
+	daw::expecting( static_cast<double>( expected_max ) / 2.0, mx.load( ) );
+	mn.reset( );
+	daw::expecting( std::numeric_limits<int>::max( ), mn.load( ) );
+}
+
+void sharded_accumulator_001( ) {
+	daw::sharded_accumulator<double> acc( 8 );
+	daw::expecting( 0U, acc.snapshot( ).count );
+	daw::expecting( 0.0, acc.snapshot( ).mean( ) );
+
+	std::vector<std::thread> threads{};
+	for( size_t t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&]( ) {
+			for( size_t n = 1; n <= 1000; ++n ) {
+				acc.record( static_cast<double>( n ) );
+			}
+		} );
+	}
+	for( auto &t : threads ) {
+		t.join( );
+	}
+	auto const snap = acc.snapshot( );
+	daw::expecting( 4000U, snap.count );
+	daw::expecting( 4000U, acc.count( ) );
+	daw::expecting( 4.0 * 500'500.0, snap.sum );
+	daw::expecting( 1.0, snap.min );
+	daw::expecting( 1000.0, snap.max );
+	daw::expecting( 500.5, snap.mean( ) );
+	acc.reset( );
+	daw::expecting( 0U, acc.snapshot( ).count );
+}
+
+namespace {
+	template<typename Counter>
+	void bench_counter( std::string const &title, size_t thread_count ) {
+		constexpr size_t const per_thread = 1U << 20U;
+		Counter counter{};
+		auto const elapsed = daw::benchmark( [&]( ) {
+			std::vector<std::thread> threads{};
+			for( size_t t = 0; t < thread_count; ++t ) {
+				threads.emplace_back( [&]( ) {
+					for( size_t n = 0; n < per_thread; ++n ) {
+						++counter;
+					}
+				} );
+			}
+			for( auto &t : threads ) {
+				t.join( );
+			}
+		} );
+		daw::expecting( static_cast<int64_t>( thread_count * per_thread ),
+		                static_cast<int64_t>( counter.load( ) ) );
+		std::cout << title << " threads: " << thread_count << " -> "
+		          << daw::utility::format_seconds(
+		               elapsed / static_cast<double>( thread_count * per_thread ),
+		               2 )
+		          << " per increment\n";
+	}
+} // namespace
+
+void sharded_counter_bench( ) {
+	for( size_t thread_count = 1; thread_count <= 16; thread_count *= 2 ) {
+		bench_counter<daw::sharded_counter>( "sharded_counter", thread_count );
+		bench_counter<std::atomic<int64_t>>( "std::atomic", thread_count );
+	}
+	daw::sharded_counter counter{};
+	constexpr size_t const reads = 1U << 20U;
+	int64_t sum = 0;
+	auto const t_exact = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < reads; ++n ) {
+			sum += counter.load( );
+		}
+	} );
+	auto const t_approx = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < reads; ++n ) {
+			sum += counter.load_approx( );
+		}
+	} );
+	daw::do_not_optimize( sum );
+	std::cout << "load with " << counter.shard_count( ) << " shards: "
+	          << daw::utility::format_seconds(
+	               t_exact / static_cast<double>( reads ), 2 )
+	          << ", load_approx: "
+	          << daw::utility::format_seconds(
+	               t_approx / static_cast<double>( reads ), 2 )
+	          << '\n';
+}
+
+int main( ) {
+	sharded_counter_001( );
+	sharded_counter_002( );
+	sharded_counter_003( );
+	sharded_extremum_001( );
+	sharded_accumulator_001( );
+	sharded_counter_bench( );
+}
@@ -20,7 +20,12 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <cstddef>
+#include <iostream>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "daw/daw_benchmark.h"
 #include "daw/parallel/daw_spin_lock.h"
@@ -30,6 +35,86 @@ void daw_spin_lock_001( ) {
 	std::lock_guard<daw::spin_lock> mut{sp};
 }
 
+void daw_adaptive_spin_lock_001( ) {
+	daw::adaptive_spin_lock sp{};
+	daw::expecting( sp.try_lock( ) );
+	daw::expecting( not sp.try_lock( ) );
+	sp.unlock( );
+	std::lock_guard<daw::adaptive_spin_lock> lck{sp};
+	daw::expecting( 0U, sp.stats( ).contended );
+}
+
+// Long holds force waiters past the spin budget and into the kernel
+void daw_adaptive_spin_lock_002( ) {
+	daw::basic_adaptive_spin_lock<64> sp{};
+	size_t count = 0;
+	std::vector<std::thread> threads{};
+	for( size_t t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&]( ) {
+			for( size_t n = 0; n < 1000; ++n ) {
+				std::lock_guard<daw::basic_adaptive_spin_lock<64>> lck{sp};
+				++count;
+				if( n % 100 == 0 ) {
+					std::this_thread::yield( );
+				}
+			}
+		} );
+	}
+	for( auto &th : threads ) {
+		th.join( );
+	}
+	daw::expecting( 4000U, count );
+	auto const stats = sp.stats( );
+	std::cout << "contended: " << stats.contended << " spins: " << stats.spins
+	          << " parks: " << stats.parks << '\n';
+}
+
+template<typename Lock>
+void bench_lock( std::string const &title, size_t thread_count,
+                 size_t work ) {
+	constexpr size_t const total_ops = 1U << 18U;
+	size_t const ops_per_thread = total_ops / thread_count;
+	Lock lock{};
+	size_t shared = 0;
+	auto const elapsed = daw::benchmark( [&]( ) {
+		std::vector<std::thread> threads{};
+		for( size_t t = 0; t < thread_count; ++t ) {
+			threads.emplace_back( [&]( ) {
+				for( size_t n = 0; n < ops_per_thread; ++n ) {
+					std::lock_guard<Lock> lck{lock};
+					// Critical section of roughly work dependent operations
+					for( size_t w = 0; w < work; ++w ) {
+						shared = shared * 31U + w;
+					}
+					++shared;
+				}
+			} );
+		}
+		for( auto &th : threads ) {
+			th.join( );
+		}
+	} );
+	daw::do_not_optimize( shared );
+	std::cout << title << " threads: " << thread_count << " work: " << work
+	          << " -> "
+	          << static_cast<size_t>( static_cast<double>( total_ops ) / elapsed )
+	          << " locks/s\n";
+}
+
+void spin_lock_bench( ) {
+	for( size_t work : {1U, 100U} ) {
+		for( size_t thread_count = 1; thread_count <= 8; thread_count *= 2 ) {
+			bench_lock<std::mutex>( "std::mutex", thread_count, work );
+			bench_lock<daw::spin_lock>( "spin_lock", thread_count, work );
+			bench_lock<daw::adaptive_spin_lock>( "adaptive_spin_lock",
+			                                     thread_count, work );
+		}
+	}
+}
+
 int main( ) {
 	daw_spin_lock_001( );
+	daw_adaptive_spin_lock_001( );
+	daw_adaptive_spin_lock_002( );
+	spin_lock_bench( );
 }
@@ -0,0 +1,252 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "daw/daw_benchmark.h"
+#include "daw/parallel/concurrent_queue.h"
+#include "daw/parallel/daw_timer_wheel.h"
+
+namespace {
+	using namespace std::chrono_literals;
+	using steady_clock_t = std::chrono::steady_clock;
+	auto const start = steady_clock_t::time_point( ) + 1h;
+} // namespace
+
+void timer_wheel_001( ) {
+	// Deadlines in each level fire on the first advance that reaches them
+	daw::timer_wheel wheel( 1ms, start );
+	std::vector<size_t> fired{};
+	std::vector<std::chrono::milliseconds> const delays = {
+	  0ms, 1ms, 5ms, 255ms, 256ms, 300ms, 70'000ms, 20'000'000ms};
+	for( size_t n = 0; n < delays.size( ); ++n ) {
+		wheel.schedule_at( start + delays[n],
+		                   [&fired, n] { fired.push_back( n ); } );
+	}
+	daw::expecting( delays.size( ), wheel.size( ) );
+	for( size_t n = 0; n < delays.size( ); ++n ) {
+		if( delays[n] > 0ms ) {
+			wheel.advance( start + delays[n] - 1ms );
+			daw::expecting( n, fired.size( ) );
+		}
+		daw::expecting( 1U, wheel.advance( start + delays[n] ) );
+		daw::expecting( n + 1, fired.size( ) );
+		daw::expecting( n, fired.back( ) );
+	}
+	daw::expecting( 0U, wheel.size( ) );
+}
+
+void timer_wheel_002( ) {
+	// Past the top level, deadlines in between ticks and late advances
+	daw::timer_wheel wheel( 1ms, start );
+	size_t fired = 0;
+	auto const far = start + std::chrono::hours( 24 * 60 );
+	wheel.schedule_at( far, [&] { ++fired; } );
+	wheel.schedule_at( start + 1500us, [&] { ++fired; } );
+	daw::expecting( 0U, wheel.advance( start + 1ms ) );
+	daw::expecting( 1U, wheel.advance( start + 2ms ) );
+	daw::expecting( 0U, wheel.advance( far - 1ms ) );
+	daw::expecting( 1U, wheel.advance( far + 1h ) );
+	daw::expecting( 2U, fired );
+
+	// Already due, so it waits for the next tick
+	wheel.schedule_at( start, [&] { ++fired; } );
+	daw::expecting( 0U, wheel.advance( far + 1h ) );
+	daw::expecting( 1U, wheel.advance( far + 1h + 1ms ) );
+	daw::expecting( 3U, fired );
+}
+
+void timer_wheel_003( ) {
+	daw::timer_wheel wheel( 1ms, start );
+	size_t fired = 0;
+	auto const a = wheel.schedule_at( start + 10ms, [&] { ++fired; } );
+	auto const b = wheel.schedule_at( start + 10ms, [&] { ++fired; } );
+	auto const c = wheel.schedule_at( start + 1000ms, [&] { ++fired; } );
+	daw::expecting( true, wheel.cancel( b ) );
+	daw::expecting( false, wheel.cancel( b ) );
+	daw::expecting( true, wheel.cancel( c ) );
+	daw::expecting( false, wheel.cancel( daw::timer_wheel::timer_id{} ) );
+	daw::expecting( 1U, wheel.size( ) );
+	daw::expecting( 1U, wheel.advance( start + 2000ms ) );
+	daw::expecting( 1U, fired );
+	daw::expecting( false, wheel.cancel( a ) );
+
+	// A reused slot does not answer to an old id
+	auto const d = wheel.schedule_at( start + 3000ms, [&] { ++fired; } );
+	daw::expecting( false, wheel.cancel( a ) );
+	daw::expecting( true, wheel.cancel( d ) );
+}
+
+void timer_wheel_004( ) {
+	// Callbacks may schedule more timers, which fire on a later advance
+	daw::timer_wheel wheel( 1ms, start );
+	size_t fired = 0;
+	std::function<void( )> again = [&] {
+		if( ++fired < 3 ) {
+			wheel.schedule_at( start, again );
+		}
+	};
+	wheel.schedule_at( start + 1ms, again );
+	for( size_t n = 1; n <= 3; ++n ) {
+		auto const now = start + std::chrono::milliseconds( n );
+		daw::expecting( 1U, wheel.advance( now ) );
+		daw::expecting( n, fired );
+	}
+	daw::expecting( 0U, wheel.size( ) );
+}
+
+void timer_wheel_005( ) {
+	daw::concurrent_queue<daw::timer_wheel::callback_t> queue{};
+	daw::timer_wheel wheel( queue, 1ms, start );
+	std::atomic<size_t> fired = 0;
+	for( size_t n = 0; n < 100; ++n ) {
+		wheel.schedule_at( start + 5ms, [&] { ++fired; } );
+	}
+	daw::expecting( 100U, wheel.advance( start + 5ms ) );
+	daw::expecting( 0U, fired.load( ) );
+
+	std::vector<std::thread> workers{};
+	for( size_t t = 0; t < 4; ++t ) {
+		workers.emplace_back( [&] {
+			daw::timer_wheel::callback_t cb{};
+			while( queue.try_pop( cb ) ) {
+				cb( );
+			}
+		} );
+	}
+	for( auto &t : workers ) {
+		t.join( );
+	}
+	daw::expecting( 100U, fired.load( ) );
+}
+
+void timer_wheel_006( ) {
+	// The ticking thread drives real time
+	daw::timer_wheel wheel( 1ms );
+	std::atomic<bool> fired = false;
+	auto const scheduled = steady_clock_t::now( );
+	std::atomic<steady_clock_t::time_point::rep> fired_at = 0;
+	wheel.schedule_after( 20ms, [&] {
+		fired_at = steady_clock_t::now( ).time_since_epoch( ).count( );
+		fired = true;
+	} );
+	wheel.start_ticking( );
+	for( size_t n = 0; n < 500 and not fired; ++n ) {
+		std::this_thread::sleep_for( 10ms );
+	}
+	wheel.stop_ticking( );
+	daw::expecting( true, fired.load( ) );
+	daw::expecting( true, steady_clock_t::time_point( steady_clock_t::duration(
+	                        fired_at.load( ) ) ) >= scheduled + 20ms );
+}
+
+void timer_wheel_007( ) {
+	// Schedule and cancel from several threads while another advances
+	daw::timer_wheel wheel( 1ms, start );
+	std::atomic<size_t> fired = 0;
+	std::atomic<size_t> cancelled = 0;
+	std::atomic<bool> done = false;
+	constexpr size_t const per_thread = 20'000;
+	std::thread advancer( [&] {
+		auto now = start;
+		while( not done ) {
+			now += 1ms;
+			wheel.advance( now );
+		}
+		wheel.advance( now + 1h );
+	} );
+	std::vector<std::thread> threads{};
+	for( size_t t = 0; t < 4; ++t ) {
+		threads.emplace_back( [&, t] {
+			std::mt19937_64 rng( t );
+			for( size_t n = 0; n < per_thread; ++n ) {
+				auto const deadline =
+				  start + std::chrono::milliseconds( rng( ) % 5000 );
+				auto const id = wheel.schedule_at( deadline, [&] { ++fired; } );
+				if( rng( ) % 2 == 0 and wheel.cancel( id ) ) {
+					++cancelled;
+				}
+			}
+		} );
+	}
+	for( auto &t : threads ) {
+		t.join( );
+	}
+	done = true;
+	advancer.join( );
+	daw::expecting( 0U, wheel.size( ) );
+	daw::expecting( 4 * per_thread, fired.load( ) + cancelled.load( ) );
+}
+
+void timer_wheel_bench( ) {
+	constexpr size_t const count = 1U << 18U;
+	daw::timer_wheel wheel( 1ms, start );
+	std::vector<daw::timer_wheel::timer_id> ids( count );
+	std::mt19937_64 rng( 1 );
+	std::vector<std::chrono::milliseconds> delays( count );
+	for( auto &d : delays ) {
+		d = std::chrono::milliseconds( rng( ) % 60'000 );
+	}
+	size_t fired = 0;
+	auto const t_schedule = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; ++n ) {
+			ids[n] = wheel.schedule_at( start + delays[n], [&fired] { ++fired; } );
+		}
+	} );
+	auto const t_cancel = daw::benchmark( [&]( ) {
+		for( size_t n = 0; n < count; n += 2 ) {
+			wheel.cancel( ids[n] );
+		}
+	} );
+	auto const t_expire = daw::benchmark( [&]( ) {
+		for( auto now = start; now <= start + 60'000ms; now += 1ms ) {
+			wheel.advance( now );
+		}
+	} );
+	daw::expecting( count / 2, fired );
+	std::cout << "timer_wheel schedule: "
+	          << daw::utility::format_seconds( t_schedule / count, 2 )
+	          << ", cancel: "
+	          << daw::utility::format_seconds( t_cancel / ( count / 2 ), 2 )
+	          << ", expire over 60000 ticks: "
+	          << daw::utility::format_seconds( t_expire / ( count / 2 ), 2 )
+	          << " per timer\n";
+}
+
+int main( ) {
+	timer_wheel_001( );
+	timer_wheel_002( );
+	timer_wheel_003( );
+	timer_wheel_004( );
+	timer_wheel_005( );
+	timer_wheel_006( );
+	timer_wheel_007( );
+	timer_wheel_bench( );
+}
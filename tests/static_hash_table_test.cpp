@@ -0,0 +1,54 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2019 Darrell Wright
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files( the "Software" ), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and / or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <iostream>
+
+#include "daw/daw_benchmark.h"
+#include "daw/static_hash_table.h"
+
+void static_hash_table_001( ) {
+	daw::static_hash_t<int, 100> table{};
+	table["hello"] = 5;
+	table["world"] = 6;
+	auto const &ctable = table;
+	daw::expecting( 5, ctable["hello"] );
+	daw::expecting( 6, ctable["world"] );
+}
+
+void static_hash_table_stats_001( ) {
+	daw::static_hash_t<int, 64> table{};
+	for( int n = 0; n < 48; ++n ) {
+		table[n] = n;
+	}
+	auto const stats = table.stats( );
+	daw::expecting( 64U, stats.capacity );
+	daw::expecting( 48U, stats.size );
+	daw::expecting( 0.75, stats.load_factor( ) );
+	daw::expecting( stats.max_displacement + 1, stats.probe_lengths.size( ) );
+	std::cout << "static_hash_t average probe length "
+	          << stats.average_probe_length( ) << '\n';
+}
+
+int main( ) {
+	static_hash_table_001( );
+	static_hash_table_stats_001( );
+}